@@ -0,0 +1,81 @@
+#include <iostream>
+#include <string>
+#include <filesystem>
+#include <liteviz/utils.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/container.h>
+#include <liteviz/octree.h>
+
+int main(int argc, char** argv) {
+
+    const char* usage = "Usage: ./liteviz-convert [input.ply] [output.lvz] [--compact | --compact-u8] [--no-compress] [--keep-order | --spatial]\n"
+                        "  --compact      fp16 attributes and SH\n"
+                        "  --compact-u8   fp16 attributes, 8-bit SH\n"
+                        "  --no-compress  store the blocks without LZ4\n"
+                        "  --keep-order   keep the file order instead of sorting by opacity x volume\n"
+                        "  --spatial      Morton order with chunk bounds, for out-of-core viewing\n";
+
+    if (argc < 3 || !SceneContainer::is_lvz(argv[2])) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    const char* ply_file = argv[1];
+    const char* lvz_file = argv[2];
+    if (!std::filesystem::exists(ply_file)) {
+        std::cerr << "File does not exist: " << ply_file << std::endl;
+        return 1;
+    }
+
+    GaussianData::Storage storage = GaussianData::FP32;
+    bool compress = true;
+    bool importance_order = true;
+    bool spatial = false;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--compact") {
+            storage = GaussianData::COMPACT_FP16;
+        } else if (arg == "--compact-u8") {
+            storage = GaussianData::COMPACT_UINT8;
+        } else if (arg == "--no-compress") {
+            compress = false;
+        } else if (arg == "--keep-order") {
+            importance_order = false;
+        } else if (arg == "--spatial") {
+            spatial = true;
+            importance_order = false;
+        } else {
+            std::cerr << usage;
+            return 1;
+        }
+    }
+
+    Timer timer;
+    GaussianData data = GaussianData::load_ply(ply_file, 3, storage);
+    timer.printElapsed("Loaded " + std::to_string(data.size()) + " splats in ");
+
+    // most important splats first, so progressive loading shows a usable
+    // scene after the first chunks
+    if (importance_order) {
+        timer.reset();
+        data.reorder(data.importanceOrder());
+        timer.printElapsed("Sorted by importance in ");
+    }
+
+    // neighbours in the same chunks, so that a chunk covers a small region
+    if (spatial) {
+        timer.reset();
+        SplatOctree octree(data);
+        data.reorder(octree.order());
+        timer.printElapsed("Sorted by Morton order in ");
+    }
+
+    timer.reset();
+    SceneContainer::save(lvz_file, data, compress, SceneContainer::DEFAULT_CHUNK_SIZE,
+                         importance_order ? LVZ_IMPORTANCE_ORDER : spatial ? LVZ_SPATIAL : 0);
+    timer.printElapsed("Wrote " + std::string(lvz_file) + " in ");
+
+    std::cout << "Size: " << std::filesystem::file_size(ply_file) / (1 << 20) << " MB -> "
+              << std::filesystem::file_size(lvz_file) / (1 << 20) << " MB" << std::endl;
+    return 0;
+}
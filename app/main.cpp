@@ -1,9 +1,18 @@
 #include <liteviz/viewer.h>
 #include <liteviz/dataloader.h>
+#include <liteviz/container.h>
+#include <liteviz/progressive.h>
+#include <liteviz/lod.h>
+#include <liteviz/pager.h>
 
 int main(int argc, char** argv) {
 
-    const char* usage = "Usage: ./liteviz [path_to_ply_file]\n";
+    const char* usage = "Usage: ./liteviz [path_to_ply_or_lvz_file] [--compact | --compact-u8] [--progressive | --lod | --out-of-core MB]\n"
+                        "  --compact      fp16 attributes and SH\n"
+                        "  --compact-u8   fp16 attributes, 8-bit SH\n"
+                        "  --progressive  draw while the scene is still loading\n"
+                        "  --lod          build levels of detail and draw a cut of them\n"
+                        "  --out-of-core  page a --spatial .lvz through MB of splat memory\n";
 
     if (argc < 2) {
         std::cerr << usage;
@@ -16,11 +25,67 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    std::cout << "Loading Gaussian data from: " << ply_file << std::endl;
+    GaussianData::Storage storage = GaussianData::FP32;
+    bool progressive = false;
+    bool lod = false;
+    size_t out_of_core = 0;    // MB
+    for (int i = 2; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--compact") {
+            storage = GaussianData::COMPACT_FP16;
+        } else if (arg == "--compact-u8") {
+            storage = GaussianData::COMPACT_UINT8;
+        } else if (arg == "--progressive") {
+            progressive = true;
+        } else if (arg == "--lod") {
+            lod = true;
+        } else if (arg == "--out-of-core" && i + 1 < argc) {
+            out_of_core = std::stoul(argv[++i]);
+        } else {
+            std::cerr << usage;
+            return 1;
+        }
+    }
 
-    GaussianData data = GaussianData::load_ply(ply_file);
+    std::cout << "Loading Gaussian data from: " << ply_file << std::endl;
 
     std::shared_ptr<LiteViewer> viewer = std::make_shared<LiteViewer>("LiteViz-GS", 1280, 720);
 
+    if (progressive && lod) {
+        std::cerr << "--lod needs the whole scene, it does not combine with --progressive" << std::endl;
+        return 1;
+    }
+
+    if (out_of_core > 0) {
+        if (!SceneContainer::is_lvz(ply_file) || progressive || lod) {
+            std::cerr << "--out-of-core needs a .lvz file and no --progressive or --lod" << std::endl;
+            return 1;
+        }
+        ChunkPager pager(ply_file, out_of_core << 20);
+        std::cout << "Paging " << pager.sceneSize() << " splats through " << pager.stats().slots << " of "
+                  << pager.stats().chunks << " chunks" << std::endl;
+        viewer->draw(pager);
+        return 0;
+    }
+
+    if (progressive) {
+        ProgressiveLoader loader(ply_file, 3, storage);
+        viewer->draw(loader.data(), &loader);
+        return 0;
+    }
+
+    // .lvz files carry their own storage format
+    GaussianData data = SceneContainer::is_lvz(ply_file) ? SceneContainer::load(ply_file)
+                                                         : GaussianData::load_ply(ply_file, 3, storage);
+
+    if (lod) {
+        Timer timer;
+        SplatLOD levels(data);
+        std::cout << "Built levels of detail: " << levels.parents().size() << " merged splats in "
+                  << timer.elapsed() * 1e3 << " ms" << std::endl;
+        viewer->draw(data, nullptr, &levels);
+        return 0;
+    }
+
     viewer->draw(data);
 }
@@ -0,0 +1,197 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <liteviz/headless.h>
+#include <liteviz/renderer.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/container.h>
+#include <liteviz/capture.h>
+
+// Camera poses, one per line: the 12 or 16 numbers of a camera-to-world
+// matrix in row-major order, the last row (0 0 0 1) optional. Blank lines
+// and lines starting with # are skipped.
+static bool read_poses(const char* file, bool opencv, std::vector<Eigen::Matrix4f>& poses) {
+    std::ifstream in(file);
+    if (!in) {
+        std::cerr << "Failed to open " << file << std::endl;
+        return false;
+    }
+    // OpenCV cameras look down +z with y down, the OpenGL camera down -z with y up
+    const Eigen::Matrix4f flip = Eigen::Vector4f(1.0f, -1.0f, -1.0f, 1.0f).asDiagonal();
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::vector<float> v;
+        for (float x; fields >> x; ) v.push_back(x);
+        if (v.empty()) continue;
+        if (v.size() != 12 && v.size() != 16) {
+            std::cerr << file << ":" << number << ": expected 12 or 16 numbers, got " << v.size() << std::endl;
+            return false;
+        }
+        Eigen::Matrix4f pose = Eigen::Matrix4f::Identity();
+        for (size_t k = 0; k < v.size(); ++k) pose(k / 4, k % 4) = v[k];
+        poses.push_back(opencv ? Eigen::Matrix4f(pose * flip) : pose);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+
+    const char* usage = "Usage: ./liteviz-render [path_to_ply_or_lvz_file] [poses.txt] [output_dir] [options]\n"
+                        "  --size W H       image size (default 1280 720)\n"
+                        "  --fov DEG        vertical field of view (default 60)\n"
+                        "  --opencv         poses are OpenCV cameras (+z forward, y down)\n"
+                        "  --mode MODE      sh0 | sh1 | sh2 | sh3 | depth | ball (default sh3)\n"
+                        "  --format EXT     png | ppm (default png)\n"
+                        "  --threads N      encoder threads (default 2)\n"
+                        "  --compact        fp16 attributes and SH\n"
+                        "  --compact-u8     fp16 attributes, 8-bit SH\n"
+                        "  --tiles          blend in 16x16 tiles with compute shaders instead of quads\n"
+                        "  --gpu-sort       depth-sort in compute shaders instead of on the CPU\n"
+                        "poses.txt holds one camera-to-world matrix per line, 12 or 16 numbers in row-major order\n";
+
+    if (argc < 4) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    const char* scene_file = argv[1];
+    const char* pose_file = argv[2];
+    const std::string out_dir = argv[3];
+    if (!std::filesystem::exists(scene_file)) {
+        std::cerr << "File does not exist: " << scene_file << std::endl;
+        return 1;
+    }
+
+    int width = 1280, height = 720;
+    float fov = 60.0f;
+    bool opencv = false;
+    std::string format = "png";
+    int threads = 2;
+    RenderConfig::RenderMode mode = RenderConfig::COLOR_SH_3;
+    GaussianData::Storage storage = GaussianData::FP32;
+    bool tiles = false;
+    bool gpu_sort = false;
+    const std::pair<std::string, RenderConfig::RenderMode> modes[] = {
+        { "sh0", RenderConfig::COLOR_SH_0 }, { "sh1", RenderConfig::COLOR_SH_1 },
+        { "sh2", RenderConfig::COLOR_SH_2 }, { "sh3", RenderConfig::COLOR_SH_3 },
+        { "depth", RenderConfig::DEPTH },    { "ball", RenderConfig::GAUSS_BALL },
+    };
+    for (int i = 4; i < argc; ++i) {
+        std::string arg(argv[i]);
+        bool known = true;
+        if (arg == "--size" && i + 2 < argc) {
+            width = std::stoi(argv[++i]);
+            height = std::stoi(argv[++i]);
+        } else if (arg == "--fov" && i + 1 < argc) {
+            fov = std::stof(argv[++i]);
+        } else if (arg == "--opencv") {
+            opencv = true;
+        } else if (arg == "--mode" && i + 1 < argc) {
+            known = false;
+            for (const auto& m : modes) {
+                if (m.first == argv[i + 1]) {
+                    mode = m.second;
+                    known = true;
+                }
+            }
+            ++i;
+        } else if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+            known = format == "png" || format == "ppm";
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::stoi(argv[++i]);
+        } else if (arg == "--compact") {
+            storage = GaussianData::COMPACT_FP16;
+        } else if (arg == "--compact-u8") {
+            storage = GaussianData::COMPACT_UINT8;
+        } else if (arg == "--tiles") {
+            tiles = true;
+        } else if (arg == "--gpu-sort") {
+            gpu_sort = true;
+        } else {
+            known = false;
+        }
+        if (!known) {
+            std::cerr << usage;
+            return 1;
+        }
+    }
+
+    std::vector<Eigen::Matrix4f> poses;
+    if (!read_poses(pose_file, opencv, poses)) return 1;
+    std::filesystem::create_directories(out_dir);
+
+    HeadlessContext context;
+    if (!context.init()) {
+        std::cerr << "Failed to init the offscreen context" << std::endl;
+        return 1;
+    }
+    std::cout << "OpenGL " << glGetString(GL_VERSION) << " on " << glGetString(GL_RENDERER) << std::endl;
+
+    std::cout << "Loading Gaussian data from: " << scene_file << std::endl;
+    GaussianData data = SceneContainer::is_lvz(scene_file) ? SceneContainer::load(scene_file)
+                                                           : GaussianData::load_ply(scene_file, 3, storage);
+
+    std::string shader_path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+    Shader shader((shader_path + "/draw_splat.vert").c_str(), (shader_path + "/draw_splat.frag").c_str(), false,
+                  Renderer::shaderDefines(data));
+    Renderer renderer(data, &shader);
+    RenderConfig& config = renderer.config();
+    config.render_mode = mode;
+    config.fov = fov;
+    // every frame sorted for its own camera, and colors not carried over from the previous pose
+    config.async_sort = false;
+    config.color_cache = false;
+    config.tile_render = tiles;
+    config.gpu_sort = gpu_sort;
+
+    OffscreenTarget target(width, height);
+    Viewport viewport(width, height);
+    viewport.frameBufferSize = Eigen::Vector2i(width, height);
+    viewport.setFoV(fov);
+
+    // frame N is read back while frames N+1 and N+2 render
+    FrameCapture capture(threads);
+    const Eigen::Vector4f clear_color(0.0f, 0.0f, 0.0f, 0.0f);
+    Renderer::Timings total;
+    double readback = 0.0;    // queueing the readback, and waiting for the GPU when the ring is full
+
+    Timer timer;
+    for (size_t f = 0; f < poses.size(); ++f) {
+        viewport.setViewMatrix(poses[f]);
+        target.bind();
+        glClearBufferfv(GL_COLOR, 0, clear_color.data());
+
+        renderer.render(viewport);
+        total.sort += renderer.timings().sort;
+        total.upload += renderer.timings().upload;
+        total.draw += renderer.timings().draw;
+
+        Timer stage;
+        std::ostringstream name;
+        name << out_dir << "/" << std::setw(5) << std::setfill('0') << f << "." << format;
+        capture.capture(width, height, name.str());
+        capture.poll();
+        readback += stage.elapsed();
+    }
+    capture.flush();
+    const double wall = timer.elapsed();
+
+    const ImageWriter::Stats stats = capture.writerStats();
+    const double n = std::max<size_t>(poses.size(), 1);
+    std::cout << std::fixed << std::setprecision(2)
+              << "Rendered " << poses.size() << " frames of " << width << " x " << height << " in " << wall << " s ("
+              << poses.size() / wall << " fps), " << stats.written << " written, " << stats.failed << " failed\n"
+              << "ms per frame: sort " << total.sort / n * 1e3 << ", upload " << total.upload / n * 1e3
+              << ", draw " << total.draw / n * 1e3
+              << ", readback " << readback / n * 1e3 << " (" << capture.stats().map / n * 1e3 << " mapping, "
+              << capture.stats().stalls << " ring stalls), encode " << stats.encode / n * 1e3
+              << " on " << threads << " threads" << std::endl;
+    return stats.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <liteviz/dataloader.h>
+#include "bench_common.h"
+
+// Replays camera paths through CoherentSorter and a full DepthSorter per frame.
+// A recorded path can be passed as a text file with one row-major 4x4 view
+// matrix (16 floats) per line.
+
+struct CameraPath {
+    std::string name;
+    std::vector<Eigen::Matrix4f> views;
+};
+
+static CameraPath orbit_path(const std::string& name, float deg_per_frame, int frames, int pause_every = 0) {
+    CameraPath path{ name, {} };
+    float azimuth = 0.0f;
+    for (int f = 0; f < frames; ++f) {
+        bool paused = pause_every > 0 && (f / pause_every) % 2 == 1;
+        if (!paused) azimuth += deg_per_frame * float(M_PI) / 180.0f;
+        path.views.push_back(orbit_view(azimuth));
+    }
+    return path;
+}
+
+static bool load_path(const char* filename, CameraPath& path) {
+    std::ifstream file(filename);
+    if (!file.is_open()) return false;
+    path.name = filename;
+    Eigen::Matrix<float, 4, 4, Eigen::RowMajor> m;
+    while (true) {
+        for (int i = 0; i < 16; ++i) file >> m.data()[i];
+        if (!file) break;
+        path.views.push_back(m);
+    }
+    return !path.views.empty();
+}
+
+// Replays every path over a scene of N splats; a full sort and the refine
+// pass cost about the same once a turn past skip_angle shifts splats by a
+// few ranks, so without N both a small and a large scene are run.
+static bool replay(size_t N, const std::vector<CameraPath>& paths) {
+
+    GaussianData::Positions xyz = random_xyz(N);
+
+    printf("N = %zu\n", N);
+    printf("%-24s %10s %10s %8s %8s %8s\n", "path", "full(ms)", "coh.(ms)", "skip", "refine", "full");
+
+    for (const CameraPath& path : paths) {
+        DepthSorter full_sorter;
+        std::vector<uint32_t> full_index;
+        Timer timer;
+        for (const Eigen::Matrix4f& view : path.views) {
+            full_sorter.sort(xyz, view, full_index);
+        }
+        double t_full = timer.elapsed() / path.views.size();
+
+        CoherentSorter coherent;
+        std::vector<uint32_t> index;
+        timer.reset();
+        for (const Eigen::Matrix4f& view : path.views) {
+            coherent.sort(xyz, view, index);
+        }
+        double t_coherent = timer.elapsed() / path.views.size();
+
+        // the kept order must agree with the last pose up to what the skip tolerance allows
+        const float diameter = 2.0f * std::sqrt(3.0f) * 10.0f;
+        const float tol = diameter * coherent.skip_angle + 1e-3f;
+        std::vector<float> depths;
+        DepthSorter::viewDepths(xyz, path.views.back(), depths);
+        for (size_t i = 1; i < N; ++i) {
+            if (depths[index[i - 1]] > depths[index[i]] + tol) {
+                fprintf(stderr, "%s: coherent order is not sorted\n", path.name.c_str());
+                return false;
+            }
+        }
+
+        const CoherentSorter::Stats& stats = coherent.stats();
+        printf("%-24s %10.2f %10.2f %8zu %8zu %8zu\n", path.name.c_str(),
+            t_full * 1e3, t_coherent * 1e3, stats.skipped, stats.refined, stats.full);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+
+    std::vector<size_t> sizes = { 20000, 1000000 };
+    if (argc > 1) sizes = { std::stoul(argv[1]) };
+
+    std::vector<CameraPath> paths = {
+        orbit_path("orbit 0.001deg/frame", 0.001f, 300),
+        orbit_path("orbit 0.02deg/frame", 0.02f, 300),
+        orbit_path("orbit 0.05deg/frame", 0.05f, 300),
+        orbit_path("orbit 0.5deg/frame", 0.5f, 300),
+        orbit_path("orbit 5deg/frame", 5.0f, 300),
+        orbit_path("orbit 0.5deg + pauses", 0.5f, 300, 30),
+    };
+    if (argc > 2) {
+        CameraPath recorded;
+        if (!load_path(argv[2], recorded)) {
+            fprintf(stderr, "Failed to read camera path: %s\n", argv[2]);
+            return 1;
+        }
+        paths.push_back(recorded);
+    }
+
+    for (size_t N : sizes) {
+        if (!replay(N, paths)) return 1;
+    }
+    return 0;
+}
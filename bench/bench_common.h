@@ -0,0 +1,186 @@
+#ifndef __BENCH_COMMON_H__
+#define __BENCH_COMMON_H__
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include <Eigen/Dense>
+#include <fcntl.h>
+#include <unistd.h>
+#include <liteviz/utils.h>
+#include <liteviz/dataloader.h>
+
+// Median wall time (seconds) over a number of repetitions after one warm-up run.
+inline double bench_median(const std::function<void()>& fn, int reps = 5) {
+    fn();
+    std::vector<double> times;
+    for (int i = 0; i < reps; ++i) {
+        Timer timer;
+        fn();
+        times.push_back(timer.elapsed());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// Uniformly scattered splat centers in a [-extent, extent]^3 box.
+inline GaussianData::Positions random_xyz(size_t N, float extent = 10.0f, unsigned seed = 42) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-extent, extent);
+    GaussianData::Positions xyz(N, 3);
+    for (size_t i = 0; i < N; ++i) {
+        xyz(i, 0) = dist(rng);
+        xyz(i, 1) = dist(rng);
+        xyz(i, 2) = dist(rng);
+    }
+    return xyz;
+}
+
+// View matrix of a camera at eye looking at target, z up. Looks down +z;
+// multiply by diag(1, -1, -1, 1) for the OpenGL view.
+inline Eigen::Matrix4f look_view(const Eigen::Vector3f& eye, const Eigen::Vector3f& target) {
+    Eigen::Vector3f zAxis = (target - eye).normalized();
+    Eigen::Vector3f xAxis = Eigen::Vector3f::UnitZ().cross(zAxis).normalized();
+    Eigen::Vector3f yAxis = zAxis.cross(xAxis).normalized();
+
+    Eigen::Matrix4f transform = Eigen::Matrix4f::Identity();
+    transform.block<3, 1>(0, 0) = xAxis;
+    transform.block<3, 1>(0, 1) = yAxis;
+    transform.block<3, 1>(0, 2) = zAxis;
+    transform.block<3, 1>(0, 3) = eye;
+    return transform.inverse();
+}
+
+// View matrix of a camera orbiting the origin at the given azimuth (radians).
+inline Eigen::Matrix4f orbit_view(float azimuth, float radius = 30.0f, float height = 5.0f) {
+    return look_view(Eigen::Vector3f(radius * std::cos(azimuth), radius * std::sin(azimuth), height),
+                     Eigen::Vector3f::Zero());
+}
+
+// Scripted camera paths over the [-10, 10]^3 scenes of write_scene_ply(),
+// as OpenGL view matrices, the same for every run:
+//   orbit  one degree per frame around the scene
+//   fly    a straight pass through the scene along x
+//   zoom   from far outside to the center
+enum class CameraScript { ORBIT, FLY, ZOOM };
+
+inline std::vector<Eigen::Matrix4f> camera_script(CameraScript path, int frames) {
+    const Eigen::Matrix4f gl_flip = Eigen::Vector4f(1.0f, -1.0f, -1.0f, 1.0f).asDiagonal();
+    std::vector<Eigen::Matrix4f> views;
+    for (int f = 0; f < frames; ++f) {
+        const float s = frames > 1 ? float(f) / (frames - 1) : 0.0f;
+        Eigen::Matrix4f view;
+        if (path == CameraScript::ORBIT) {
+            view = orbit_view(f * float(M_PI) / 180.0f, 30.0f, 5.0f);
+        } else if (path == CameraScript::FLY) {
+            const Eigen::Vector3f eye(-30.0f + 50.0f * s, 1.0f, 1.0f);
+            view = look_view(eye, eye + Eigen::Vector3f(10.0f, 0.5f, 0.0f));
+        } else {
+            const Eigen::Vector3f dir = Eigen::Vector3f(1.0f, 0.6f, 0.3f).normalized();
+            view = look_view((40.0f - 39.0f * s) * dir, Eigen::Vector3f::Zero());
+        }
+        views.push_back(gl_flip * view);
+    }
+    return views;
+}
+
+// OpenGL projection as built by Viewport::getProjectionMatrix().
+inline Eigen::Matrix4f perspective(float fov_degrees, float aspect, float znear = 0.1f, float zfar = 100.0f) {
+    const float tan_half = std::tan(fov_degrees / 180.0f * float(M_PI) / 2.0f);
+    Eigen::Matrix4f projmat = Eigen::Matrix4f::Zero();
+    projmat(0, 0) = 1.0f / (aspect * tan_half);
+    projmat(1, 1) = 1.0f / tan_half;
+    projmat(2, 2) = -(zfar + znear) / (zfar - znear);
+    projmat(2, 3) = -(2.0f * zfar * znear) / (zfar - znear);
+    projmat(3, 2) = -1.0f;
+    return projmat;
+}
+
+// Where write_scene_ply() puts the splat centers, all within [-10, 10]^3:
+//   UNIFORM    scattered through the box
+//   CLUSTERED  normal blobs of a few hundred splats around 1024 centers
+//   SURFACE    on a sphere of radius 8, flattened along its normal like
+//              splats of a reconstructed surface
+enum class SceneLayout { UNIFORM, CLUSTERED, SURFACE };
+
+// Writes a random 3DGS-style PLY (binary little endian, pre-activation values)
+// with N splats of the given SH degree and layout.
+inline void write_scene_ply(const std::string& filename, size_t N, int sh_degree = 3,
+                            SceneLayout layout = SceneLayout::UNIFORM, unsigned seed = 7) {
+
+    const int rest = 3 * ((sh_degree + 1) * (sh_degree + 1) - 1);
+
+    std::vector<std::string> props = { "x", "y", "z", "nx", "ny", "nz", "f_dc_0", "f_dc_1", "f_dc_2" };
+    for (int i = 0; i < rest; ++i) props.push_back("f_rest_" + std::to_string(i));
+    props.push_back("opacity");
+    for (int i = 0; i < 3; ++i) props.push_back("scale_" + std::to_string(i));
+    for (int i = 0; i < 4; ++i) props.push_back("rot_" + std::to_string(i));
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to create file: " + filename);
+    }
+    file << "ply\nformat binary_little_endian 1.0\nelement vertex " << N << "\n";
+    for (const std::string& p : props) file << "property float " << p << "\n";
+    file << "end_header\n";
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> pos(-10.0f, 10.0f);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::vector<float> record(props.size());
+
+    std::vector<Eigen::Vector3f> clusters(layout == SceneLayout::CLUSTERED ? 1024 : 0);
+    for (Eigen::Vector3f& c : clusters) c = Eigen::Vector3f(pos(rng), pos(rng), pos(rng)) * 0.9f;
+
+    for (size_t i = 0; i < N; ++i) {
+        size_t k = 0;
+        Eigen::Vector3f center;
+        if (layout == SceneLayout::UNIFORM) {
+            for (int j = 0; j < 3; ++j) center[j] = pos(rng);
+        } else if (layout == SceneLayout::CLUSTERED) {
+            const Eigen::Vector3f& c = clusters[rng() % clusters.size()];
+            for (int j = 0; j < 3; ++j) center[j] = c[j] + 0.3f * normal(rng);
+        } else {
+            for (int j = 0; j < 3; ++j) center[j] = normal(rng);
+            center = 8.0f * center.normalized();
+        }
+        for (int j = 0; j < 3; ++j) record[k++] = std::min(10.0f, std::max(-10.0f, center[j]));
+        for (int j = 0; j < 3; ++j) record[k++] = 0.0f;
+        for (int j = 0; j < 3 + rest; ++j) record[k++] = 0.5f * normal(rng);
+        record[k++] = normal(rng);
+        for (int j = 0; j < 3; ++j) record[k++] = -4.0f + 0.5f * normal(rng);
+        if (layout == SceneLayout::SURFACE) {
+            // thin along z, turned so that z is the sphere normal
+            record[k - 1] -= 2.0f;
+            const Eigen::Quaternionf q = Eigen::Quaternionf::FromTwoVectors(Eigen::Vector3f::UnitZ(), center);
+            record[k++] = q.w();
+            record[k++] = q.x();
+            record[k++] = q.y();
+            record[k++] = q.z();
+        } else {
+            for (int j = 0; j < 4; ++j) record[k++] = normal(rng);
+        }
+        file.write(reinterpret_cast<const char*>(record.data()), record.size() * sizeof(float));
+    }
+}
+
+inline void write_random_ply(const std::string& filename, size_t N, int sh_degree = 3, unsigned seed = 7) {
+    write_scene_ply(filename, N, sh_degree, SceneLayout::UNIFORM, seed);
+}
+
+// Evicts a file from the page cache so the next read comes from disk. Works
+// without privileges for clean pages; returns false if the kernel refused.
+inline bool drop_page_cache(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    fdatasync(fd);
+    bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    ::close(fd);
+    return ok;
+}
+
+#endif // __BENCH_COMMON_H__
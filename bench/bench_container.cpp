@@ -0,0 +1,79 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <liteviz/dataloader.h>
+#include <liteviz/container.h>
+#include "bench_common.h"
+
+// Cold (page cache dropped) and warm load time of .lvz containers against
+// load_ply on generated scenes.
+// usage: bench-container [N ...] (default 1M, 5M, 10M splats at SH degree 3)
+
+int main(int argc, char** argv) {
+
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) sizes.push_back(std::stoul(argv[i]));
+    if (sizes.empty()) sizes = { 1000000, 5000000, 10000000 };
+
+    struct Variant {
+        const char*             name;
+        GaussianData::Storage   storage;
+        bool                    compress;
+    };
+    const Variant variants[] = {
+        { "lvz fp32 raw", GaussianData::FP32, false },
+        { "lvz fp32 lz4", GaussianData::FP32, true },
+        { "lvz fp16 lz4", GaussianData::COMPACT_FP16, true },
+        { "lvz sh-u8 lz4", GaussianData::COMPACT_UINT8, true },
+    };
+
+    printf("%10s %-14s %10s %10s %10s\n", "N", "format", "size(MB)", "cold(ms)", "warm(ms)");
+
+    for (size_t N : sizes) {
+        const std::string ply = "bench_container_" + std::to_string(N) + ".ply";
+        write_random_ply(ply, N);
+
+        auto report = [&](const char* name, const std::string& filename, const std::function<void()>& load) {
+            drop_page_cache(filename);
+            Timer timer;
+            load();
+            double cold = timer.elapsed();
+            double warm = bench_median(load, 3);
+            printf("%10zu %-14s %10.1f %10.1f %10.1f\n", N, name,
+                   double(std::filesystem::file_size(filename)) / (1 << 20), cold * 1e3, warm * 1e3);
+        };
+
+        GaussianData reference;
+        report("ply", ply, [&]() { reference = GaussianData::load_ply(ply.c_str()); });
+
+        for (const Variant& variant : variants) {
+            const std::string lvz = "bench_container_" + std::to_string(N) + ".lvz";
+            {
+                GaussianData source = GaussianData::load_ply(ply.c_str(), 3, variant.storage);
+                SceneContainer::save(lvz.c_str(), source, variant.compress);
+            }
+
+            GaussianData loaded;
+            report(variant.name, lvz, [&]() { loaded = SceneContainer::load(lvz.c_str()); });
+
+            bool same = loaded.size() == reference.size() && loaded.xyz == reference.xyz;
+            if (variant.storage == GaussianData::FP32) {
+                same = same && loaded.attributes == reference.attributes;
+            } else {
+                GaussianData quantized = reference;
+                quantized.quantize(variant.storage);
+                same = same && loaded.packed.words == quantized.packed.words && loaded.packed.sh_range == quantized.packed.sh_range;
+            }
+            if (!same) {
+                fprintf(stderr, "%s: container round trip differs for N=%zu\n", variant.name, N);
+                return 1;
+            }
+            std::remove(lvz.c_str());
+        }
+
+        std::remove(ply.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <tbb/parallel_for.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/shader.h>
+#include "bench_common.h"
+
+// Vertex stage cost of draw_splat.vert with the 3D covariance built per
+// vertex from quaternion and scale (computeCov3D) against fetched as the
+// precomputed upper triangle (PRECOMPUTED_COV3D, what Renderer uploads for
+// fp32 storage). Rasterization is discarded for the timing, so only the
+// vertex shader runs; on a software driver (LIBGL_ALWAYS_SOFTWARE=1, i.e.
+// llvmpipe) its time follows the ALU work per vertex. Also reported: the
+// bytes each variant fetches for the shape, the CPU cost of precomputing the
+// covariances, and the largest pixel difference between the two images.
+//
+// The trade-off: the covariance fills 6 of the 7 floats that quaternion and
+// scale held, so fp32 rows keep their size, and it costs a pass over the
+// splats on upload. The scale modifier needs no recompute, it scales the
+// covariance by its square in the shader. Compact storage keeps quaternion,
+// scale and opacity in 12 bytes; a covariance alone would need as much in
+// fp16, which also flushes the variance of small splats (1e-8 at a scale of
+// 1e-4) to zero.
+// usage: bench-cov3d [N | scene.ply] (default: 1M generated splats at SH degree 0)
+
+static constexpr int WIDTH = 1280, HEIGHT = 720;
+
+int main(int argc, char** argv) {
+
+    std::string filename = "bench_cov3d.ply";
+    bool generated = true;
+    size_t N = 1000000;
+
+    if (argc > 1) {
+        std::string arg(argv[1]);
+        if (arg.size() > 4 && arg.substr(arg.size() - 4) == ".ply") {
+            filename = arg;
+            generated = false;
+        } else {
+            N = std::stoul(arg);
+        }
+    }
+    if (generated) write_random_ply(filename, N, 0);
+
+    GaussianData data = GaussianData::load_ply(filename.c_str(), 3);
+    N = data.size();
+    const size_t cols = data.attributes.cols();
+    printf("%zu splats, SH dim %d\n", N, data.sh_dim());
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "bench-cov3d", nullptr, nullptr);
+    if (!window) {
+        fprintf(stderr, "Failed to create an OpenGL 4.3 context\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        fprintf(stderr, "Failed to initialize GLAD\n");
+        return 1;
+    }
+    printf("GL renderer: %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+    // the rows Renderer::uploadSplats() stages for fp32 storage
+    GaussianData::Attributes cov_rows(N, cols);
+    double t_precompute = bench_median([&]() {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, 1 << 12),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    cov_rows.row(i) = data.attributes.row(i);
+                    data.covariance(i, &cov_rows(i, GaussianData::ROT));
+                    cov_rows(i, GaussianData::ROT + GaussianData::COV_DIM) = 0.0f;
+                }
+            });
+    }, 3);
+
+    const std::vector<float> quad = { -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, -1.0f, -1.0f, -1.0f };
+    GLuint vao, vbo, ssbo[3];
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, quad.size() * sizeof(float), quad.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(0);
+
+    std::vector<uint32_t> index(N);
+    for (size_t i = 0; i < N; ++i) index[i] = static_cast<uint32_t>(i);
+    glGenBuffers(3, ssbo);
+    auto storage = [](GLuint buffer, int binding, const void* src, size_t bytes) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, src, GL_STATIC_DRAW);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+    };
+    storage(ssbo[0], 0, data.xyz.data(), N * 3 * sizeof(float));
+    storage(ssbo[1], 1, index.data(), N * sizeof(uint32_t));
+
+    // every splat center inside the frustum, so none leaves the shader early
+    const float fov = 60.0f;
+    const Eigen::Matrix4f projmat = perspective(fov, float(WIDTH) / HEIGHT, 0.1f, 1000.0f);
+    const float focal = HEIGHT / (2.0f * std::tan(fov / 180.0f * float(M_PI) / 2.0f));
+    // orbit_view() looks down +z, the OpenGL projection down -z
+    const Eigen::Matrix4f gl_flip = Eigen::Vector4f(1.0f, -1.0f, -1.0f, 1.0f).asDiagonal();
+    const Eigen::Matrix4f viewmat = gl_flip * orbit_view(0.5f, 40.0f, 8.0f);
+    const Eigen::Vector3f cam_pos = viewmat.inverse().block<3, 1>(0, 3);
+
+    struct Variant { const char* name; std::string defines; const GaussianData::Attributes* rows; size_t shape_bytes; };
+    const Variant variants[] = {
+        { "quaternion + scale", "", &data.attributes, 7 * sizeof(float) },
+        { "precomputed cov3d", "#define PRECOMPUTED_COV3D\n", &cov_rows, GaussianData::COV_DIM * sizeof(float) },
+    };
+    const int modes[] = { 0, 3, 4 };   // SH degree 0, SH up to degree 3, depth
+    const int FRAMES = 4;
+
+    std::string shader_path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+    std::vector<std::vector<float>> images;
+    double times[2][3];
+
+    glViewport(0, 0, WIDTH, HEIGHT);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    for (int v = 0; v < 2; ++v) {
+        const Variant& variant = variants[v];
+        storage(ssbo[2], 2, variant.rows->data(), N * cols * sizeof(float));
+        Shader shader((shader_path + "/draw_splat.vert").c_str(), (shader_path + "/draw_splat.frag").c_str(),
+                      false, variant.defines);
+        shader.bind(false);
+        shader.set_uniform("projmat", projmat);
+        shader.set_uniform("viewmat", viewmat);
+        shader.set_uniform("cam_pos", cam_pos);
+        shader.set_uniform("focal", focal);
+        shader.set_uniform("tanxy", Eigen::Vector2f(1.0f / projmat(0, 0), 1.0f / projmat(1, 1)));
+        shader.set_uniform("max_sh_dim", data.sh_dim());
+        shader.set_uniform("scale_modifier", 1.0f);
+
+        glEnable(GL_RASTERIZER_DISCARD);
+        for (int m = 0; m < 3; ++m) {
+            shader.set_uniform("render_mod", modes[m]);
+            times[v][m] = bench_median([&]() {
+                for (int f = 0; f < FRAMES; ++f) {
+                    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, static_cast<int>(N));
+                }
+                glFinish();
+            }, 3) / FRAMES;
+        }
+        glDisable(GL_RASTERIZER_DISCARD);
+
+        shader.set_uniform("render_mod", 3);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, static_cast<int>(N));
+        images.emplace_back(4 * WIDTH * HEIGHT);
+        glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_FLOAT, images.back().data());
+    }
+
+    printf("\n%-20s %12s %12s %12s %12s\n", "", "shape bytes", "SH0 ns/splat", "SH3 ns/splat", "depth ns/splat");
+    for (int v = 0; v < 2; ++v) {
+        printf("%-20s %12zu %12.2f %12.2f %14.2f\n", variants[v].name, variants[v].shape_bytes,
+               times[v][0] / N * 1e9, times[v][1] / N * 1e9, times[v][2] / N * 1e9);
+    }
+    printf("vertex stage speedup: %.2fx SH0, %.2fx SH3, %.2fx depth\n",
+           times[0][0] / times[1][0], times[0][1] / times[1][1], times[0][2] / times[1][2]);
+    printf("row size: %zu bytes for both, precompute: %.1f ms (%.1f ns/splat)\n",
+           cols * sizeof(float), t_precompute * 1e3, t_precompute / N * 1e9);
+
+    float diff = 0.0f;
+    for (size_t i = 0; i < images[0].size(); ++i) diff = std::max(diff, std::abs(images[0][i] - images[1][i]));
+    printf("largest pixel difference: %g\n", diff);
+
+    glDeleteBuffers(3, ssbo);
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    if (generated) std::remove(filename.c_str());
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <liteviz/headless.h>
+#include <liteviz/renderer.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/gpu_sorter.h>
+#include "bench_common.h"
+
+// GpuSorter against the CPU path it replaces, culling and the direct
+// DepthSorter with the index upload, on a fly-through (orbit views keep
+// every splat in the frustum), then whole frames of Renderer, to
+// glFinish(), with RenderConfig::gpu_sort off and on. The order and count
+// the GPU sort produces are checked by test-gpu-sort.
+// usage: bench-gpu-sort [N | scene.ply] (default: 1M generated splats)
+
+static constexpr int WIDTH = 1280, HEIGHT = 720, FRAMES = 8;
+
+int main(int argc, char** argv) {
+
+    std::string filename = "bench_gpu_sort.ply";
+    bool generated = true;
+    size_t N = 1000000;
+
+    if (argc > 1) {
+        std::string arg(argv[1]);
+        if (arg.size() > 4 && arg.substr(arg.size() - 4) == ".ply") {
+            filename = arg;
+            generated = false;
+        } else {
+            N = std::stoul(arg);
+        }
+    }
+    if (generated) write_scene_ply(filename, N, 0, SceneLayout::CLUSTERED);
+
+    HeadlessContext context;
+    if (!context.init()) {
+        fprintf(stderr, "Failed to init the offscreen context\n");
+        return 1;
+    }
+    printf("GL renderer: %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+    GaussianData data = GaussianData::load_ply(filename.c_str(), 0);
+    N = data.size();
+    printf("%zu splats\n", N);
+
+    Viewport viewport(WIDTH, HEIGHT);
+    viewport.frameBufferSize = Eigen::Vector2i(WIDTH, HEIGHT);
+    viewport.setFoV(60.0f);
+    const Eigen::Vector2f tanxy = viewport.getTanXY();
+    const Eigen::Matrix4f projmat = viewport.getProjectionMatrix();
+    // Renderer's guard band of 2 pixels
+    const Eigen::Vector2f widen = 2.0f * 2.0f / (2.0f * viewport.getFocal() * tanxy.array());
+    const float radius_scale = 3.0f;
+    const std::vector<Eigen::Matrix4f> views = camera_script(CameraScript::FLY, FRAMES);
+
+    std::vector<float> radius(N);
+    FrustumCuller::boundingRadii(data, 0, N, radius.data());
+
+    GLuint ssbo_xyz;
+    glGenBuffers(1, &ssbo_xyz);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo_xyz);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, N * 3 * sizeof(float), data.xyz.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo_xyz);
+
+    GpuSorter gpu_sorter(N);
+    gpu_sorter.uploadRadii(radius.data(), 0, N);
+    FrustumCuller culler;
+    DepthSorter cpu_sorter;
+    StreamBuffer index_stream;
+
+    printf("%-5s %10s %10s %12s %12s\n", "view", "visible", "cpu(ms)", "uploaded(MB)", "gpu(ms)");
+    std::vector<double> t_cpu, t_gpu;
+    std::vector<uint32_t> cpu_order;
+    for (size_t v = 0; v < views.size(); ++v) {
+        const Eigen::Matrix4f viewmat = views[v];
+        const FrustumCuller::Planes planes = FrustumCuller::planes(projmat, viewmat, widen);
+
+        // CPU: cull, sort the survivors and stream them, as Renderer's direct path does
+        glFinish();
+        Timer timer;
+        const size_t visible = culler.cull(data.xyz.data(), radius.data(), N, radius_scale, planes);
+        cpu_order.resize(visible);
+        cpu_sorter.sortSubset(data.xyz, viewmat, culler.visible().data(), visible, cpu_order.data());
+        index_stream.upload(cpu_order.data(), visible, 1);
+        index_stream.fence();
+        glFinish();
+        t_cpu.push_back(timer.elapsed());
+
+        // GPU: timed on the second sort of the view, the first grows the buffers
+        gpu_sorter.sort(N, viewmat, &planes, radius_scale, 1);
+        glFinish();
+        timer.reset();
+        gpu_sorter.sort(N, viewmat, &planes, radius_scale, 1);
+        glFinish();
+        t_gpu.push_back(timer.elapsed());
+
+        printf("%-5zu %10zu %10.2f %12.2f %12.2f\n", v, visible, t_cpu.back() * 1e3,
+               visible * sizeof(uint32_t) / 1048576.0, t_gpu.back() * 1e3);
+    }
+    std::sort(t_cpu.begin(), t_cpu.end());
+    std::sort(t_gpu.begin(), t_gpu.end());
+    printf("median: cpu cull + sort + upload %.2f ms, gpu sort %.2f ms\n", t_cpu[t_cpu.size() / 2] * 1e3,
+           t_gpu[t_gpu.size() / 2] * 1e3);
+    glDeleteBuffers(1, &ssbo_xyz);
+
+    // whole frames, the renderer's own buffers and sorters
+    std::string shader_path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+    Shader shader((shader_path + "/draw_splat.vert").c_str(), (shader_path + "/draw_splat.frag").c_str(), false,
+                  Renderer::shaderDefines(data));
+    Renderer renderer(data, &shader);
+    RenderConfig& config = renderer.config();
+    config.async_sort = false;
+    config.coherent_sort = false;
+    config.color_cache = false;
+    OffscreenTarget target(WIDTH, HEIGHT);
+    target.bind();
+    for (bool gpu : { false, true }) {
+        config.gpu_sort = gpu;
+        std::vector<double> frame, sort;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (const Eigen::Matrix4f& view : views) {
+                viewport.setViewMatrix(view.inverse());
+                glClear(GL_COLOR_BUFFER_BIT);
+                Timer timer;
+                renderer.render(viewport);
+                glFinish();
+                // the first pass warms up
+                if (pass == 0) continue;
+                frame.push_back(timer.elapsed());
+                sort.push_back(renderer.timings().sort + renderer.timings().upload);
+            }
+        }
+        std::sort(frame.begin(), frame.end());
+        std::sort(sort.begin(), sort.end());
+        // llvmpipe runs compute dispatches on the calling thread, a GPU queues them
+        printf("render, %s sort: %.2f ms per frame, %.2f ms of it in the sort and upload stages\n",
+               gpu ? "gpu" : "cpu", frame[frame.size() / 2] * 1e3, sort[sort.size() / 2] * 1e3);
+    }
+
+    if (generated) std::remove(filename.c_str());
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <liteviz/dataloader.h>
+#include "bench_common.h"
+
+// Load time of the mmap fast path against the tinyply path on generated scenes.
+// usage: bench-load [N ...] (default 100k, 1M, 3M splats at SH degree 3)
+
+int main(int argc, char** argv) {
+
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) sizes.push_back(std::stoul(argv[i]));
+    if (sizes.empty()) sizes = { 100000, 1000000, 3000000 };
+
+    printf("%10s %10s %12s %12s %9s\n", "N", "size(MB)", "tinyply(ms)", "mapped(ms)", "speedup");
+
+    for (size_t N : sizes) {
+        const std::string filename = "bench_load_" + std::to_string(N) + ".ply";
+        write_random_ply(filename, N);
+
+        GaussianData reference, fast;
+        double t_tinyply = bench_median([&]() { reference = GaussianData::load_ply_tinyply(filename.c_str()); }, 3);
+        double t_mapped = bench_median([&]() { GaussianData::load_ply_mapped(filename.c_str(), 3, fast); }, 3);
+
+        if (fast.size() != reference.size() || !fast.xyz.isApprox(reference.xyz) ||
+            !fast.attributes.isApprox(reference.attributes)) {
+            fprintf(stderr, "mapped loader disagrees with tinyply for N=%zu\n", N);
+            return 1;
+        }
+
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        double megabytes = double(file.tellg()) / (1 << 20);
+        printf("%10zu %10.1f %12.1f %12.1f %8.1fx\n", N, megabytes, t_tinyply * 1e3, t_mapped * 1e3, t_tinyply / t_mapped);
+
+        std::remove(filename.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <tbb/parallel_for.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/culling.h>
+#include <liteviz/sorter.h>
+#include <liteviz/sh.h>
+#include <liteviz/lod.h>
+#include "bench_common.h"
+
+// SplatLOD against drawing every splat: per frame CPU time (cut selection or
+// culling, then the depth sort), splats sent to the GPU, and the image error
+// of the cut against full detail. Images come from a CPU reference of
+// draw_splat.vert/.frag (same 2D covariance, low-pass, 3-sigma quad, 0.99
+// alpha cap and back-to-front blending), as this bench has no GL context; the
+// GPU draw time follows the splat count.
+// usage: bench-lod [N | scene.ply] (default: 2M generated splats at SH degree 0)
+
+static constexpr int WIDTH = 1280, HEIGHT = 720;
+
+struct Image {
+    std::vector<float> rgb = std::vector<float>(3 * WIDTH * HEIGHT, 0.0f);
+};
+
+// Scene splats first, then the LOD parents, as the renderer indexes them.
+static void splat_row(const GaussianData& data, const SplatLOD& lod, uint32_t index, float* attr, Eigen::Vector3f& pos) {
+    const GaussianData& block = index < lod.size() ? data : lod.parents();
+    const size_t i = index < lod.size() ? index : index - lod.size();
+    if (block.isCompact()) {
+        block.packed.unpackRow(i, attr);
+    } else {
+        std::copy_n(&block.attributes(i, 0), block.attributes.cols(), attr);
+    }
+    pos = block.xyz.row(i).transpose();
+}
+
+// Draws splats in the given back-to-front order.
+static Image rasterize(const GaussianData& data, const SplatLOD& lod, const std::vector<uint32_t>& order,
+                       const Eigen::Matrix4f& projmat, const Eigen::Matrix4f& viewmat, float focal) {
+
+    struct Projected {
+        float x, y;             // pixels, y up
+        float conic[3];
+        float half[2];          // quad half extent
+        float opacity;
+        float color[3];
+        bool  drawn;
+    };
+
+    const Eigen::Vector3f eye = viewmat.inverse().block<3, 1>(0, 3);
+    const Eigen::Matrix3f W = viewmat.block<3, 3>(0, 0);
+    const float tan_x = 1.0f / projmat(0, 0), tan_y = 1.0f / projmat(1, 1);
+    const int dim = data.sh_dim();
+
+    std::vector<Projected> projected(order.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, order.size(), 1 << 12),
+        [&](const tbb::blocked_range<size_t>& r) {
+            std::vector<float> attr(GaussianData::SH + dim);
+            for (size_t k = r.begin(); k < r.end(); ++k) {
+                Projected& p = projected[k];
+                Eigen::Vector3f pos;
+                splat_row(data, lod, order[k], attr.data(), pos);
+
+                const Eigen::Vector4f view = viewmat * pos.homogeneous();
+                const Eigen::Vector4f clip = projmat * view;
+                const Eigen::Vector3f ndc = clip.head<3>() / clip.w();
+                p.drawn = ndc.cwiseAbs().maxCoeff() <= 1.3f;
+                if (!p.drawn) continue;
+
+                const Eigen::Matrix3f R = Eigen::Quaternionf(attr[0], attr[1], attr[2], attr[3]).toRotationMatrix();
+                const Eigen::Vector3f s = Eigen::Map<const Eigen::Vector3f>(&attr[GaussianData::SCALE]);
+                const Eigen::Matrix3f cov3d = R * s.cwiseAbs2().asDiagonal() * R.transpose();
+
+                const float tz = view.z();
+                const float tx = std::clamp(view.x() / tz, -1.3f * tan_x, 1.3f * tan_x) * tz;
+                const float ty = std::clamp(view.y() / tz, -1.3f * tan_y, 1.3f * tan_y) * tz;
+                Eigen::Matrix<float, 2, 3> J;
+                J << focal / tz, 0.0f, -focal * tx / (tz * tz),
+                     0.0f, focal / tz, -focal * ty / (tz * tz);
+                const Eigen::Matrix<float, 2, 3> T = J * W;
+                Eigen::Matrix2f cov = T * cov3d * T.transpose();
+                cov(0, 0) += 0.3f;
+                cov(1, 1) += 0.3f;
+
+                const float det = cov.determinant();
+                p.drawn = det > 0.0f;
+                if (!p.drawn) continue;
+                p.conic[0] = cov(1, 1) / det;
+                p.conic[1] = -cov(0, 1) / det;
+                p.conic[2] = cov(0, 0) / det;
+                p.half[0] = 3.0f * std::sqrt(cov(0, 0));
+                p.half[1] = 3.0f * std::sqrt(cov(1, 1));
+                p.x = (ndc.x() + 1.0f) * 0.5f * WIDTH;
+                p.y = (ndc.y() + 1.0f) * 0.5f * HEIGHT;
+                p.opacity = attr[GaussianData::OPACITY];
+                const Eigen::Vector3f color = eval_sh(&attr[GaussianData::SH], dim, 3, (pos - eye).normalized());
+                std::copy_n(color.data(), 3, p.color);
+            }
+        });
+
+    Image image;
+    for (const Projected& p : projected) {
+        if (!p.drawn) continue;
+        const int x0 = std::max(0, int(std::ceil(p.x - p.half[0] - 0.5f)));
+        const int x1 = std::min(WIDTH - 1, int(std::floor(p.x + p.half[0] - 0.5f)));
+        const int y0 = std::max(0, int(std::ceil(p.y - p.half[1] - 0.5f)));
+        const int y1 = std::min(HEIGHT - 1, int(std::floor(p.y + p.half[1] - 0.5f)));
+        for (int y = y0; y <= y1; ++y) {
+            const float dy = y + 0.5f - p.y;
+            for (int x = x0; x <= x1; ++x) {
+                const float dx = x + 0.5f - p.x;
+                const float power = -0.5f * (p.conic[0] * dx * dx + p.conic[2] * dy * dy) - p.conic[1] * dx * dy;
+                if (power > 0.0f) continue;
+                const float a = std::min(0.99f, p.opacity * std::exp(power));
+                if (a < 1.0f / 255.0f) continue;
+                float* out = &image.rgb[3 * (size_t(y) * WIDTH + x)];
+                for (int c = 0; c < 3; ++c) {
+                    out[c] = std::clamp(a * p.color[c] + (1.0f - a) * out[c], 0.0f, 1.0f);
+                }
+            }
+        }
+    }
+    return image;
+}
+
+static double psnr(const Image& a, const Image& b) {
+    double mse = 0.0;
+    for (size_t i = 0; i < a.rgb.size(); ++i) {
+        const double d = a.rgb[i] - b.rgb[i];
+        mse += d * d;
+    }
+    mse /= a.rgb.size();
+    return mse > 0.0 ? 10.0 * std::log10(1.0 / mse) : std::numeric_limits<double>::infinity();
+}
+
+int main(int argc, char** argv) {
+
+    std::string filename = "bench_lod.ply";
+    bool generated = true;
+    size_t N = 2000000;
+
+    if (argc > 1) {
+        std::string arg(argv[1]);
+        if (arg.size() > 4 && arg.substr(arg.size() - 4) == ".ply") {
+            filename = arg;
+            generated = false;
+        } else {
+            N = std::stoul(arg);
+        }
+    }
+    if (generated) write_random_ply(filename, N, 0);
+
+    GaussianData data = GaussianData::load_ply(filename.c_str(), 3);
+    printf("%zu splats\n", data.size());
+
+    SplatLOD lod;
+    double t_build = bench_median([&]() { lod.build(data); }, 1);
+    printf("build: %.1f ms, %zu merged splats over %zu nodes\n", t_build * 1e3, lod.parents().size(), lod.octree().nodes().size());
+
+    const Eigen::AlignedBox3f& bounds = lod.octree().root().bounds;
+    const float extent = 0.5f * bounds.sizes().maxCoeff();
+    const float fov = 60.0f;
+    const Eigen::Matrix4f projmat = perspective(fov, float(WIDTH) / HEIGHT, 0.1f, 1000.0f);
+    const float focal = HEIGHT / (2.0f * std::tan(fov / 180.0f * float(M_PI) / 2.0f));
+    const Eigen::Vector2f tanxy(1.0f / projmat(0, 0), 1.0f / projmat(1, 1));
+    const Eigen::Matrix4f recenter = Eigen::Affine3f(Eigen::Translation3f(-bounds.center())).matrix();
+    // orbit_view() looks down +z, the OpenGL projection down -z
+    const Eigen::Matrix4f gl_flip = Eigen::Vector4f(1.0f, -1.0f, -1.0f, 1.0f).asDiagonal();
+
+    struct Setting { float threshold; size_t budget; };
+    const std::vector<Setting> settings = {
+        { 1.0f, 0 }, { 2.0f, 0 }, { 4.0f, 0 }, { 8.0f, 0 },
+        { 1.0f, data.size() / 2 }, { 1.0f, data.size() / 4 }, { 1.0f, data.size() / 16 },
+    };
+
+    DepthSorter sorter;
+    FrustumCuller culler;
+    std::vector<float> radius(data.size());
+    FrustumCuller::boundingRadii(data, 0, data.size(), radius.data());
+    std::vector<uint32_t> cut, order;
+
+    for (float distance : { 0.8f, 2.0f, 5.0f }) {
+        const Eigen::Matrix4f viewmat = gl_flip * orbit_view(0.5f, distance * extent, 0.3f * distance * extent) * recenter;
+        const FrustumCuller::Planes planes = FrustumCuller::planes(projmat, viewmat, Eigen::Vector2f(2.0f * 2.0f / (2.0f * focal * tanxy.array())));
+
+        // full detail: cull, then sort the survivors, as Renderer does without LOD
+        double t_full = bench_median([&]() {
+            const size_t visible = culler.cull(data.xyz.data(), radius.data(), data.size(), 3.0f, planes);
+            order.resize(visible);
+            sorter.sortSubset(data.xyz, viewmat, culler.visible().data(), visible, order.data());
+        });
+        const Image reference = rasterize(data, lod, order, projmat, viewmat, focal);
+
+        printf("\ncamera at %.1f x scene half extent\n", distance);
+        printf("%-24s %10s %8s %12s %9s %9s\n", "", "splats", "drawn%", "cpu(ms)", "cpu fps", "psnr(dB)");
+        printf("%-24s %10zu %7.1f%% %12.2f %9.0f %9s\n", "full detail", order.size(), 100.0 * order.size() / data.size(),
+               t_full * 1e3, 1.0 / t_full, "-");
+
+        for (const Setting& setting : settings) {
+            double t_lod = bench_median([&]() {
+                const size_t count = lod.select(viewmat.inverse().block<3, 1>(0, 3), focal, setting.threshold, setting.budget,
+                                                &planes, 3.0f, cut);
+                order.resize(count);
+                sorter.sortSubset(lod.positions(), viewmat, cut.data(), count, order.data());
+            });
+            const Image image = rasterize(data, lod, order, projmat, viewmat, focal);
+
+            char label[64];
+            if (setting.budget) snprintf(label, sizeof(label), "lod %.0f px, budget %zuk", setting.threshold, setting.budget / 1000);
+            else snprintf(label, sizeof(label), "lod %.0f px", setting.threshold);
+            printf("%-24s %10zu %7.1f%% %12.2f %9.0f %9.2f\n", label, order.size(), 100.0 * order.size() / data.size(),
+                   t_lod * 1e3, 1.0 / t_lod, psnr(reference, image));
+        }
+    }
+
+    if (generated) std::remove(filename.c_str());
+    return 0;
+}
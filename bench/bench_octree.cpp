@@ -0,0 +1,148 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <tbb/parallel_reduce.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/culling.h>
+#include <liteviz/octree.h>
+#include "bench_common.h"
+
+// SplatOctree build time and query throughput. Frustum queries are checked
+// against FrustumCuller over all splats, ray casts against testing every
+// splat; the cameras orbit inside the scene so that queries cut through it.
+// usage: bench-octree [N | scene.ply] (default: 4M generated splats at SH degree 0)
+
+static SplatOctree::Hit raycast_brute(const GaussianData& data, const Eigen::Vector3f& origin, const Eigen::Vector3f& dir) {
+    using Best = std::pair<float, uint32_t>;
+    Best best = tbb::parallel_reduce(
+        tbb::blocked_range<size_t>(0, data.size(), 1 << 14), Best(std::numeric_limits<float>::infinity(), SplatOctree::NONE),
+        [&](const tbb::blocked_range<size_t>& r, Best b) {
+            for (size_t i = r.begin(); i < r.end(); ++i) {
+                float t;
+                if (SplatOctree::intersect(data, i, origin, dir, 3.0f, 1.0f, t) && t < b.first) b = Best(t, uint32_t(i));
+            }
+            return b;
+        },
+        [](const Best& a, const Best& b) { return a.first <= b.first ? a : b; });
+
+    SplatOctree::Hit hit;
+    hit.t = best.first;
+    hit.splat = best.second;
+    return hit;
+}
+
+int main(int argc, char** argv) {
+
+    std::string filename = "bench_octree.ply";
+    bool generated = true;
+    size_t N = 4000000;
+
+    if (argc > 1) {
+        std::string arg(argv[1]);
+        if (arg.size() > 4 && arg.substr(arg.size() - 4) == ".ply") {
+            filename = arg;
+            generated = false;
+        } else {
+            N = std::stoul(arg);
+        }
+    }
+    if (generated) write_random_ply(filename, N, 0);
+
+    GaussianData data = GaussianData::load_ply(filename.c_str(), 0);
+    printf("%zu splats\n", data.size());
+
+    // build
+    SplatOctree octree;
+    double t_build = bench_median([&]() { octree.build(data); }, 3);
+    size_t leaves = 0;
+    for (const SplatOctree::Node& node : octree.nodes()) leaves += node.leaf();
+    printf("build: %.1f ms, %zu nodes (%zu leaves), depth %d\n",
+           t_build * 1e3, octree.nodes().size(), leaves, octree.depth());
+
+    // scene extent, to place cameras inside it
+    const Eigen::AlignedBox3f& bounds = octree.root().bounds;
+    const float extent = 0.5f * bounds.sizes().maxCoeff();
+    const Eigen::Matrix4f projmat = perspective(60.0f, 16.0f / 9.0f);
+    const Eigen::Matrix4f recenter = Eigen::Affine3f(Eigen::Translation3f(-bounds.center())).matrix();
+    // orbit_view() looks down +z, the OpenGL projection down -z
+    const Eigen::Matrix4f gl_flip = Eigen::Vector4f(1.0f, -1.0f, -1.0f, 1.0f).asDiagonal();
+    const int VIEWS = 16;
+
+    // frustum queries
+    printf("%-8s %10s %12s %12s %9s %9s\n", "view", "visible", "culler(ms)", "octree(ms)", "speedup", "mismatch");
+    FrustumCuller culler;
+    std::vector<float> radius(data.size());
+    FrustumCuller::boundingRadii(data, 0, data.size(), radius.data());
+    std::vector<uint32_t> found;
+    double total_culler = 0.0, total_octree = 0.0;
+    for (int v = 0; v < VIEWS; ++v) {
+        const Eigen::Matrix4f viewmat = gl_flip * orbit_view(2.0f * float(M_PI) * v / VIEWS, 0.6f * extent, 0.1f * extent) * recenter;
+        const FrustumCuller::Planes planes = FrustumCuller::planes(projmat, viewmat);
+
+        double t_culler = bench_median([&]() { culler.cull(data.xyz.data(), radius.data(), data.size(), 3.0f, planes); });
+        double t_octree = bench_median([&]() { found.clear(); octree.queryFrustum(planes, 3.0f, found); });
+
+        std::sort(found.begin(), found.end());
+        std::vector<uint32_t> diff;
+        std::set_symmetric_difference(found.begin(), found.end(), culler.visible().begin(), culler.visible().end(),
+                                      std::back_inserter(diff));
+
+        printf("%-8d %10zu %12.2f %12.2f %8.1fx %9zu\n", v, found.size(), t_culler * 1e3, t_octree * 1e3,
+               t_culler / t_octree, diff.size());
+        total_culler += t_culler;
+        total_octree += t_octree;
+    }
+    printf("frustum query: %.1f Msplats/s octree vs %.1f Msplats/s culler\n",
+           VIEWS * data.size() / total_octree * 1e-6, VIEWS * data.size() / total_culler * 1e-6);
+
+    // ray casts through a pixel grid of one view
+    {
+        const Eigen::Matrix4f viewmat = gl_flip * orbit_view(0.3f, 0.6f * extent, 0.1f * extent) * recenter;
+        const Eigen::Matrix4f cam = viewmat.inverse();
+        const Eigen::Vector3f eye = cam.block<3, 1>(0, 3);
+        const int W = 128, H = 72;
+        std::vector<Eigen::Vector3f> dirs;
+        for (int y = 0; y < H; ++y) {
+            for (int x = 0; x < W; ++x) {
+                // camera looks down -z in view space
+                Eigen::Vector4f ndc((x + 0.5f) / W * 2.0f - 1.0f, (y + 0.5f) / H * 2.0f - 1.0f, 1.0f, 1.0f);
+                Eigen::Vector4f view = projmat.inverse() * ndc;
+                dirs.push_back((cam.block<3, 3>(0, 0) * (view.head<3>() / view.w())).normalized());
+            }
+        }
+
+        size_t hits = 0;
+        double t_rays = bench_median([&]() {
+            hits = 0;
+            for (const Eigen::Vector3f& dir : dirs) hits += octree.raycast(eye, dir).valid();
+        }, 3);
+        printf("ray cast: %zu rays, %zu hits, %.1f us/ray (%.0f krays/s, one thread)\n",
+               dirs.size(), hits, t_rays / dirs.size() * 1e6, dirs.size() / t_rays * 1e-3);
+
+        // a few rays against the brute force answer
+        int wrong = 0;
+        const int CHECKS = 8;
+        for (int c = 0; c < CHECKS; ++c) {
+            const Eigen::Vector3f& dir = dirs[(c * 7919) % dirs.size()];
+            SplatOctree::Hit a = octree.raycast(eye, dir), b = raycast_brute(data, eye, dir);
+            wrong += a.splat != b.splat && a.t != b.t;
+        }
+        printf("ray cast check: %d / %d rays disagree with brute force\n", wrong, CHECKS);
+    }
+
+    // depth ordered traversal of every node
+    {
+        const Eigen::Vector3f eye = bounds.center() + Eigen::Vector3f(0.3f, 0.2f, 0.1f) * extent;
+        size_t visited = 0;
+        double t_walk = bench_median([&]() {
+            visited = 0;
+            octree.traverseDepthOrder(eye, [&](const SplatOctree::Node&) { ++visited; return true; });
+        });
+        printf("depth order traversal: %zu nodes in %.2f ms\n", visited, t_walk * 1e3);
+    }
+
+    if (generated) std::remove(filename.c_str());
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <liteviz/dataloader.h>
+#include <liteviz/picker.h>
+#include "bench_common.h"
+
+// Latency of SplatPicker::pick() over a grid of cursor positions of one
+// view: percentiles and the worst case, and the same rays cast without the
+// MAX_LEAVES bound, with how many picks the bound changes.
+// usage: bench-pick [N | scene.ply] (default: 1M generated splats)
+
+int main(int argc, char** argv) {
+
+    std::string filename = "bench_pick.ply";
+    bool generated = true;
+    size_t N = 1000000;
+
+    if (argc > 1) {
+        std::string arg(argv[1]);
+        if (arg.size() > 4 && arg.substr(arg.size() - 4) == ".ply") {
+            filename = arg;
+            generated = false;
+        } else {
+            N = std::stoul(arg);
+        }
+    }
+    if (generated) write_random_ply(filename, N, 0);
+
+    GaussianData data = GaussianData::load_ply(filename.c_str(), 0);
+    printf("%zu splats\n", data.size());
+
+    Timer timer;
+    SplatOctree octree(data);
+    printf("octree build: %.1f ms\n", timer.elapsed() * 1e3);
+
+    const int width = 1280, height = 720;
+    Viewport viewport(width, height);
+    viewport.frameBufferSize = Eigen::Vector2i(width, height);
+    viewport.setFoV(60.0f);
+    // orbit_view() looks down +z, the OpenGL view down -z
+    const Eigen::Matrix4f gl_flip = Eigen::Vector4f(1.0f, -1.0f, -1.0f, 1.0f).asDiagonal();
+    viewport.setViewMatrix(Eigen::Matrix4f(gl_flip * orbit_view(0.5f, 25.0f, 6.0f)).inverse());
+
+    std::vector<Eigen::Vector2f> cursor;
+    for (int y = 0; y < height; y += 24) {
+        for (int x = 0; x < width; x += 24) cursor.emplace_back(x + 0.5f, y + 0.5f);
+    }
+
+    SplatPicker picker;
+    picker.use(octree);
+    std::vector<double> latency;
+    for (const Eigen::Vector2f& pos : cursor) {
+        float depth;
+        picker.pick(viewport, pos, 1.0f, depth);
+        latency.push_back(picker.latency().last);
+    }
+    std::sort(latency.begin(), latency.end());
+    auto percentile = [&](double p) { return latency[std::min(latency.size() - 1, size_t(p * latency.size()))] * 1e3; };
+    printf("pick: %zu picks, %zu hits, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n", latency.size(),
+           picker.latency().hits, percentile(0.5), percentile(0.95), percentile(0.99), latency.back() * 1e3);
+
+    // the same rays without the leaf budget
+    const Eigen::Vector2f tanxy = viewport.getTanXY();
+    const Eigen::Vector3f eye = viewport.getCameraPosition();
+    std::vector<double> unbounded;
+    size_t changed = 0;
+    for (const Eigen::Vector2f& pos : cursor) {
+        const Eigen::Vector2f ndc(2.0f * pos.x() / width - 1.0f, 1.0f - 2.0f * pos.y() / height);
+        const Eigen::Vector3f dir = viewport.getCameraRotation() *
+                                    Eigen::Vector3f(ndc.x() * tanxy.x(), ndc.y() * tanxy.y(), -1.0f);
+        Timer ray;
+        const SplatOctree::Hit hit = octree.raycast(eye, dir, SplatPicker::SIGMA, 1.0f, SplatPicker::MIN_OPACITY);
+        unbounded.push_back(ray.elapsed());
+        changed += hit.splat != octree.raycast(eye, dir, SplatPicker::SIGMA, 1.0f, SplatPicker::MIN_OPACITY,
+                                               SplatPicker::MAX_LEAVES).splat;
+    }
+    latency = unbounded;
+    std::sort(latency.begin(), latency.end());
+    printf("unbounded: p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms, %zu / %zu picks differ from the bounded\n",
+           percentile(0.5), percentile(0.95), percentile(0.99), latency.back() * 1e3, changed, cursor.size());
+
+    if (generated) std::remove(filename.c_str());
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <liteviz/dataloader.h>
+#include <liteviz/sh.h>
+#include "bench_common.h"
+
+// Size and accuracy of the compact storage formats against fp32. The color
+// error is the SH color (clamped to [0, 1]) each splat shows to a camera at
+// cam_pos, evaluated on the CPU from the fp32 and from the decoded attributes.
+// usage: bench-quantize [N | scene.ply] (default: 1M generated splats at SH degree 3)
+
+struct Errors {
+    double rot_mean     = 0.0;  // degrees
+    double rot_max      = 0.0;
+    double scale_max    = 0.0;  // relative
+    double opacity_max  = 0.0;
+    double color_mean   = 0.0;
+    double color_max    = 0.0;
+    double color_psnr   = 0.0;  // dB
+};
+
+static Errors measure(const GaussianData& reference, const GaussianData& compact, const Eigen::Vector3f& cam_pos) {
+
+    const size_t N = reference.size();
+    const int cols = static_cast<int>(reference.attributes.cols());
+    const int sh_dim = reference.sh_dim();
+    std::vector<float> decoded(cols);
+
+    Errors e;
+    double color_sq = 0.0;
+
+    for (size_t i = 0; i < N; ++i) {
+        const float* ref = &reference.attributes(i, 0);
+        compact.packed.unpackRow(i, decoded.data());
+
+        Eigen::Map<const Eigen::Vector4f> q_ref(ref + GaussianData::ROT), q(decoded.data() + GaussianData::ROT);
+        double angle = 2.0 * std::acos(std::min(1.0, std::abs(double(q_ref.dot(q))))) * 180.0 / M_PI;
+        e.rot_mean += angle;
+        e.rot_max = std::max(e.rot_max, angle);
+
+        for (int j = 0; j < 3; ++j) {
+            double s = ref[GaussianData::SCALE + j];
+            e.scale_max = std::max(e.scale_max, std::abs(decoded[GaussianData::SCALE + j] - s) / s);
+        }
+        e.opacity_max = std::max(e.opacity_max, double(std::abs(decoded[GaussianData::OPACITY] - ref[GaussianData::OPACITY])));
+
+        Eigen::Vector3f dir = (reference.xyz.row(i).transpose() - cam_pos).normalized();
+        Eigen::Vector3f c_ref = eval_sh(ref + GaussianData::SH, sh_dim, 3, dir).cwiseMax(0.0f).cwiseMin(1.0f);
+        Eigen::Vector3f c = eval_sh(decoded.data() + GaussianData::SH, sh_dim, 3, dir).cwiseMax(0.0f).cwiseMin(1.0f);
+        Eigen::Vector3f diff = (c - c_ref).cwiseAbs();
+        e.color_mean += diff.sum();
+        e.color_max = std::max(e.color_max, double(diff.maxCoeff()));
+        color_sq += diff.squaredNorm();
+    }
+
+    e.rot_mean /= N;
+    e.color_mean /= 3.0 * N;
+    e.color_psnr = 10.0 * std::log10(3.0 * N / std::max(color_sq, 1e-30));
+    return e;
+}
+
+int main(int argc, char** argv) {
+
+    std::string filename = "bench_quantize.ply";
+    bool generated = true;
+    size_t N = 1000000;
+
+    if (argc > 1) {
+        std::string arg(argv[1]);
+        if (arg.size() > 4 && arg.substr(arg.size() - 4) == ".ply") {
+            filename = arg;
+            generated = false;
+        } else {
+            N = std::stoul(arg);
+        }
+    }
+    if (generated) write_random_ply(filename, N);
+
+    GaussianData reference;
+    double t_fp32 = bench_median([&]() { reference = GaussianData::load_ply(filename.c_str()); }, 3);
+    const size_t fp32_bytes = (3 + reference.attributes.cols()) * sizeof(float);
+    const Eigen::Vector3f cam_pos(0.0f, -30.0f, 5.0f);
+
+    printf("%zu splats, SH dim %d\n", reference.size(), reference.sh_dim());
+    printf("%-8s %8s %10s %9s %9s %9s %9s %9s %10s %10s %9s\n", "format", "B/splat", "total(MB)", "load(ms)",
+           "rot(deg)", "rot max", "scale", "opacity", "color", "color max", "PSNR(dB)");
+    printf("%-8s %8zu %10.1f %9.1f\n", "fp32", fp32_bytes, double(fp32_bytes * reference.size()) / (1 << 20), t_fp32 * 1e3);
+
+    const std::pair<const char*, GaussianData::Storage> formats[] = {
+        { "fp16", GaussianData::COMPACT_FP16 },
+        { "sh-u8", GaussianData::COMPACT_UINT8 },
+    };
+
+    for (const auto& [name, storage] : formats) {
+        GaussianData compact;
+        double t_load = bench_median([&]() { compact = GaussianData::load_ply(filename.c_str(), 3, storage); }, 3);
+
+        if (compact.size() != reference.size() || !compact.isCompact() || compact.xyz != reference.xyz) {
+            fprintf(stderr, "%s: compact load disagrees with fp32\n", name);
+            return 1;
+        }
+
+        const size_t bytes = compact.packed.bytesPerSplat();
+        Errors e = measure(reference, compact, cam_pos);
+        printf("%-8s %8zu %10.1f %9.1f %9.4f %9.4f %9.2e %9.2e %10.2e %10.2e %9.1f\n", name, bytes,
+               double(bytes * compact.size()) / (1 << 20), t_load * 1e3, e.rot_mean, e.rot_max,
+               e.scale_max, e.opacity_max, e.color_mean, e.color_max, e.color_psnr);
+    }
+
+    if (generated) std::remove(filename.c_str());
+    return 0;
+}
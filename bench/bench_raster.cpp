@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <tbb/task_arena.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/rasterizer.h>
+#include "bench_common.h"
+
+// Frame time of CpuRasterizer per render mode and number of threads, as
+// Mpix/s of the output image. Needs no GPU and no display. The (tile,
+// splat) pairs per frame tell how much compositing the view takes.
+// usage: bench-raster [N | scene.ply] [width height] (default: 1M generated splats, 1280 x 720)
+
+int main(int argc, char** argv) {
+
+    std::string filename = "bench_raster.ply";
+    bool generated = true;
+    size_t N = 1000000;
+    int width = 1280, height = 720;
+
+    if (argc > 1) {
+        std::string arg(argv[1]);
+        if (arg.size() > 4 && arg.substr(arg.size() - 4) == ".ply") {
+            filename = arg;
+            generated = false;
+        } else {
+            N = std::stoul(arg);
+        }
+    }
+    if (argc > 3) {
+        width = std::stoi(argv[2]);
+        height = std::stoi(argv[3]);
+    }
+    if (generated) write_random_ply(filename, N, 3);
+
+    GaussianData data = GaussianData::load_ply(filename.c_str(), 3);
+    N = data.size();
+    printf("%zu splats, SH dim %d, %d x %d\n", N, data.sh_dim(), width, height);
+
+    Viewport viewport(width, height);
+    viewport.frameBufferSize = Eigen::Vector2i(width, height);
+    viewport.setFoV(60.0f);
+    // orbit_view() looks down +z, the OpenGL view down -z
+    const Eigen::Matrix4f gl_flip = Eigen::Vector4f(1.0f, -1.0f, -1.0f, 1.0f).asDiagonal();
+    viewport.setViewMatrix(Eigen::Matrix4f(gl_flip * orbit_view(0.5f, 25.0f, 6.0f)).inverse());
+
+    std::vector<int> threads;
+    const int max_threads = tbb::this_task_arena::max_concurrency();
+    for (int t = 1; t < max_threads; t *= 2) threads.push_back(t);
+    threads.push_back(max_threads);
+
+    const std::pair<RenderConfig::RenderMode, const char*> modes[] = {
+        { RenderConfig::COLOR_SH_0, "SH0" },
+        { RenderConfig::COLOR_SH_3, "SH3" },
+        { RenderConfig::DEPTH,      "depth" },
+        { RenderConfig::GAUSS_BALL, "gauss ball" },
+    };
+
+    CpuRasterizer rasterizer;
+    RenderConfig config;
+    std::vector<float> rgba;
+    const double pixels = double(width) * height;
+
+    printf("%-12s", "mode");
+    for (int t : threads) printf(" %9d thr", t);
+    printf(" %14s\n", "tile entries");
+    for (const auto& mode : modes) {
+        config.render_mode = mode.first;
+        printf("%-12s", mode.second);
+        for (int t : threads) {
+            tbb::task_arena arena(t);
+            double time = bench_median([&]() {
+                arena.execute([&]() { rasterizer.render(data, viewport, config, rgba); });
+            }, 3);
+            printf(" %7.1f Mpx/s", pixels / time * 1e-6);
+        }
+        printf(" %14zu\n", rasterizer.entries());
+    }
+
+    if (generated) std::remove(filename.c_str());
+    return 0;
+}
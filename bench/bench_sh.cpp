@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <tbb/task_arena.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/sh.h>
+#include "bench_common.h"
+
+// Batch SH evaluation against the per-splat scalar reference eval_sh(), for
+// each SH degree: eval_sh_colors() straight from the attribute rows and
+// SHPlanes::eval() from the prebuilt SoA layout, on one thread and on all,
+// and the largest difference to the reference over every splat and channel,
+// relative to the reference where it exceeds 1. Exits non-zero when that is
+// over TOLERANCE, a few float roundings at the 16 terms of degree 3.
+// usage: bench-sh [N | scene.ply] (default: 1M generated splats at SH degree 3)
+
+static constexpr float TOLERANCE = 1e-5f;
+
+static float max_error(const std::vector<float>& rgb, const std::vector<float>& reference) {
+    float error = 0.0f;
+    for (size_t k = 0; k < rgb.size(); ++k) {
+        error = std::max(error, std::abs(rgb[k] - reference[k]) / std::max(1.0f, std::abs(reference[k])));
+    }
+    return error;
+}
+
+int main(int argc, char** argv) {
+
+    std::string filename = "bench_sh.ply";
+    bool generated = true;
+    size_t N = 1000000;
+
+    if (argc > 1) {
+        std::string arg(argv[1]);
+        if (arg.size() > 4 && arg.substr(arg.size() - 4) == ".ply") {
+            filename = arg;
+            generated = false;
+        } else {
+            N = std::stoul(arg);
+        }
+    }
+    if (generated) write_random_ply(filename, N, 3);
+
+    GaussianData data = GaussianData::load_ply(filename.c_str(), 3);
+    N = data.size();
+    const int dim = data.sh_dim();
+    printf("%zu splats, SH dim %d\n", N, dim);
+#if defined(__x86_64__) && defined(__GNUC__)
+    printf("kernel clone: %s\n", __builtin_cpu_supports("avx512f") ? "avx512f" : __builtin_cpu_supports("avx2") ? "avx2" : "default");
+#endif
+
+    const Eigen::Vector3f eye(3.0f, -25.0f, 6.0f);
+    std::vector<float> rgb(3 * N), reference(3 * N);
+    tbb::task_arena single(1);
+
+    SHPlanes planes;
+    double t_planes = bench_median([&]() { planes.build(data); }, 3);
+    printf("SoA build: %.1f ms\n", t_planes * 1e3);
+
+    printf("%-8s %12s %12s %12s %12s %12s %11s\n", "degree", "scalar", "rows 1 thr", "rows all", "SoA 1 thr", "SoA all",
+           "max error");
+    bool valid = true;
+    for (int degree = 0; degree <= 3; ++degree) {
+        double t_scalar = bench_median([&]() {
+            for (size_t i = 0; i < N; ++i) {
+                const Eigen::Vector3f color = eval_sh(&data.attributes(i, GaussianData::SH), dim, degree,
+                                                      (data.xyz.row(i).transpose() - eye).normalized());
+                std::copy_n(color.data(), 3, &reference[3 * i]);
+            }
+        }, 3);
+        double t_single = bench_median([&]() {
+            single.execute([&]() { eval_sh_colors(data, 0, N, eye, degree, rgb.data()); });
+        }, 3);
+        double t_all = bench_median([&]() { eval_sh_colors(data, 0, N, eye, degree, rgb.data()); }, 3);
+        float error = max_error(rgb, reference);
+
+        double t_soa_single = bench_median([&]() {
+            single.execute([&]() { planes.eval(eye, degree, rgb.data()); });
+        }, 3);
+        double t_soa_all = bench_median([&]() { planes.eval(eye, degree, rgb.data()); }, 3);
+        error = std::max(error, max_error(rgb, reference));
+        valid &= error <= TOLERANCE;
+
+        printf("%-8d %7.1f Ms/s %7.1f Ms/s %7.1f Ms/s %7.1f Ms/s %7.1f Ms/s %11.2e\n", degree, N / t_scalar * 1e-6,
+               N / t_single * 1e-6, N / t_all * 1e-6, N / t_soa_single * 1e-6, N / t_soa_all * 1e-6, error);
+    }
+
+    if (generated) std::remove(filename.c_str());
+    if (!valid) {
+        fprintf(stderr, "batch SH colors differ from eval_sh() by more than %.0e\n", TOLERANCE);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <cstdio>
+#include <tbb/parallel_sort.h>
+#include <liteviz/dataloader.h>
+#include "bench_common.h"
+
+// The comparator-based sort that DepthSorter replaced, kept as the baseline.
+static std::vector<int> sort_comparator(const GaussianData::Positions& xyz, const Eigen::Matrix4f& P) {
+    const size_t N = xyz.rows();
+    std::vector<int> depth_index(N);
+    std::vector<float> depths(N);
+    const Eigen::RowVector3f proj_row = P.row(2).head<3>();
+    for (size_t i = 0; i < N; ++i) {
+        Eigen::Vector3f center = xyz.row(i).transpose();
+        depths[i] = proj_row.dot(center);
+        depth_index[i] = static_cast<int>(i);
+    }
+    tbb::parallel_sort(depth_index.begin(), depth_index.end(),
+                    [&](int i, int j) {
+                        return depths[i] < depths[j];
+                    });
+    return depth_index;
+}
+
+static bool is_sorted_by_depth(const GaussianData::Positions& xyz, const Eigen::Matrix4f& P, const uint32_t* index, float tol) {
+    const Eigen::RowVector3f proj_row = P.row(2).head<3>();
+    for (size_t i = 1; i < size_t(xyz.rows()); ++i) {
+        float a = proj_row.dot(xyz.row(index[i - 1]));
+        float b = proj_row.dot(xyz.row(index[i]));
+        if (a > b + tol) return false;
+    }
+    return true;
+}
+
+int main() {
+
+    const size_t sizes[] = { 100000, 300000, 1000000, 3000000, 10000000 };
+    const Eigen::Matrix4f viewmat = orbit_view(0.3f);
+
+    printf("%10s %14s %12s %12s %12s %9s\n", "N", "comparator(ms)", "radix16(ms)", "radix24(ms)", "radix32(ms)", "speedup");
+
+    for (size_t N : sizes) {
+        GaussianData::Positions xyz = random_xyz(N);
+        std::vector<uint32_t> index(N);
+
+        double t_cmp = bench_median([&]() { sort_comparator(xyz, viewmat); });
+
+        double t_radix[3];
+        DepthSorter::KeyBits bits[3] = { DepthSorter::KEY_16, DepthSorter::KEY_24, DepthSorter::KEY_32 };
+        for (int b = 0; b < 3; ++b) {
+            DepthSorter sorter(bits[b]);
+            t_radix[b] = bench_median([&]() { sorter.sort(xyz, viewmat, index.data()); });
+
+            // 16/24-bit keys may swap splats that share a depth bucket, 32-bit only differs by rounding
+            float tol = (b == 2) ? 1e-5f : 60.0f / float(1u << bits[b]);
+            if (!is_sorted_by_depth(xyz, viewmat, index.data(), tol)) {
+                fprintf(stderr, "radix%d produced a wrong ordering for N=%zu\n", int(bits[b]), N);
+                return 1;
+            }
+        }
+
+        printf("%10zu %14.2f %12.2f %12.2f %12.2f %8.1fx\n", N,
+            t_cmp * 1e3, t_radix[0] * 1e3, t_radix[1] * 1e3, t_radix[2] * 1e3, t_cmp / t_radix[2]);
+    }
+
+    return 0;
+}
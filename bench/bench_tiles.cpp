@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <liteviz/headless.h>
+#include <liteviz/renderer.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/image_writer.h>
+#include "bench_common.h"
+
+// The compute tile renderer (RenderConfig::tile_render) against the quad
+// rasterizer on the same views: frame time to glFinish() and the pixel
+// difference of the two RGB images, per render mode. The tile renderer
+// blends front to back in fp16 and the rasterizer back to front in the
+// 8-bit target, so small differences are expected everywhere; what falls
+// behind an opaque pixel, or a quad's coverage off by a sample at its
+// border, differs by more. With a path prefix, both images of the first
+// view are written as PNG for a look.
+// usage: bench-tiles [N | scene.ply] [prefix] (default: 200k generated splats)
+
+static constexpr int WIDTH = 1280, HEIGHT = 720;
+
+int main(int argc, char** argv) {
+
+    std::string filename = "bench_tiles.ply";
+    bool generated = true;
+    size_t N = 200000;
+
+    if (argc > 1) {
+        std::string arg(argv[1]);
+        if (arg.size() > 4 && arg.substr(arg.size() - 4) == ".ply") {
+            filename = arg;
+            generated = false;
+        } else {
+            N = std::stoul(arg);
+        }
+    }
+    const std::string prefix = argc > 2 ? argv[2] : "";
+    if (generated) write_scene_ply(filename, N, 3, SceneLayout::CLUSTERED);
+
+    HeadlessContext context;
+    if (!context.init()) {
+        fprintf(stderr, "Failed to init the offscreen context\n");
+        return 1;
+    }
+    printf("GL renderer: %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+    GaussianData data = GaussianData::load_ply(filename.c_str(), 3);
+    printf("%zu splats\n", data.size());
+
+    std::string shader_path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+    Shader shader((shader_path + "/draw_splat.vert").c_str(), (shader_path + "/draw_splat.frag").c_str(), false,
+                  Renderer::shaderDefines(data));
+    Renderer renderer(data, &shader);
+    RenderConfig& config = renderer.config();
+    config.async_sort = false;
+    config.color_cache = false;
+
+    OffscreenTarget target(WIDTH, HEIGHT);
+    Viewport viewport(WIDTH, HEIGHT);
+    viewport.frameBufferSize = Eigen::Vector2i(WIDTH, HEIGHT);
+    viewport.setFoV(config.fov);
+    const std::vector<Eigen::Matrix4f> views = camera_script(CameraScript::ZOOM, 4);
+
+    auto frame = [&](const Eigen::Matrix4f& view, bool tiles, std::vector<uint8_t>& rgba) {
+        config.tile_render = tiles;
+        viewport.setViewMatrix(view.inverse());
+        target.bind();
+        const Eigen::Vector4f clear_color(0.0f, 0.0f, 0.0f, 1.0f);
+        glClearBufferfv(GL_COLOR, 0, clear_color.data());
+        Timer timer;
+        renderer.render(viewport);
+        glFinish();
+        const double time = timer.elapsed();
+        rgba.resize(size_t(4) * WIDTH * HEIGHT);
+        glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+        return time;
+    };
+
+    struct Mode { const char* name; RenderConfig::RenderMode mode; };
+    const Mode modes[] = {
+        { "sh3", RenderConfig::COLOR_SH_3 }, { "sh0", RenderConfig::COLOR_SH_0 },
+        { "depth", RenderConfig::DEPTH }, { "ball", RenderConfig::GAUSS_BALL },
+    };
+
+    printf("%-6s %12s %12s %10s %10s %12s %12s\n", "mode", "quads(ms)", "tiles(ms)", "entries", "max diff",
+           "mean diff", "> 8 levels");
+    std::vector<uint8_t> quads, tiles;
+    for (const Mode& mode : modes) {
+        config.render_mode = mode.mode;
+        std::vector<double> t_quads, t_tiles;
+        int max_diff = 0;
+        double sum_diff = 0.0;
+        size_t large = 0, entries = 0;
+        for (size_t v = 0; v < views.size(); ++v) {
+            // the first frame of each path warms up shaders and buffers
+            frame(views[v], false, quads);
+            t_quads.push_back(frame(views[v], false, quads));
+            frame(views[v], true, tiles);
+            t_tiles.push_back(frame(views[v], true, tiles));
+            entries += renderer.tileEntries();
+
+            for (size_t p = 0; p < size_t(WIDTH) * HEIGHT; ++p) {
+                int pixel_diff = 0;
+                for (int c = 0; c < 3; ++c) {
+                    const int d = std::abs(int(quads[4 * p + c]) - int(tiles[4 * p + c]));
+                    pixel_diff = std::max(pixel_diff, d);
+                    sum_diff += d;
+                }
+                max_diff = std::max(max_diff, pixel_diff);
+                large += pixel_diff > 8;
+            }
+            if (v == 0 && !prefix.empty()) {
+                for (std::vector<uint8_t>* image : { &quads, &tiles }) {
+                    for (size_t p = 0; p < size_t(WIDTH) * HEIGHT; ++p) (*image)[4 * p + 3] = 255;
+                }
+                ImageWriter::encode(prefix + mode.name + "_quads.png", WIDTH, HEIGHT, quads);
+                ImageWriter::encode(prefix + mode.name + "_tiles.png", WIDTH, HEIGHT, tiles);
+            }
+        }
+        std::sort(t_quads.begin(), t_quads.end());
+        std::sort(t_tiles.begin(), t_tiles.end());
+        const double pixels = double(WIDTH) * HEIGHT * views.size();
+        printf("%-6s %12.1f %12.1f %10zu %10d %12.3f %11.2f%%\n", mode.name, t_quads[t_quads.size() / 2] * 1e3,
+               t_tiles[t_tiles.size() / 2] * 1e3, entries / views.size(), max_diff, sum_diff / (3.0 * pixels),
+               100.0 * large / pixels);
+    }
+
+    if (generated) std::remove(filename.c_str());
+    return 0;
+}
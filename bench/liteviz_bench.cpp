@@ -0,0 +1,317 @@
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <numeric>
+#include <algorithm>
+#include <tbb/parallel_for.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/culling.h>
+#include <liteviz/sorter.h>
+#include "bench_common.h"
+#ifdef LITEVIZ_BENCH_GPU
+#include <liteviz/headless.h>
+#include <liteviz/renderer.h>
+#endif
+
+// The whole pipeline on generated scenes, one result per component, scene
+// size and camera path, for comparing commits:
+//   load       GaussianData::load_ply() of the scene file, page cache warm
+//   pack       the fp32 rows Renderer uploads, covariance in place of
+//              quaternion and scale (what flat() used to build)
+//   cull       FrustumCuller::cull() per frame
+//   sort       DepthSorter::sort() of every splat per frame
+//   coherent   CoherentSorter::sort() per frame, following the path
+//   upload     Renderer construction: scene buffers, staging and first sort
+//   render     one offscreen frame, sorted for its camera, to glFinish()
+//   gpu-sort   the same frame depth-sorted in compute shaders (gpu_sort)
+//   tiles      the same frame from the compute tile renderer (tile_render)
+// Per-frame results are the median over the path, with the mean beside it,
+// which coherent sorting skews. Scenes and paths come from fixed seeds, so
+// runs on different commits see the same input.
+// The GPU part needs EGL (Mesa llvmpipe will do); without it, or with
+// --no-gpu, only the CPU components run.
+
+static const char* usage =
+    "usage: liteviz-bench [options]\n"
+    "  --sizes LIST     splat counts, e.g. 10k,100k,1M,20M (default 10k,100k,1M)\n"
+    "  --sh DEGREE      SH degree of the scenes, 0-3 (default 3)\n"
+    "  --layout NAME    uniform | clustered | surface (default uniform)\n"
+    "  --frames N       frames per camera path (default 60)\n"
+    "  --reps N         repetitions of the one-shot components, median taken (default 3)\n"
+    "  --size W H       render size (default 1280 720)\n"
+    "  --no-gpu         skip upload and render\n"
+    "  --json FILE      write the results as JSON\n"
+    "  --tag TEXT       label for the run in the JSON, e.g. the commit\n";
+
+struct Result {
+    std::string component;
+    size_t      splats;
+    std::string path;       // camera path, empty for one-shot components
+    double      median;     // seconds
+    double      mean;
+    bool        frames;     // per_second counts frames rather than splats
+};
+
+static double median(std::vector<double> times) {
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+static double mean(const std::vector<double>& times) {
+    return std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+}
+
+// 10k, 1.5M, 20000000
+static bool parse_sizes(const std::string& list, std::vector<size_t>& sizes) {
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        const std::string item = list.substr(start, end - start);
+        size_t used = 0;
+        double value;
+        try {
+            value = std::stod(item, &used);
+        } catch (const std::exception&) {
+            return false;
+        }
+        const std::string suffix = item.substr(used);
+        if (suffix == "k" || suffix == "K") value *= 1e3;
+        else if (suffix == "m" || suffix == "M") value *= 1e6;
+        else if (!suffix.empty()) return false;
+        if (value < 1.0) return false;
+        sizes.push_back(static_cast<size_t>(value));
+        start = end + 1;
+    }
+    return !sizes.empty();
+}
+
+static std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out + "\"";
+}
+
+int main(int argc, char** argv) {
+
+    std::vector<size_t> sizes;
+    int sh_degree = 3, frames = 60, reps = 3, width = 1280, height = 720;
+    SceneLayout layout = SceneLayout::UNIFORM;
+    std::string layout_name = "uniform", json_file, tag;
+    bool gpu = true;
+
+    const std::pair<std::string, SceneLayout> layouts[] = {
+        { "uniform", SceneLayout::UNIFORM }, { "clustered", SceneLayout::CLUSTERED }, { "surface", SceneLayout::SURFACE },
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        bool known = true;
+        if (arg == "--sizes" && i + 1 < argc) {
+            known = parse_sizes(argv[++i], sizes);
+        } else if (arg == "--sh" && i + 1 < argc) {
+            sh_degree = std::stoi(argv[++i]);
+            known = sh_degree >= 0 && sh_degree <= 3;
+        } else if (arg == "--layout" && i + 1 < argc) {
+            layout_name = argv[++i];
+            known = false;
+            for (const auto& l : layouts) {
+                if (l.first == layout_name) {
+                    layout = l.second;
+                    known = true;
+                }
+            }
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frames = std::stoi(argv[++i]);
+            known = frames > 0;
+        } else if (arg == "--reps" && i + 1 < argc) {
+            reps = std::stoi(argv[++i]);
+            known = reps > 0;
+        } else if (arg == "--size" && i + 2 < argc) {
+            width = std::stoi(argv[++i]);
+            height = std::stoi(argv[++i]);
+        } else if (arg == "--no-gpu") {
+            gpu = false;
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_file = argv[++i];
+        } else if (arg == "--tag" && i + 1 < argc) {
+            tag = argv[++i];
+        } else {
+            known = false;
+        }
+        if (!known) {
+            fprintf(stderr, "%s", usage);
+            return 1;
+        }
+    }
+    if (sizes.empty()) sizes = { 10000, 100000, 1000000 };
+
+    const std::pair<std::string, CameraScript> scripts[] = {
+        { "orbit", CameraScript::ORBIT }, { "fly", CameraScript::FLY }, { "zoom", CameraScript::ZOOM },
+    };
+    std::vector<std::vector<Eigen::Matrix4f>> paths;
+    for (const auto& s : scripts) paths.push_back(camera_script(s.second, frames));
+
+    const float fov = 60.0f;
+    const Eigen::Matrix4f projmat = perspective(fov, float(width) / height, 0.1f, 1000.0f);
+
+    std::string renderer_name = "none";
+#ifdef LITEVIZ_BENCH_GPU
+    HeadlessContext context;
+    if (gpu && !context.init()) {
+        fprintf(stderr, "Failed to init the offscreen context, skipping upload and render\n");
+        gpu = false;
+    }
+    if (gpu) renderer_name = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+#else
+    gpu = false;
+#endif
+
+    printf("%u threads, GL renderer: %s\n", std::thread::hardware_concurrency(), renderer_name.c_str());
+    printf("%-10s %10s %-6s %12s %12s %14s\n", "component", "splats", "path", "median(ms)", "mean(ms)", "per second");
+
+    std::vector<Result> results;
+    auto report = [&](const Result& r) {
+        const double rate = (r.frames ? 1.0 : double(r.splats)) / r.median;
+        printf("%-10s %10zu %-6s %12.3f %12.3f %14.4g\n", r.component.c_str(), r.splats,
+               r.path.empty() ? "-" : r.path.c_str(), r.median * 1e3, r.mean * 1e3, rate);
+        fflush(stdout);
+        results.push_back(r);
+    };
+
+    for (size_t N : sizes) {
+        const std::string filename = "liteviz_bench_" + std::to_string(N) + ".ply";
+        write_scene_ply(filename, N, sh_degree, layout);
+
+        GaussianData data;
+        const double t_load = bench_median([&]() { data = GaussianData::load_ply(filename.c_str(), 3); }, reps);
+        report({ "load", N, "", t_load, t_load, false });
+        std::remove(filename.c_str());
+
+        const size_t cols = data.attributes.cols();
+        GaussianData::Attributes rows(N, cols);
+        const double t_pack = bench_median([&]() {
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, N, 1 << 12),
+                [&](const tbb::blocked_range<size_t>& r) {
+                    for (size_t i = r.begin(); i < r.end(); ++i) {
+                        rows.row(i) = data.attributes.row(i);
+                        data.covariance(i, &rows(i, GaussianData::ROT));
+                        rows(i, GaussianData::ROT + GaussianData::COV_DIM) = 0.0f;
+                    }
+                });
+        }, reps);
+        report({ "pack", N, "", t_pack, t_pack, false });
+        rows.resize(0, 0);
+
+        std::vector<float> radius(N);
+        FrustumCuller::boundingRadii(data, 0, N, radius.data());
+        FrustumCuller culler;
+        DepthSorter sorter;
+        CoherentSorter coherent;
+        std::vector<uint32_t> index(N), coherent_index;
+
+        for (size_t p = 0; p < paths.size(); ++p) {
+            std::vector<double> cull, sort, coherent_sort;
+            size_t visible = 0;
+            coherent.reset();
+            for (const Eigen::Matrix4f& viewmat : paths[p]) {
+                const FrustumCuller::Planes planes = FrustumCuller::planes(projmat, viewmat);
+                Timer timer;
+                visible += culler.cull(data.xyz.data(), radius.data(), N, 3.0f, planes);
+                cull.push_back(timer.elapsed());
+
+                timer.reset();
+                sorter.sort(data.xyz, viewmat, index.data());
+                sort.push_back(timer.elapsed());
+
+                timer.reset();
+                coherent.sort(data.xyz, viewmat, coherent_index);
+                coherent_sort.push_back(timer.elapsed());
+            }
+            report({ "cull", N, scripts[p].first, median(cull), mean(cull), false });
+            report({ "sort", N, scripts[p].first, median(sort), mean(sort), false });
+            report({ "coherent", N, scripts[p].first, median(coherent_sort), mean(coherent_sort), false });
+            // keeps the culling from being optimized out, and shows what the path sees
+            printf("%-10s %10zu %-6s %11.1f%% visible\n", "", N, scripts[p].first.c_str(), 100.0 * visible / (double(N) * frames));
+        }
+
+#ifdef LITEVIZ_BENCH_GPU
+        if (!gpu) continue;
+
+        const std::string shader_path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+        Shader shader((shader_path + "/draw_splat.vert").c_str(), (shader_path + "/draw_splat.frag").c_str(), false,
+                      Renderer::shaderDefines(data));
+        std::unique_ptr<Renderer> renderer;
+        const double t_upload = bench_median([&]() {
+            renderer.reset();
+            renderer = std::make_unique<Renderer>(data, &shader);
+            glFinish();
+        }, reps);
+        report({ "upload", N, "", t_upload, t_upload, false });
+
+        RenderConfig& config = renderer->config();
+        config.fov = fov;
+        // as liteviz-render: every frame sorted for its own camera on this thread
+        config.async_sort = false;
+        config.color_cache = false;
+
+        OffscreenTarget target(width, height);
+        Viewport viewport(width, height);
+        viewport.frameBufferSize = Eigen::Vector2i(width, height);
+        viewport.setFoV(fov);
+        const Eigen::Vector4f clear_color(0.0f, 0.0f, 0.0f, 0.0f);
+
+        struct Variant { const char* component; bool gpu_sort, tiles; };
+        for (const Variant& variant : { Variant{ "render", false, false }, Variant{ "gpu-sort", true, false },
+                                        Variant{ "tiles", false, true } }) {
+            config.gpu_sort = variant.gpu_sort;
+            config.tile_render = variant.tiles;
+            for (size_t p = 0; p < paths.size(); ++p) {
+                std::vector<double> frame, draw;
+                for (const Eigen::Matrix4f& viewmat : paths[p]) {
+                    viewport.setViewMatrix(viewmat.inverse());
+                    Timer timer;
+                    target.bind();
+                    glClearBufferfv(GL_COLOR, 0, clear_color.data());
+                    renderer->render(viewport);
+                    glFinish();
+                    frame.push_back(timer.elapsed());
+                    draw.push_back(frame.back() - renderer->timings().sort - renderer->timings().upload);
+                }
+                report({ variant.component, N, scripts[p].first, median(frame), mean(frame), true });
+                printf("%-10s %10zu %-6s %11.3f ms drawing, the rest sort and index upload\n", "", N,
+                       scripts[p].first.c_str(), median(draw) * 1e3);
+            }
+        }
+#endif
+    }
+
+    if (json_file.empty()) return 0;
+
+    FILE* out = fopen(json_file.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "Failed to open %s\n", json_file.c_str());
+        return 1;
+    }
+    fprintf(out, "{\n  \"tool\": \"liteviz-bench\",\n  \"tag\": %s,\n  \"threads\": %u,\n  \"gl_renderer\": %s,\n",
+            json_string(tag).c_str(), std::thread::hardware_concurrency(), json_string(renderer_name).c_str());
+    fprintf(out, "  \"config\": { \"sh_degree\": %d, \"layout\": %s, \"frames\": %d, \"reps\": %d, \"width\": %d, \"height\": %d },\n",
+            sh_degree, json_string(layout_name).c_str(), frames, reps, width, height);
+    fprintf(out, "  \"results\": [");
+    for (size_t k = 0; k < results.size(); ++k) {
+        const Result& r = results[k];
+        fprintf(out, "%s\n    { \"component\": %s, \"splats\": %zu, \"path\": %s, \"median_ms\": %.4f, \"mean_ms\": %.4f, "
+                "\"per_second\": %.6g, \"unit\": \"%s\" }", k ? "," : "", json_string(r.component).c_str(), r.splats,
+                r.path.empty() ? "null" : json_string(r.path).c_str(), r.median * 1e3, r.mean * 1e3,
+                (r.frames ? 1.0 : double(r.splats)) / r.median, r.frames ? "frames" : "splats");
+    }
+    fprintf(out, "\n  ]\n}\n");
+    const bool ok = fclose(out) == 0;
+    if (!ok) fprintf(stderr, "Failed to write %s\n", json_file.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,29 @@
+if(NOT TARGET depends::lz4)
+  if(NOT TARGET options::modern-cpp)
+    message(FATAL_ERROR "depends::lz4 expects options::modern-cpp")
+  endif()
+  FetchContent_Declare(
+    depends-lz4
+    GIT_REPOSITORY https://github.com/lz4/lz4.git
+    GIT_TAG        v1.9.4
+  )
+  FetchContent_GetProperties(depends-lz4)
+  if(NOT depends-lz4_POPULATED)
+    message(STATUS "Fetching lz4 sources")
+    FetchContent_Populate(depends-lz4)
+    message(STATUS "Fetching lz4 sources - done")
+  endif()
+
+  add_library(depends_lz4 STATIC
+    ${depends-lz4_SOURCE_DIR}/lib/lz4.c
+  )
+
+  target_include_directories(depends_lz4 PUBLIC
+    ${depends-lz4_SOURCE_DIR}/lib
+  )
+
+  set_target_properties(depends_lz4 PROPERTIES POSITION_INDEPENDENT_CODE ON)
+  add_library(depends::lz4 ALIAS depends_lz4)
+  set(depends-lz4-source-dir ${depends-lz4_SOURCE_DIR} CACHE INTERNAL "" FORCE)
+  mark_as_advanced(depends-lz4-source-dir)
+endif()
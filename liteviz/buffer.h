@@ -0,0 +1,228 @@
+#ifndef __BUFFER_H__
+#define __BUFFER_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <glad/glad.h>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT   0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT     0x0080
+#endif
+
+// Fence syncs have no names that glIs*() could find, so they are made and
+// deleted through these, which keep count of the live ones for
+// test-gl-objects. GL context thread only.
+inline int& liveSyncs() {
+    static int count = 0;
+    return count;
+}
+
+inline GLsync fenceSync() {
+    ++liveSyncs();
+    return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+inline void deleteSync(GLsync sync) {
+    if (!sync) return;
+    --liveSyncs();
+    glDeleteSync(sync);
+}
+
+// Streaming SSBO for per-frame data such as the sorted splat order. The GL
+// buffer is created once and only reallocated when the capacity has to grow.
+//  - GL 4.4+: immutable storage split into RING_SIZE sections that stay mapped
+//    for the buffer's lifetime; a fence per section keeps the CPU from
+//    overwriting data the GPU is still reading.
+//  - otherwise: the storage is orphaned with glBufferData(nullptr) and refilled
+//    with glBufferSubData from a host staging copy.
+// Per frame: ptr = map(count), write count elements, commit(binding), draw, fence().
+// The mapping is write-only: fill it in one pass, never read it back.
+class StreamBuffer {
+
+public:
+    static constexpr int RING_SIZE = 3;
+
+    StreamBuffer() = default;
+
+    ~StreamBuffer() {
+        release();
+    }
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // glad here covers GL 4.3 core, so glBufferStorage (4.4) is looked up by
+    // hand through the loader glad was given. Call after gladLoadGLLoader().
+    static void setProcLoader(GLADloadproc loader) { procLoader() = loader; }
+
+    bool persistent() const { return _persistent; }
+
+    GLuint id() const { return _buffer; }
+
+    // Returns memory for count elements of the next section.
+    uint32_t* map(size_t count) {
+
+        reserve(count);
+        _count = count;
+
+        if (!_persistent) {
+            return _staging.data();
+        }
+
+        _section = (_section + 1) % RING_SIZE;
+        waitFence(_section);
+        return reinterpret_cast<uint32_t*>(_mapped + _section * _section_bytes);
+    }
+
+    // Makes the last mapped section visible to the shader at the given binding.
+    void commit(GLuint binding) {
+
+        const size_t bytes = _count * sizeof(uint32_t);
+
+        if (_persistent) {
+            if (bytes > 0) {
+                glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, _buffer, _section * _section_bytes, bytes);
+            }
+            return;
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, _capacity * sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, _staging.data());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, _buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    // Rebinds the last committed data without touching it.
+    void bind(GLuint binding) {
+        if (_persistent) {
+            if (_count > 0) {
+                glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, _buffer, _section * _section_bytes, _count * sizeof(uint32_t));
+            }
+        } else {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, _buffer);
+        }
+    }
+
+    // Call after the draw that reads the committed section.
+    void fence() {
+        if (!_persistent) return;
+        if (_fences[_section]) {
+            deleteSync(_fences[_section]);
+        }
+        _fences[_section] = fenceSync();
+    }
+
+    void upload(const uint32_t* data, size_t count, GLuint binding) {
+        std::memcpy(map(count), data, count * sizeof(uint32_t));
+        commit(binding);
+    }
+
+private:
+
+    typedef void (APIENTRY *BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    static GLADloadproc& procLoader() {
+        static GLADloadproc loader = nullptr;
+        return loader;
+    }
+
+    static BufferStorageProc bufferStorage() {
+        static BufferStorageProc proc = []() -> BufferStorageProc {
+            GLint major = 0, minor = 0;
+            glGetIntegerv(GL_MAJOR_VERSION, &major);
+            glGetIntegerv(GL_MINOR_VERSION, &minor);
+            if (major * 10 + minor < 44) return nullptr;
+            BufferStorageProc storage = procLoader() ?
+                reinterpret_cast<BufferStorageProc>(procLoader()("glBufferStorage")) : nullptr;
+            if (!storage) {
+                std::cout << "GL " << major << "." << minor << " without glBufferStorage, "
+                          << "streaming the sort order through glBufferSubData" << std::endl;
+            }
+            return storage;
+        }();
+        return proc;
+    }
+
+    void reserve(size_t count) {
+
+        if (_buffer != 0 && count <= _capacity) return;
+
+        release();
+
+        // grow geometrically so a scene that is still streaming in does not
+        // reallocate on every frame
+        _capacity = std::max<size_t>(count + count / 2, 1024);
+
+        glGenBuffers(1, &_buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _buffer);
+
+        BufferStorageProc storage = bufferStorage();
+        _persistent = storage != nullptr;
+
+        if (_persistent) {
+            GLint alignment = 1;
+            glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            _section_bytes = (_capacity * sizeof(uint32_t) + alignment - 1) / alignment * alignment;
+
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            storage(GL_SHADER_STORAGE_BUFFER, _section_bytes * RING_SIZE, nullptr, flags);
+            _mapped = static_cast<uint8_t*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, _section_bytes * RING_SIZE, flags));
+            _persistent = _mapped != nullptr;
+        }
+
+        if (!_persistent) {
+            glBufferData(GL_SHADER_STORAGE_BUFFER, _capacity * sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+            _staging.resize(_capacity);
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void waitFence(int section) {
+        GLsync& fence = _fences[section];
+        if (!fence) return;
+        while (true) {
+            GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED) break;
+        }
+        deleteSync(fence);
+        fence = nullptr;
+    }
+
+    void release() {
+        if (_buffer == 0) return;
+        for (int i = 0; i < RING_SIZE; ++i) {
+            waitFence(i);
+        }
+        if (_mapped) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, _buffer);
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            _mapped = nullptr;
+        }
+        glDeleteBuffers(1, &_buffer);
+        _buffer = 0;
+        _capacity = 0;
+        _count = 0;
+        _staging.clear();
+    }
+
+    GLuint                  _buffer         = 0;
+    bool                    _persistent     = false;
+    size_t                  _capacity       = 0;    // elements per section
+    size_t                  _count          = 0;
+    size_t                  _section_bytes  = 0;
+    int                     _section        = 0;
+    uint8_t*                _mapped         = nullptr;
+    GLsync                  _fences[RING_SIZE] = {};
+    std::vector<uint32_t>   _staging;
+};
+
+#endif // __BUFFER_H__
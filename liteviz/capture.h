@@ -0,0 +1,158 @@
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <glad/glad.h>
+#include <liteviz/buffer.h>
+#include <liteviz/utils.h>
+#include <liteviz/image_writer.h>
+
+// Asynchronous readback of rendered frames. capture() only queues a
+// glReadPixels into one of RING_SIZE pixel pack buffers behind a fence, so
+// the copy runs on the GPU while the CPU goes on with the next frames;
+// poll() maps the buffers whose fence has passed and hands the pixels to
+// an ImageWriter, which encodes them on its own threads. The CPU waits on
+// the GPU only when all RING_SIZE buffers are still in flight.
+class FrameCapture {
+
+public:
+    static constexpr int RING_SIZE = 3;
+
+    struct Stats {
+        size_t  captured    = 0;    // frames handed to the writer
+        size_t  dropped     = 0;    // frames the writer had no room for
+        size_t  stalls      = 0;    // capture() found the ring full and waited for the GPU
+        double  map         = 0.0;  // seconds spent mapping and copying out the pixel buffers
+    };
+
+    explicit FrameCapture(int threads = 2): _writer(threads, 2 * RING_SIZE) {}
+
+    ~FrameCapture() {
+        flush();
+        release();
+    }
+
+    // Reads width x height pixels of the current read framebuffer into the
+    // next buffer of the ring; they are written to path once the GPU is done.
+    // droppable: the frame may be skipped if the encoders fall behind, rather
+    // than stalling the caller (for recording at full frame rate).
+    void capture(int width, int height, const std::string& path, bool droppable = false) {
+
+        if (width != _width || height != _height) {
+            flush();
+            allocate(width, height);
+        }
+        if (_pending == RING_SIZE) {
+            ++_stats.stalls;
+            retire(true);
+        }
+
+        Slot& slot = _slots[(_oldest + _pending) % RING_SIZE];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.fence = fenceSync();
+        slot.path = path;
+        slot.droppable = droppable;
+        ++_pending;
+    }
+
+    // Hands every finished readback to the writer without waiting; call once a frame.
+    void poll() {
+        while (_pending > 0 && retire(false)) {}
+    }
+
+    // Waits for every captured frame to reach the disk.
+    void flush() {
+        while (_pending > 0) retire(true);
+        _writer.finish();
+    }
+
+    // frames captured but not yet mapped
+    int pending() const { return _pending; }
+
+    const Stats& stats() const { return _stats; }
+
+    ImageWriter::Stats writerStats() { return _writer.stats(); }
+
+private:
+    struct Slot {
+        GLuint          pbo         = 0;
+        GLsync          fence       = nullptr;
+        std::string     path;
+        bool            droppable   = false;
+    };
+
+    // Maps the oldest readback in flight and queues it for encoding; false
+    // if its fence has not passed and wait is not set.
+    bool retire(bool wait) {
+
+        Slot& slot = _slots[_oldest];
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (wait && status == GL_TIMEOUT_EXPIRED) {
+            status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        }
+        if (status == GL_TIMEOUT_EXPIRED) return false;
+        deleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        Timer timer;
+        const size_t bytes = size_t(_width) * _height * 4;
+        std::vector<uint8_t> rgba(bytes);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        if (const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT)) {
+            std::memcpy(rgba.data(), pixels, bytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        _stats.map += timer.elapsed();
+
+        if (!slot.droppable) {
+            _writer.write(slot.path, _width, _height, std::move(rgba));
+            ++_stats.captured;
+        } else if (_writer.tryWrite(slot.path, _width, _height, std::move(rgba))) {
+            ++_stats.captured;
+        } else {
+            ++_stats.dropped;
+        }
+
+        _oldest = (_oldest + 1) % RING_SIZE;
+        --_pending;
+        return true;
+    }
+
+    void allocate(int width, int height) {
+        release();
+        _width = width;
+        _height = height;
+        for (Slot& slot : _slots) {
+            glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, size_t(width) * height * 4, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    void release() {
+        for (Slot& slot : _slots) {
+            if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+        }
+        _width = _height = 0;
+    }
+
+    ImageWriter                     _writer;
+    std::array<Slot, RING_SIZE>     _slots;
+    int                             _oldest     = 0;
+    int                             _pending    = 0;
+    int                             _width      = 0;
+    int                             _height     = 0;
+    Stats                           _stats;
+};
+
+#endif // __CAPTURE_H__
@@ -0,0 +1,117 @@
+#ifndef __COLOR_CACHE_H__
+#define __COLOR_CACHE_H__
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
+#include <liteviz/dataloader.h>
+
+// Bookkeeping for the view-dependent color cache that bake_color.comp fills:
+// the splats are grouped into regions of REGION_SIZE consecutive splats along
+// a Morton curve, so each region is spatially compact, and a region is only
+// re-baked once the camera has moved far enough to turn a view direction
+// inside it by more than the given angle. A move by d seen from distance r
+// turns directions by at most asin(d / r), so nearby regions re-bake often
+// and distant ones rarely.
+class ColorCache {
+
+public:
+    static constexpr uint32_t REGION_SIZE = 4096;
+    static constexpr size_t   GRAIN       = 1 << 14;
+
+    using Range = std::array<uint32_t, 2>;     // [begin, end) of order()
+
+    bool empty() const { return _order.empty(); }
+
+    // Groups the first count rows of xyz into regions, all of them stale.
+    void build(const GaussianData::Positions& xyz, size_t count) {
+
+        Eigen::AlignedBox3f box = tbb::parallel_reduce(
+            tbb::blocked_range<size_t>(0, count, GRAIN), Eigen::AlignedBox3f(),
+            [&](const tbb::blocked_range<size_t>& r, Eigen::AlignedBox3f b) {
+                for (size_t i = r.begin(); i < r.end(); ++i) b.extend(xyz.row(i).transpose());
+                return b;
+            },
+            [](const Eigen::AlignedBox3f& a, const Eigen::AlignedBox3f& b) { return a.merged(b); });
+
+        // 10 bits per axis is plenty for regions of thousands of splats
+        const Eigen::Array3f scale = 1023.0f / box.sizes().array().max(1e-12f);
+        std::vector<std::pair<uint32_t, uint32_t>> keys(count);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, count, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    const Eigen::Array3f q = (xyz.row(i).transpose() - box.min()).array() * scale;
+                    keys[i] = { spread(uint32_t(q.x())) | spread(uint32_t(q.y())) << 1 | spread(uint32_t(q.z())) << 2,
+                                static_cast<uint32_t>(i) };
+                }
+            });
+        tbb::parallel_sort(keys.begin(), keys.end());
+
+        _order.resize(count);
+        for (size_t k = 0; k < count; ++k) _order[k] = keys[k].second;
+
+        const size_t regions = (count + REGION_SIZE - 1) / REGION_SIZE;
+        _bounds.assign(regions, Eigen::AlignedBox3f());
+        tbb::parallel_for(size_t(0), regions, [&](size_t g) {
+            const size_t end = std::min(count, (g + 1) * REGION_SIZE);
+            for (size_t k = g * REGION_SIZE; k < end; ++k) _bounds[g].extend(xyz.row(_order[k]).transpose());
+        });
+        _baked_eye.resize(regions);
+        invalidate();
+    }
+
+    // every region stale, e.g. after the SH degree drawn changed
+    void invalidate() { _valid.assign(_bounds.size(), false); }
+
+    // Regions to re-bake for a camera at eye so that no cached color is off
+    // by more than angle (radians) of view direction; they count as baked
+    // from eye from now on.
+    const std::vector<Range>& update(const Eigen::Vector3f& eye, float angle) {
+        const float sin_angle = std::sin(std::min(angle, float(M_PI) / 2.0f));
+        _stale.clear();
+        _baked = 0;
+        for (size_t g = 0; g < _bounds.size(); ++g) {
+            const float moved = (eye - _baked_eye[g]).norm();
+            if (_valid[g] && moved <= sin_angle * _bounds[g].exteriorDistance(eye)) continue;
+            const uint32_t begin = static_cast<uint32_t>(g * REGION_SIZE);
+            const uint32_t end = static_cast<uint32_t>(std::min(_order.size(), (g + 1) * size_t(REGION_SIZE)));
+            _stale.push_back({ begin, end });
+            _baked += end - begin;
+            _baked_eye[g] = eye;
+            _valid[g] = true;
+        }
+        return _stale;
+    }
+
+    // splats grouped by region, the order bake_color.comp walks
+    const std::vector<uint32_t>& order() const { return _order; }
+
+    // splats re-baked by the last update()
+    size_t baked() const { return _baked; }
+
+private:
+    static uint32_t spread(uint32_t v) {
+        v = std::min(v, 1023u);
+        v = (v | v << 16) & 0x030000ff;
+        v = (v | v << 8)  & 0x0300f00f;
+        v = (v | v << 4)  & 0x030c30c3;
+        v = (v | v << 2)  & 0x09249249;
+        return v;
+    }
+
+    std::vector<uint32_t>               _order;
+    std::vector<Eigen::AlignedBox3f>    _bounds;        // per region, of the splat centers
+    std::vector<Eigen::Vector3f>        _baked_eye;     // per region, camera of the last bake
+    std::vector<bool>                   _valid;
+    std::vector<Range>                  _stale;
+    size_t                              _baked = 0;
+};
+
+#endif // __COLOR_CACHE_H__
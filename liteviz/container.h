@@ -0,0 +1,333 @@
+#ifndef __CONTAINER_H__
+#define __CONTAINER_H__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include <Eigen/Geometry>
+#include <lz4.h>
+#include <tbb/parallel_for.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/ply_reader.h>
+
+// liteviz native scene file (.lvz). Splats are stored already activated and in
+// the in-memory layout of GaussianData (fp32 or compact), cut into chunks whose
+// position and attribute blocks are LZ4 compressed independently, so loading
+// is a mmap plus one decompression per block straight into place.
+//
+//  LvzHeader | sh_range (2 x sh_dim floats, SH_UINT8 only) | LvzChunk[num_chunks]
+//            | LvzBounds[num_chunks] (LVZ_SPATIAL only) | blocks
+struct LvzHeader {
+    char        magic[4];       // "LVZ1"
+    uint32_t    version;
+    uint64_t    count;          // number of splats
+    uint32_t    storage;        // GaussianData::Storage
+    uint32_t    sh_dim;
+    uint32_t    stride;         // floats (FP32) or words (compact) per attribute row
+    uint32_t    chunk_size;     // splats per chunk, the last one may be shorter
+    uint32_t    num_chunks;
+    uint32_t    flags;
+};
+
+struct LvzChunk {
+    uint64_t    offset[2];      // file offset of the position / attribute block
+    uint32_t    bytes[2];       // stored size, equal to the raw size when not compressed
+    uint32_t    count;          // splats in this chunk
+    uint32_t    reserved;
+};
+
+// per chunk, for out-of-core paging (see ChunkPager)
+struct LvzBounds {
+    float       min[3];         // splat centers
+    float       max[3];
+    float       radius;         // largest splat scale
+    uint32_t    reserved;
+};
+
+// LvzHeader::flags
+constexpr uint32_t LVZ_IMPORTANCE_ORDER = 1;    // splats sorted by GaussianData::importanceOrder()
+constexpr uint32_t LVZ_SPATIAL          = 2;    // splats in Morton order, chunk bounds stored
+
+static_assert(sizeof(LvzHeader) == 40, "LvzHeader layout is part of the file format");
+static_assert(sizeof(LvzChunk) == 32, "LvzChunk layout is part of the file format");
+static_assert(sizeof(LvzBounds) == 32, "LvzBounds layout is part of the file format");
+
+// Chunk-level access to a .lvz file: allocate() sizes a GaussianData for the
+// whole scene, then read(c) fills chunk c in place. Chunks touch disjoint rows,
+// so they can be read in any order and from any thread.
+class LvzReader {
+
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    explicit LvzReader(const char* filename): _file(filename), _filename(filename) {
+
+        if (_file.size() < sizeof(_header)) {
+            throw std::runtime_error("Truncated .lvz file: " + _filename);
+        }
+        std::memcpy(&_header, _file.data(), sizeof(_header));
+        if (std::memcmp(_header.magic, "LVZ1", 4) != 0 || _header.version != VERSION ||
+            _header.storage > GaussianData::COMPACT_UINT8) {
+            throw std::runtime_error("Not a supported .lvz file: " + _filename);
+        }
+
+        const size_t N = _header.count;
+        const size_t table_offset = sizeof(LvzHeader) + rangeFloats() * sizeof(float);
+
+        if (_header.chunk_size == 0 || _header.num_chunks != (N + _header.chunk_size - 1) / _header.chunk_size ||
+            table_offset + _header.num_chunks * sizeof(LvzChunk) > _file.size()) {
+            throw std::runtime_error("Corrupt .lvz header: " + _filename);
+        }
+
+        _chunks.resize(_header.num_chunks);
+        std::memcpy(_chunks.data(), _file.data() + table_offset, _chunks.size() * sizeof(LvzChunk));
+
+        if (_header.flags & LVZ_SPATIAL) {
+            const size_t bounds_offset = table_offset + _chunks.size() * sizeof(LvzChunk);
+            if (bounds_offset + _chunks.size() * sizeof(LvzBounds) > _file.size()) {
+                throw std::runtime_error("Truncated .lvz file: " + _filename);
+            }
+            _bounds.resize(_chunks.size());
+            std::memcpy(_bounds.data(), _file.data() + bounds_offset, _bounds.size() * sizeof(LvzBounds));
+        }
+
+        // start reading the blocks in the background while the storage is allocated
+        _file.prefetch(table_offset, _file.size() - table_offset);
+    }
+
+    const LvzHeader& header() const { return _header; }
+
+    size_t chunks() const { return _chunks.size(); }
+
+    // number of splats held by chunks [0, c]
+    size_t chunkEnd(size_t c) const {
+        return std::min<size_t>((c + 1) * size_t(_header.chunk_size), _header.count);
+    }
+
+    const LvzChunk& chunk(size_t c) const { return _chunks[c]; }
+
+    // per chunk, empty unless the file is LVZ_SPATIAL
+    const std::vector<LvzBounds>& bounds() const { return _bounds; }
+
+    // bytes of one attribute row in the file's storage
+    size_t rowBytes() const { return _header.stride * sizeof(uint32_t); }
+
+    // Sizes data in the file's storage format, for the whole scene or for
+    // rows splats when given.
+    void allocate(GaussianData& data, size_t rows = SIZE_MAX) const {
+
+        const size_t N = rows == SIZE_MAX ? _header.count : rows;
+        const GaussianData::Storage storage = static_cast<GaussianData::Storage>(_header.storage);
+
+        data.xyz.resize(N, 3);
+        if (storage == GaussianData::FP32) {
+            if (_header.stride != static_cast<uint32_t>(GaussianData::SH) + _header.sh_dim) {
+                throw std::runtime_error("Corrupt .lvz header: " + _filename);
+            }
+            data.attributes.resize(N, _header.stride);
+            data.packed = CompactSplats();
+        } else {
+            CompactSplats& packed = data.packed;
+            packed.sh_format = GaussianData::shFormat(storage);
+            packed.sh_dim = _header.sh_dim;
+            packed.stride = _header.stride;
+            if (packed.stride != CompactSplats::SH_WORD + CompactSplats::shWords(packed.sh_dim, packed.sh_format)) {
+                throw std::runtime_error("Corrupt .lvz header: " + _filename);
+            }
+            packed.words.resize(N * packed.stride);
+            packed.sh_range.resize(rangeFloats());
+            std::memcpy(packed.sh_range.data(), _file.data() + sizeof(LvzHeader), rangeFloats() * sizeof(float));
+            data.attributes.resize(0, 0);
+        }
+    }
+
+    // Fills chunk c's rows of data allocated for the whole scene.
+    void read(size_t c, GaussianData& data) const {
+        read(c, data, c * _header.chunk_size);
+    }
+
+    // Fills rows [row, row + chunk size) of data with chunk c.
+    void read(size_t c, GaussianData& data, size_t row) const {
+
+        uint8_t* targets[2] = {
+            reinterpret_cast<uint8_t*>(data.xyz.data()),
+            data.isCompact() ? reinterpret_cast<uint8_t*>(data.packed.words.data())
+                             : reinterpret_cast<uint8_t*>(data.attributes.data())
+        };
+        const size_t row_bytes[2] = { 3 * sizeof(float), rowBytes() };
+
+        const LvzChunk& chunk = _chunks[c];
+        const size_t first = c * _header.chunk_size;
+        if (chunk.count != chunkEnd(c) - first || row + chunk.count > data.size()) {
+            throw std::runtime_error("Corrupt .lvz chunk table: " + _filename);
+        }
+        for (int b = 0; b < 2; ++b) {
+            const size_t raw = chunk.count * row_bytes[b];
+            if (chunk.offset[b] + chunk.bytes[b] > _file.size()) {
+                throw std::runtime_error("Truncated .lvz file: " + _filename);
+            }
+            const char* src = reinterpret_cast<const char*>(_file.data() + chunk.offset[b]);
+            char* dst = reinterpret_cast<char*>(targets[b] + row * row_bytes[b]);
+            if (chunk.bytes[b] == raw) {
+                std::memcpy(dst, src, raw);
+            } else if (LZ4_decompress_safe(src, dst, static_cast<int>(chunk.bytes[b]), static_cast<int>(raw)) != static_cast<int>(raw)) {
+                throw std::runtime_error("Corrupt .lvz block: " + _filename);
+            }
+        }
+    }
+
+private:
+    size_t rangeFloats() const {
+        return _header.storage == GaussianData::COMPACT_UINT8 ? 2 * _header.sh_dim : 0;
+    }
+
+    MappedFile              _file;
+    std::string             _filename;
+    LvzHeader               _header;
+    std::vector<LvzChunk>   _chunks;
+    std::vector<LvzBounds>  _bounds;
+};
+
+class SceneContainer {
+
+public:
+    static constexpr uint32_t   DEFAULT_CHUNK_SIZE  = 1 << 16;
+    static constexpr size_t     BLOCK_ALIGNMENT     = 64;
+
+    static bool is_lvz(const std::string& filename) {
+        return filename.size() >= 4 && filename.substr(filename.size() - 4) == ".lvz";
+    }
+
+    static void save(const char* filename, const GaussianData& data, bool compress = true,
+                     uint32_t chunk_size = DEFAULT_CHUNK_SIZE, uint32_t flags = 0) {
+
+        const size_t N = data.size();
+        const bool compact = data.isCompact();
+
+        LvzHeader header = {};
+        std::memcpy(header.magic, "LVZ1", 4);
+        header.version = LvzReader::VERSION;
+        header.count = N;
+        header.storage = compact ? (data.packed.sh_format == CompactSplats::SH_UINT8 ? GaussianData::COMPACT_UINT8
+                                                                                     : GaussianData::COMPACT_FP16)
+                                 : GaussianData::FP32;
+        header.sh_dim = data.sh_dim();
+        header.stride = compact ? data.packed.stride : static_cast<uint32_t>(data.attributes.cols());
+        header.chunk_size = chunk_size;
+        header.num_chunks = static_cast<uint32_t>((N + chunk_size - 1) / chunk_size);
+        header.flags = flags;
+
+        const std::vector<float> sh_range = compact ? data.packed.sh_range : std::vector<float>();
+
+        const uint8_t* sources[2] = {
+            reinterpret_cast<const uint8_t*>(data.xyz.data()),
+            compact ? reinterpret_cast<const uint8_t*>(data.packed.words.data())
+                    : reinterpret_cast<const uint8_t*>(data.attributes.data())
+        };
+        const size_t row_bytes[2] = { 3 * sizeof(float), header.stride * sizeof(uint32_t) };
+
+        // compress every block in parallel, then lay them out in order
+        std::vector<LvzChunk> chunks(header.num_chunks);
+        std::vector<LvzBounds> bounds((flags & LVZ_SPATIAL) ? header.num_chunks : 0);
+        std::vector<std::vector<char>> blocks(2 * header.num_chunks);
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, header.num_chunks, 1),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t c = r.begin(); c < r.end(); ++c) {
+                    const size_t first = c * chunk_size;
+                    chunks[c].count = static_cast<uint32_t>(std::min<size_t>(chunk_size, N - first));
+                    for (int b = 0; b < 2; ++b) {
+                        const size_t raw = chunks[c].count * row_bytes[b];
+                        const char* src = reinterpret_cast<const char*>(sources[b] + first * row_bytes[b]);
+                        std::vector<char>& block = blocks[2 * c + b];
+
+                        if (compress) {
+                            block.resize(LZ4_compressBound(static_cast<int>(raw)));
+                            int bytes = LZ4_compress_default(src, block.data(), static_cast<int>(raw), static_cast<int>(block.size()));
+                            block.resize(bytes > 0 ? bytes : 0);
+                        }
+                        // keep the raw bytes when compression does not pay off
+                        if (!compress || block.empty() || block.size() >= raw) {
+                            block.assign(src, src + raw);
+                        }
+                        chunks[c].bytes[b] = static_cast<uint32_t>(block.size());
+                    }
+                    if (!bounds.empty()) {
+                        chunkBounds(data, first, first + chunks[c].count, bounds[c]);
+                    }
+                }
+            });
+
+        size_t offset = sizeof(LvzHeader) + sh_range.size() * sizeof(float) +
+                        chunks.size() * sizeof(LvzChunk) + bounds.size() * sizeof(LvzBounds);
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            for (int b = 0; b < 2; ++b) {
+                offset = align(offset);
+                chunks[c].offset[b] = offset;
+                offset += chunks[c].bytes[b];
+            }
+        }
+
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to create file: " + std::string(filename));
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(sh_range.data()), sh_range.size() * sizeof(float));
+        file.write(reinterpret_cast<const char*>(chunks.data()), chunks.size() * sizeof(LvzChunk));
+        file.write(reinterpret_cast<const char*>(bounds.data()), bounds.size() * sizeof(LvzBounds));
+
+        static const char padding[BLOCK_ALIGNMENT] = {};
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            for (int b = 0; b < 2; ++b) {
+                const size_t pos = static_cast<size_t>(file.tellp());
+                file.write(padding, chunks[c].offset[b] - pos);
+                file.write(blocks[2 * c + b].data(), blocks[2 * c + b].size());
+            }
+        }
+
+        if (!file.good()) {
+            throw std::runtime_error("Failed to write file: " + std::string(filename));
+        }
+    }
+
+    static GaussianData load(const char* filename) {
+        LvzReader reader(filename);
+        GaussianData data;
+        reader.allocate(data);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, reader.chunks(), 1),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t c = r.begin(); c < r.end(); ++c) {
+                    reader.read(c, data);
+                }
+            });
+        return data;
+    }
+
+private:
+    static void chunkBounds(const GaussianData& data, size_t begin, size_t end, LvzBounds& bounds) {
+        Eigen::AlignedBox3f box;
+        float radius = 0.0f;
+        float attr[GaussianData::SH];
+        for (size_t i = begin; i < end; ++i) {
+            box.extend(data.xyz.row(i).transpose());
+            data.shape(i, attr);
+            radius = std::max({ radius, attr[GaussianData::SCALE], attr[GaussianData::SCALE + 1], attr[GaussianData::SCALE + 2] });
+        }
+        Eigen::Map<Eigen::Vector3f>(bounds.min) = box.min();
+        Eigen::Map<Eigen::Vector3f>(bounds.max) = box.max();
+        bounds.radius = radius;
+        bounds.reserved = 0;
+    }
+
+    static size_t align(size_t offset) {
+        return (offset + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+    }
+};
+
+#endif // __CONTAINER_H__
@@ -0,0 +1,228 @@
+#ifndef __CULLING_H__
+#define __CULLING_H__
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <tbb/parallel_for.h>
+#include <liteviz/dataloader.h>
+
+// View frustum culling of splats by their 3-sigma bounding spheres, followed by
+// compaction of the survivors. The per-splat test is a branch-free loop over
+// contiguous positions and radii that the compiler vectorizes; blocks of splats
+// run in parallel and are compacted with a prefix sum over block counts.
+//
+// The test is conservative against what draw_splat.vert puts on screen, so a
+// culled frame looks exactly like an unculled one:
+//  - the side planes take the sphere, grown for the shader's linearized
+//    projection and moved out by a guard band for its low-pass dilation,
+//  - near and far take the center alone, as the shader's own |ndc.z| <=
+//    CLIP_BOUND rejection does, which also drops everything behind the camera.
+class FrustumCuller {
+
+public:
+    static constexpr size_t GRAIN       = 1 << 14;
+    static constexpr size_t RUN         = 256;      // splats per vectorized pass over the planes
+    static constexpr int    PLANES      = 6;
+    static constexpr float  CLIP_BOUND  = 1.3f;     // draw_splat.vert drops centers beyond this NDC bound
+
+    // Half-spaces a*x + b*y + c*z + d >= -e * radius, one per row (a, b, c, d, e).
+    using Planes = Eigen::Matrix<float, PLANES, 5, Eigen::RowMajor>;
+
+    enum Containment {
+        OUTSIDE,    // no splat in the group can pass the planes
+        PARTIAL,
+        INSIDE,     // every splat center in the group passes them
+    };
+
+    // Planes for projmat * viewmat: left, right, bottom, top against the sphere,
+    // then near and far at CLIP_BOUND against the center. widen moves the side
+    // planes out by that much in NDC units.
+    static Planes planes(const Eigen::Matrix4f& projmat, const Eigen::Matrix4f& viewmat,
+                         const Eigen::Vector2f& widen = Eigen::Vector2f::Zero()) {
+
+        Planes planes = Planes::Zero();
+
+        Eigen::Matrix4f P = projmat;
+        P.row(0) /= 1.0f + widen.x();
+        P.row(1) /= 1.0f + widen.y();
+        Eigen::Matrix4f M = P * viewmat;
+        for (int axis = 0; axis < 2; ++axis) {
+            // the shader projects the covariance with the Jacobian at the
+            // center, which overstates the sphere's extent off axis by up to
+            // sqrt(1 + u^2) / sqrt(1 + t^2) for tan u <= CLIP_BOUND * tan t
+            const float t = 1.0f / projmat(axis, axis);
+            const float reach = std::sqrt((1.0f + CLIP_BOUND * CLIP_BOUND * t * t) / (1.0f + t * t));
+            for (int side = 0; side < 2; ++side) {
+                Eigen::RowVector4f plane = M.row(3) + (side ? -1.0f : 1.0f) * M.row(axis);
+                plane /= plane.head<3>().norm();
+                planes.row(2 * axis + side) << plane, reach;
+            }
+        }
+
+        // the shader's depth rejection, exact on the center
+        M = projmat * viewmat;
+        planes.row(4).head<4>() = CLIP_BOUND * M.row(3) + M.row(2);
+        planes.row(5).head<4>() = CLIP_BOUND * M.row(3) - M.row(2);
+        return planes;
+    }
+
+    // A group of splats by the bounds of its centers and its largest radius,
+    // against the same planes as cull().
+    static Containment classify(const Planes& planes, const Eigen::AlignedBox3f& centers, float radius) {
+        bool inside = true;
+        for (int p = 0; p < PLANES; ++p) {
+            const Eigen::Vector3f n = planes.row(p).head<3>().transpose();
+            const float d = planes(p, 3);
+            // corners of the bounds furthest along and against the normal
+            const Eigen::Vector3f ahead = (n.array() >= 0.0f).select(centers.max(), centers.min());
+            const Eigen::Vector3f behind = (n.array() >= 0.0f).select(centers.min(), centers.max());
+            if (n.dot(ahead) + d + planes(p, 4) * radius < 0.0f) return OUTSIDE;
+            inside &= n.dot(behind) + d >= 0.0f;
+        }
+        return inside ? INSIDE : PARTIAL;
+    }
+
+    // Largest axis scale of splats [begin, end); times 3 * scale_modifier this
+    // is the radius of the sphere holding the shader's 3-sigma quad.
+    static void boundingRadii(const GaussianData& data, size_t begin, size_t end, float* radius) {
+        tbb::parallel_for(tbb::blocked_range<size_t>(begin, end, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    if (data.isCompact()) {
+                        const uint32_t* w = &data.packed.words[i * data.packed.stride];
+                        radius[i] = std::max({ half_to_float(w[CompactSplats::SCALE_WORD] & 0xffff),
+                                               half_to_float(w[CompactSplats::SCALE_WORD] >> 16),
+                                               half_to_float(w[CompactSplats::SCALE_OPACITY_WORD] & 0xffff) });
+                    } else {
+                        radius[i] = data.attributes.row(i).segment<3>(GaussianData::SCALE).maxCoeff();
+                    }
+                }
+            });
+    }
+
+    // Tests N splats (xyz: N x 3 row-major, radius: N) and collects the indices
+    // of those whose sphere touches the frustum. Returns how many survived.
+    size_t cull(const float* xyz, const float* radius, size_t N, float radius_scale, const Planes& planes) {
+
+        const size_t blocks = (N + GRAIN - 1) / GRAIN;
+        _mask.resize(N);
+        _offsets.resize(blocks + 1);
+
+        struct Coefficients { float a[PLANES], b[PLANES], c[PLANES], d[PLANES], e[PLANES]; } coef;
+        for (int p = 0; p < PLANES; ++p) {
+            coef.a[p] = planes(p, 0);
+            coef.b[p] = planes(p, 1);
+            coef.c[p] = planes(p, 2);
+            coef.d[p] = planes(p, 3);
+            coef.e[p] = planes(p, 4) * radius_scale;
+        }
+
+        uint8_t* mask = _mask.data();
+        uint32_t* counts = _offsets.data() + 1;
+
+        // Short runs of splats are split into coordinate arrays on the stack,
+        // then each plane is one multiply-add / min loop over the run, which
+        // the compiler turns into full-width SIMD.
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, blocks, 1),
+            [&coef, xyz, radius, mask, counts, N](const tbb::blocked_range<size_t>& r) {
+                float px[RUN], py[RUN], pz[RUN], pr[RUN], margin[RUN];
+                for (size_t b = r.begin(); b < r.end(); ++b) {
+                    const size_t end = std::min(N, (b + 1) * GRAIN);
+                    uint32_t count = 0;
+                    for (size_t first = b * GRAIN; first < end; first += RUN) {
+                        const size_t n = std::min(RUN, end - first);
+                        for (size_t k = 0; k < n; ++k) {
+                            px[k] = xyz[3 * (first + k)];
+                            py[k] = xyz[3 * (first + k) + 1];
+                            pz[k] = xyz[3 * (first + k) + 2];
+                            pr[k] = radius[first + k];
+                            margin[k] = std::numeric_limits<float>::max();
+                        }
+
+                        // smallest signed distance over all planes, negative when outside one
+                        for (int p = 0; p < PLANES; ++p) {
+                            const float a = coef.a[p], b = coef.b[p], c = coef.c[p], d = coef.d[p], e = coef.e[p];
+                            for (size_t k = 0; k < n; ++k) {
+                                const float dist = a * px[k] + b * py[k] + c * pz[k] + d + e * pr[k];
+                                margin[k] = std::min(margin[k], dist);
+                            }
+                        }
+                        for (size_t k = 0; k < n; ++k) {
+                            const uint8_t inside = margin[k] >= 0.0f;
+                            mask[first + k] = inside;
+                            count += inside;
+                        }
+                    }
+                    counts[b] = count;
+                }
+            });
+
+        _offsets[0] = 0;
+        for (size_t b = 0; b < blocks; ++b) _offsets[b + 1] += _offsets[b];
+        _visible.resize(_offsets[blocks]);
+
+        // each block writes only its own [_offsets[b], _offsets[b + 1]) range
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, blocks, 1),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t b = r.begin(); b < r.end(); ++b) {
+                    uint32_t* out = _visible.data() + _offsets[b];
+                    const size_t end = std::min(N, (b + 1) * GRAIN);
+                    for (size_t i = b * GRAIN; i < end; ++i) {
+                        if (_mask[i]) *out++ = static_cast<uint32_t>(i);
+                    }
+                }
+            });
+
+        return _visible.size();
+    }
+
+    // survivors of the last cull() in ascending index order
+    const std::vector<uint32_t>& visible() const { return _visible; }
+
+    // Copies an ordering of the last culled set into out without the culled
+    // splats, keeping the order. out must hold as many entries as survive, N
+    // at most. Returns the number of survivors.
+    size_t compact(const uint32_t* order, size_t N, uint32_t* out) {
+
+        const size_t blocks = (N + GRAIN - 1) / GRAIN;
+        _offsets.resize(blocks + 1);
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, blocks, 1),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t b = r.begin(); b < r.end(); ++b) {
+                    const size_t end = std::min(N, (b + 1) * GRAIN);
+                    uint32_t count = 0;
+                    for (size_t i = b * GRAIN; i < end; ++i) count += _mask[order[i]];
+                    _offsets[b + 1] = count;
+                }
+            });
+
+        _offsets[0] = 0;
+        for (size_t b = 0; b < blocks; ++b) _offsets[b + 1] += _offsets[b];
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, blocks, 1),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t b = r.begin(); b < r.end(); ++b) {
+                    uint32_t* dst = out + _offsets[b];
+                    const size_t end = std::min(N, (b + 1) * GRAIN);
+                    for (size_t i = b * GRAIN; i < end; ++i) {
+                        if (_mask[order[i]]) *dst++ = order[i];
+                    }
+                }
+            });
+
+        return _offsets[blocks];
+    }
+
+private:
+    std::vector<uint8_t>    _mask;      // 1 = survived the last cull()
+    std::vector<uint32_t>   _offsets;   // per block output offsets
+    std::vector<uint32_t>   _visible;
+};
+
+#endif // __CULLING_H__
@@ -2,47 +2,320 @@
 #define __DATALOADER_H__
 
 #include <string>
+#include <memory>
+#include <fstream>
 #include <vector>
-#include <tbb/parallel_sort.h>
 #include <Eigen/Dense>
 #include <tinyply.h>
+#include <cmath>
+#include <numeric>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+#include <liteviz/sorter.h>
+#include <liteviz/ply_reader.h>
+#include <liteviz/quantize.h>
 
 using namespace tinyply;
 
 struct GaussianData {
 
-    Eigen::MatrixXf xyz;        // N x 3
-    Eigen::MatrixXf rot;        // N x 4 (quaternion)
-    Eigen::MatrixXf scale;      // N x 3
-    Eigen::MatrixXf opacity;    // N x 1
-    Eigen::MatrixXf sh;         // N x SH_dim (SH = 3 x ((d+1)^2))
+    using Positions     = Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>;
+    using Attributes    = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    // column offsets within an attribute row, see R_INDEX.. in draw_splat.vert
+    static constexpr int ROT        = 0;
+    static constexpr int SCALE      = 4;
+    static constexpr int OPACITY    = 7;
+    static constexpr int SH         = 8;
+    static constexpr int COV_DIM    = 6;    // see covariance()
+
+    // how the attributes are held in memory, see CompactSplats
+    enum Storage {
+        FP32,
+        COMPACT_FP16,   // fp16 scale/opacity/SH, 32-bit quaternion
+        COMPACT_UINT8,  // as above with 8-bit SH
+    };
+
+    // Both blocks are stored row by row as the shader reads them; fp32 rows
+    // only get quaternion and scale swapped for covariance() on upload.
+    // Positions are kept apart because the per-frame sort only touches them.
+    Positions   xyz;            // N x 3
+    Attributes  attributes;     // N x (4 + 3 + 1 + SH_dim): quaternion | scale | opacity | SH (SH = 3 x ((d+1)^2))
+    CompactSplats packed;       // replaces attributes (left empty) in compact storage
 
     size_t size() const { return xyz.rows(); }
 
-    int sh_dim() const { return sh.cols(); }
+    bool isCompact() const { return !packed.empty(); }
+
+    int sh_dim() const { return isCompact() ? packed.sh_dim : static_cast<int>(attributes.cols()) - SH; }
+
+    auto rot()              { return attributes.middleCols<4>(ROT); }
+    auto rot() const        { return attributes.middleCols<4>(ROT); }
+    auto scale()            { return attributes.middleCols<3>(SCALE); }
+    auto scale() const      { return attributes.middleCols<3>(SCALE); }
+    auto opacity()          { return attributes.col(OPACITY); }
+    auto opacity() const    { return attributes.col(OPACITY); }
+    auto sh()               { return attributes.rightCols(sh_dim()); }
+    auto sh() const         { return attributes.rightCols(sh_dim()); }
 
-    std::vector<float> flat() const {
-        std::vector<float> flat_data;
-        flat_data.reserve(size() * (3 + 4 + 3 + 1 + sh_dim()));
+    void resize(size_t N, int sh_dim) {
+        xyz.resize(N, 3);
+        attributes.resize(N, SH + sh_dim);
+    }
+
+    // Re-encodes fp32 attributes into compact storage and frees them.
+    void quantize(Storage storage) {
+        if (storage == FP32 || isCompact()) return;
+        const Attributes& rows = attributes;
+        packed.build(size(), sh_dim(), shFormat(storage), [&rows](size_t i, float* attr) {
+            std::memcpy(attr, &rows(i, 0), rows.cols() * sizeof(float));
+        });
+        attributes.resize(0, 0);
+    }
 
-        for (int i = 0; i < size(); ++i) {
-            for (int j = 0; j < 3; ++j) flat_data.push_back(xyz(i, j));
-            for (int j = 0; j < 4; ++j) flat_data.push_back(rot(i, j));
-            for (int j = 0; j < 3; ++j) flat_data.push_back(scale(i, j));
-            for (int j = 0; j < 1; ++j) flat_data.push_back(opacity(i, j));
-            for (int j = 0; j < sh_dim(); ++j) flat_data.push_back(sh(i, j));
+    // Quaternion, scale and opacity of splat i (attribute columns [0, SH)),
+    // decoded when the storage is compact.
+    void shape(size_t i, float attr[SH]) const {
+        if (isCompact()) {
+            const uint32_t* w = &packed.words[i * packed.stride];
+            unpack_quaternion(w[CompactSplats::ROT_WORD], attr + ROT);
+            attr[SCALE] = half_to_float(w[CompactSplats::SCALE_WORD] & 0xffff);
+            attr[SCALE + 1] = half_to_float(w[CompactSplats::SCALE_WORD] >> 16);
+            attr[SCALE + 2] = half_to_float(w[CompactSplats::SCALE_OPACITY_WORD] & 0xffff);
+            attr[OPACITY] = half_to_float(w[CompactSplats::SCALE_OPACITY_WORD] >> 16);
+        } else {
+            std::memcpy(attr, &attributes(i, 0), SH * sizeof(float));
         }
-        
-        return flat_data;
     }
 
-    static GaussianData load_ply(const char* filename, int max_sh_degree = 3) {
-        std::ifstream ss(filename, std::ios::binary);
+    // Upper triangle (xx, xy, xz, yy, yz, zz) of the 3D covariance
+    // R * S^2 * R^T of splat i, as computeCov3D in draw_splat.vert builds it
+    // with a scale modifier of 1.
+    void covariance(size_t i, float cov[COV_DIM]) const {
+        float attr[SH];
+        shape(i, attr);
+        const float r = attr[ROT], x = attr[ROT + 1], y = attr[ROT + 2], z = attr[ROT + 3];
+        const float R[3][3] = {
+            { 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - r * z), 2.0f * (x * z + r * y) },
+            { 2.0f * (x * y + r * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - r * x) },
+            { 2.0f * (x * z - r * y), 2.0f * (y * z + r * x), 1.0f - 2.0f * (x * x + y * y) },
+        };
+        const float s2[3] = { attr[SCALE] * attr[SCALE], attr[SCALE + 1] * attr[SCALE + 1], attr[SCALE + 2] * attr[SCALE + 2] };
+        auto entry = [&](int a, int b) { return R[a][0] * s2[0] * R[b][0] + R[a][1] * s2[1] * R[b][1] + R[a][2] * s2[2] * R[b][2]; };
+        cov[0] = entry(0, 0);
+        cov[1] = entry(0, 1);
+        cov[2] = entry(0, 2);
+        cov[3] = entry(1, 1);
+        cov[4] = entry(1, 2);
+        cov[5] = entry(2, 2);
+    }
+
+    // Splat order by decreasing opacity x volume, so that any prefix of the
+    // reordered scene already holds the splats that matter most on screen.
+    std::vector<uint32_t> importanceOrder() const {
+        const size_t N = size();
+        std::vector<float> importance(N);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, 1 << 14),
+            [&](const tbb::blocked_range<size_t>& r) {
+                float attr[SH];
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    shape(i, attr);
+                    importance[i] = attr[OPACITY] * attr[SCALE] * attr[SCALE + 1] * attr[SCALE + 2];
+                }
+            });
+
+        std::vector<uint32_t> order(N);
+        std::iota(order.begin(), order.end(), 0u);
+        tbb::parallel_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return importance[a] > importance[b] || (importance[a] == importance[b] && a < b);
+        });
+        return order;
+    }
+
+    // Permutes the splats so that new row i is old row order[i].
+    void reorder(const std::vector<uint32_t>& order) {
+        const size_t N = size();
+        Positions new_xyz(N, 3);
+        Attributes new_attributes(isCompact() ? 0 : N, attributes.cols());
+        std::vector<uint32_t> new_words(packed.words.size());
+        const size_t stride = packed.stride;
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, 1 << 14),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    new_xyz.row(i) = xyz.row(order[i]);
+                    if (isCompact()) {
+                        std::copy_n(&packed.words[order[i] * stride], stride, &new_words[i * stride]);
+                    } else {
+                        new_attributes.row(i) = attributes.row(order[i]);
+                    }
+                }
+            });
+
+        xyz.swap(new_xyz);
+        attributes.swap(new_attributes);
+        packed.words.swap(new_words);
+    }
+
+    static CompactSplats::SHFormat shFormat(Storage storage) {
+        return storage == COMPACT_UINT8 ? CompactSplats::SH_UINT8 : CompactSplats::SH_FP16;
+    }
+
+    // Interleaves separate per-attribute matrices into the storage layout.
+    static GaussianData assemble(const Eigen::MatrixXf& xyz, const Eigen::MatrixXf& rot, const Eigen::MatrixXf& scale,
+                                 const Eigen::MatrixXf& opacity, const Eigen::MatrixXf& sh) {
+        GaussianData data;
+        data.resize(xyz.rows(), sh.cols());
+        data.xyz = xyz;
+        data.rot() = rot;
+        data.scale() = scale;
+        data.opacity() = opacity.col(0);
+        data.sh() = sh;
+        return data;
+    }
+
+    static GaussianData load_ply(const char* filename, int max_sh_degree = 3, Storage storage = FP32) {
         std::string fname(filename);
 
         if (fname.size() < 4 || fname.substr(fname.size() - 4) != ".ply") {
             throw std::runtime_error("File is not a .ply file: " + fname);
         }
+
+        GaussianData data;
+        if (load_ply_mapped(filename, max_sh_degree, data, storage)) {
+            return data;
+        }
+        data = load_ply_tinyply(filename, max_sh_degree);
+        data.quantize(storage);
+        return data;
+    }
+
+    // Decoder for the fast path: a mapped binary little endian PLY with float-only
+    // vertex records. Each record is transposed, activated and normalized into
+    // the storage layout on its own, so callers can decode any range in parallel.
+    class MappedPly {
+
+    public:
+        // Returns false when the file needs the generic reader.
+        bool open(const char* filename, int max_sh_degree) {
+            _file = std::make_unique<MappedFile>(filename);
+            if (!PlyVertexLayout::parse(_file->data(), _file->size(), _layout)) {
+                _file.reset();
+                return false;
+            }
+
+            auto offset = [&](const std::string& name) {
+                int o = _layout.offset(name);
+                if (o < 0) {
+                    throw std::runtime_error("Missing vertex property '" + name + "' in " + std::string(filename));
+                }
+                return o;
+            };
+
+            for (int j = 0; j < 3; ++j) _pos_off[j] = offset(std::string(1, "xyz"[j]));
+            for (int j = 0; j < 4; ++j) _rot_off[j] = offset("rot_" + std::to_string(j));
+            for (int j = 0; j < 3; ++j) _scale_off[j] = offset("scale_" + std::to_string(j));
+            _opacity_off = offset("opacity");
+
+            int num_rest = 0;
+            while (_layout.offset("f_rest_" + std::to_string(num_rest)) >= 0) ++num_rest;
+            const int rest_per_channel = num_rest / 3;
+
+            int sh_degree = 0;
+            while (sh_degree < max_sh_degree && (sh_degree + 2) * (sh_degree + 2) - 1 <= rest_per_channel) ++sh_degree;
+            const int sh_coeffs = (sh_degree + 1) * (sh_degree + 1);
+
+            // f_rest is stored channel-major, the shader wants coefficient-major rgb triples
+            _sh_off = { offset("f_dc_0"), offset("f_dc_1"), offset("f_dc_2") };
+            for (int i = 0; i < sh_coeffs - 1; ++i) {
+                for (int c = 0; c < 3; ++c) {
+                    _sh_off.push_back(offset("f_rest_" + std::to_string(i + c * rest_per_channel)));
+                }
+            }
+
+            _records = _file->data() + _layout.data_offset;
+            _file->prefetch(_layout.data_offset, _layout.count * _layout.stride);
+            return true;
+        }
+
+        size_t count() const { return _layout.count; }
+
+        int sh_dim() const { return static_cast<int>(_sh_off.size()); }
+
+        // position of record i into pos[3], its activated attribute row into attr
+        void decode(size_t i, float* pos, float* attr) const {
+            const uint8_t* record = _records + i * _layout.stride;
+            auto get = [record](int o) {
+                float v;
+                std::memcpy(&v, record + o, sizeof(float));
+                return v;
+            };
+
+            for (int j = 0; j < 3; ++j) pos[j] = get(_pos_off[j]);
+
+            Eigen::Vector4f q(get(_rot_off[0]), get(_rot_off[1]), get(_rot_off[2]), get(_rot_off[3]));
+            Eigen::Map<Eigen::Vector4f>(attr + ROT) = q.normalized();
+
+            for (int j = 0; j < 3; ++j) attr[SCALE + j] = std::exp(get(_scale_off[j]));
+
+            attr[OPACITY] = 1.0f / (1.0f + std::exp(-get(_opacity_off)));
+
+            for (size_t j = 0; j < _sh_off.size(); ++j) attr[SH + j] = get(_sh_off[j]);
+        }
+
+    private:
+        std::unique_ptr<MappedFile> _file;
+        PlyVertexLayout             _layout;
+        const uint8_t*              _records = nullptr;
+        int                         _pos_off[3];
+        int                         _rot_off[4];
+        int                         _scale_off[3];
+        int                         _opacity_off;
+        std::vector<int>            _sh_off;
+    };
+
+    // Fast path through MappedPly: records are decoded by parallel chunks
+    // straight into the final matrices, or quantized on the fly for compact
+    // storage. Returns false when the file needs the generic reader.
+    static bool load_ply_mapped(const char* filename, int max_sh_degree, GaussianData& data, Storage storage = FP32) {
+        MappedPly ply;
+        if (!ply.open(filename, max_sh_degree)) {
+            return false;
+        }
+
+        const size_t N = ply.count();
+        const int sh_dim = ply.sh_dim();
+
+        auto decode = [&](size_t i, float* attr) {
+            ply.decode(i, &data.xyz(i, 0), attr);
+        };
+
+        if (storage != FP32) {
+            // quantize record by record, the fp32 attributes never exist in full
+            data.xyz.resize(N, 3);
+            data.attributes.resize(0, 0);
+            data.packed.build(N, sh_dim, shFormat(storage), decode);
+            return true;
+        }
+
+        data.resize(N, sh_dim);
+        data.packed = CompactSplats();
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, 1 << 14),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    decode(i, &data.attributes(i, 0));
+                }
+            });
+
+        return true;
+    }
+
+    // Generic reader for any PLY layout tinyply understands.
+    static GaussianData load_ply_tinyply(const char* filename, int max_sh_degree = 3) {
+        std::ifstream ss(filename, std::ios::binary);
+        std::string fname(filename);
+
         if (!ss.is_open()) {
             throw std::runtime_error("Failed to open file: " + fname);
         }
@@ -83,32 +356,33 @@ struct GaussianData {
 
         int N = x->count;
 
-        auto load_vec = [](std::shared_ptr<PlyData>& pd, int N) -> Eigen::VectorXf {
+        auto load_vec = [](std::shared_ptr<PlyData>& pd, int N) -> Eigen::Map<Eigen::VectorXf> {
             return Eigen::Map<Eigen::VectorXf>(reinterpret_cast<float*>(pd->buffer.get()), N);
         };
 
-        Eigen::MatrixXf xyz(N, 3);
-        xyz.col(0) = load_vec(x, N);
-        xyz.col(1) = load_vec(y, N);
-        xyz.col(2) = load_vec(z, N);
+        GaussianData data;
+        data.resize(N, 3 * sh_coeffs);
+
+        data.xyz.col(0) = load_vec(x, N);
+        data.xyz.col(1) = load_vec(y, N);
+        data.xyz.col(2) = load_vec(z, N);
 
-        Eigen::MatrixXf rot(N, 4);
+        auto rot = data.rot();
         rot.col(0) = load_vec(rot_w, N);
         rot.col(1) = load_vec(rot_x, N);
         rot.col(2) = load_vec(rot_y, N);
         rot.col(3) = load_vec(rot_z, N);
-        
+
         for (int i = 0; i < N; ++i) rot.row(i).normalize();
 
-        Eigen::MatrixXf scale(N, 3);
+        auto scale = data.scale();
         scale.col(0) = load_vec(scale_0, N).array().exp();
         scale.col(1) = load_vec(scale_1, N).array().exp();
         scale.col(2) = load_vec(scale_2, N).array().exp();
 
-        Eigen::MatrixXf opac = load_vec(opacity, N);
-        opac = (1.0f / (1.0f + (-opac.array()).exp())).eval();
+        data.opacity() = 1.0f / (1.0f + (-load_vec(opacity, N).array()).exp());
 
-        Eigen::MatrixXf sh(N, 3 * sh_coeffs);
+        auto sh = data.sh();
         sh.col(0) = load_vec(f_dc_0, N);
         sh.col(1) = load_vec(f_dc_1, N);
         sh.col(2) = load_vec(f_dc_2, N);
@@ -118,7 +392,7 @@ struct GaussianData {
             sh.col(3 + i) = load_vec(f_rest_list[i], N);
         }
 
-        return GaussianData{ xyz, rot, scale, opac, sh };
+        return data;
     }
 
     static GaussianData naive_data() {
@@ -150,31 +424,16 @@ struct GaussianData {
         Eigen::MatrixXf gau_a(4, 1);
         gau_a << 1, 1, 1, 1;
 
-        return GaussianData{ gau_xyz, gau_rot, gau_s, gau_a, gau_c };
+        return assemble(gau_xyz, gau_rot, gau_s, gau_a, gau_c);
     }
 };
 
 std::vector<int> sort(const GaussianData& data, const Eigen::Matrix4f& P) {
 
-    const size_t N = data.xyz.rows();
-    std::vector<int> depth_index(N);
-    std::vector<float> depths(N);
-    const Eigen::RowVector3f proj_row = P.row(2).head<3>();
-    for (size_t i = 0; i < N; ++i) {
-        Eigen::Vector3f center = data.xyz.row(i).transpose();  // 3x1
-        depths[i] = proj_row.dot(center);
-        depth_index[i] = static_cast<int>(i);
-    }
-
-    // std::sort(depth_index.begin(), depth_index.end(),
-    //           [&](int i, int j) {
-    //               return depths[i] < depths[j];
-    //           });
+    thread_local DepthSorter sorter;
 
-    tbb::parallel_sort(depth_index.begin(), depth_index.end(),
-                    [&](int i, int j) {
-                        return depths[i] < depths[j];
-                    });
+    std::vector<int> depth_index(data.size());
+    sorter.sort(data.xyz, P, reinterpret_cast<uint32_t*>(depth_index.data()));
     return depth_index;
 }
 
@@ -0,0 +1,320 @@
+#ifndef __GPU_SORTER_H__
+#define __GPU_SORTER_H__
+
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <Eigen/Dense>
+#include <glad/glad.h>
+#include <liteviz/buffer.h>
+#include <liteviz/shader.h>
+#include <liteviz/culling.h>
+
+// Shader storage buffer for data that compute passes write and read, grown on demand.
+struct GpuBuffer {
+    GLuint  id      = 0;
+    size_t  bytes   = 0;
+
+    // grows to hold at least n bytes, with room to spare; contents are not kept
+    void reserve(size_t n) {
+        if (bytes >= n && id) return;
+        if (!id) glGenBuffers(1, &id);
+        bytes = std::max<size_t>(n + n / 2, 1024);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void bind(GLuint binding) const {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, id);
+    }
+
+    void release() {
+        if (id) glDeleteBuffers(1, &id);
+        id = 0;
+        bytes = 0;
+    }
+};
+
+// Exclusive prefix sum (prefix_sum.comp) and stable LSD radix sort in 4-bit
+// passes (radix_sort.comp) of GPU buffers, for the tile renderer's keys and
+// GpuSorter's depths. Both use shader storage bindings 8 to 12, which they
+// leave bound to their own buffers.
+class GpuRadixSort {
+
+public:
+    static constexpr int    GROUP       = 256;  // invocations per 1D work group, keys per radix block
+    static constexpr int    SCAN_BLOCK  = 1024; // values per prefix sum work group
+    static constexpr int    RADIX_BITS  = 4;
+    static constexpr GLuint MAX_GROUPS  = 65535;    // per dimension, the least GL allows
+
+    // wide_keys: keys are pairs of words, the low word sorted first
+    explicit GpuRadixSort(bool wide_keys) {
+        const std::string path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+        const std::string keys = wide_keys ? "#define WIDE_KEYS\n" : "";
+        auto compute = [&](const char* name, const std::string& defines) {
+            return std::make_unique<Shader>((path + "/" + name).c_str(), defines);
+        };
+        _reduce = compute("prefix_sum.comp", "#define REDUCE\n");
+        _scan_sums = compute("prefix_sum.comp", "#define SCAN_SUMS\n");
+        _downsweep = compute("prefix_sum.comp", "#define DOWNSWEEP\n");
+        _histogram = compute("radix_sort.comp", keys + "#define HISTOGRAM\n");
+        _scatter = compute("radix_sort.comp", keys + "#define SCATTER\n");
+    }
+
+    ~GpuRadixSort() {
+        _counts.release();
+        _sums.release();
+    }
+
+    GpuRadixSort(const GpuRadixSort&) = delete;
+    GpuRadixSort& operator=(const GpuRadixSort&) = delete;
+
+    static size_t groups(size_t n, size_t per_group) {
+        return (n + per_group - 1) / per_group;
+    }
+
+    // as a 2D grid past MAX_GROUPS, the shaders flatten gl_WorkGroupID
+    static void dispatch(size_t groups) {
+        if (groups == 0) return;
+        const GLuint x = static_cast<GLuint>(std::min<size_t>(groups, MAX_GROUPS));
+        glDispatchCompute(x, static_cast<GLuint>((groups + x - 1) / x), 1);
+    }
+
+    // Exclusive prefix sum of the first n words of buffer, in place; returns
+    // the total if read_total, which waits for the GPU.
+    size_t scan(const GpuBuffer& buffer, size_t n, bool read_total) {
+        const size_t blocks = groups(n, SCAN_BLOCK);
+        _sums.reserve((blocks + 1) * sizeof(uint32_t));
+        buffer.bind(8);
+        _sums.bind(9);
+
+        _reduce->bind(false);
+        _reduce->set_uniform("count", static_cast<int>(n));
+        dispatch(blocks);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        _scan_sums->bind(false);
+        _scan_sums->set_uniform("count", static_cast<int>(blocks));
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        _downsweep->bind(false);
+        _downsweep->set_uniform("count", static_cast<int>(n));
+        dispatch(blocks);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        if (!read_total) return 0;
+        uint32_t total = 0;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _sums.id);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, blocks * sizeof(uint32_t), sizeof(uint32_t), &total);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return total;
+    }
+
+    // Sorts the first count keys and values in slot 0 of keys and values by
+    // the low bits of the keys, ping-ponging with slot 1, whose buffers must
+    // be as large; returns the slot holding the result.
+    int sort(GpuBuffer keys[2], GpuBuffer values[2], size_t count, int bits) {
+        const size_t blocks = groups(count, GROUP);
+        _counts.reserve((size_t(1) << RADIX_BITS) * blocks * sizeof(uint32_t));
+        int src = 0;
+        for (int shift = 0; shift < bits; shift += RADIX_BITS) {
+            keys[src].bind(8);
+            values[src].bind(9);
+            _counts.bind(10);
+            _histogram->bind(false);
+            _histogram->set_uniform("count", static_cast<int>(count));
+            _histogram->set_uniform("blocks", static_cast<int>(blocks));
+            _histogram->set_uniform("shift", shift);
+            dispatch(blocks);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            // digit-major, so each block's offset for a digit follows every smaller digit
+            scan(_counts, (size_t(1) << RADIX_BITS) * blocks, false);
+
+            keys[src].bind(8);
+            values[src].bind(9);
+            _counts.bind(10);
+            keys[1 - src].bind(11);
+            values[1 - src].bind(12);
+            _scatter->bind(false);
+            _scatter->set_uniform("count", static_cast<int>(count));
+            _scatter->set_uniform("blocks", static_cast<int>(blocks));
+            _scatter->set_uniform("shift", shift);
+            dispatch(blocks);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            src = 1 - src;
+        }
+        return src;
+    }
+
+private:
+    std::unique_ptr<Shader> _reduce;
+    std::unique_ptr<Shader> _scan_sums;
+    std::unique_ptr<Shader> _downsweep;
+    std::unique_ptr<Shader> _histogram;
+    std::unique_ptr<Shader> _scatter;
+    GpuBuffer               _counts;    // radix digit counts per block
+    GpuBuffer               _sums;      // prefix sum block totals
+};
+
+// Back-to-front depth sort of the splats entirely on the GPU: depth_keys.comp
+// turns the centers already in the position buffer (binding 0) into the
+// same exact 32-bit keys as DepthSorter::KEY_32, and GpuRadixSort orders
+// them, so the splat order never leaves the GPU and a frame uploads nothing
+// but uniforms. Renderer sorts with it when RenderConfig::gpu_sort is set.
+// Unlike the CPU sorters it always sorts by the exact keys, in 8 passes.
+//
+// With frustum planes, the splats FrustumCuller would cull get the largest
+// key instead, and the count of the others is written into an indirect draw
+// command (see draw()): the sort still covers every splat, but no count has
+// to come back to the CPU. For visible(), each frame's count is copied into
+// a small ring of buffers with a fence each, and read back once its fence
+// has passed, a frame or so late, without waiting.
+class GpuSorter {
+
+public:
+    // capacity: most splats that will be sorted, for the radius buffer
+    explicit GpuSorter(size_t capacity): _radix(false) {
+        const std::string path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+        _keys_shader = std::make_unique<Shader>((path + "/depth_keys.comp").c_str());
+        _radius.reserve(std::max<size_t>(capacity, 1) * sizeof(float));
+        const uint32_t command[4] = { 4, 0, 0, 0 };    // vertices, instances, first vertex, base instance
+        glGenBuffers(1, &_command.id);
+        _command.bytes = sizeof(command);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _command.id);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(command), command, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        for (Readback& slot : _readback) slot.buffer.reserve(sizeof(uint32_t));
+    }
+
+    ~GpuSorter() {
+        for (GpuBuffer* buffer : { &_keys[0], &_keys[1], &_values[0], &_values[1], &_radius, &_command }) {
+            buffer->release();
+        }
+        for (Readback& slot : _readback) {
+            slot.buffer.release();
+            if (slot.fence) deleteSync(slot.fence);
+        }
+    }
+
+    GpuSorter(const GpuSorter&) = delete;
+    GpuSorter& operator=(const GpuSorter&) = delete;
+
+    // bounding radii of splats [begin, end), see FrustumCuller::boundingRadii
+    void uploadRadii(const float* radius, size_t begin, size_t end) {
+        if (end <= begin) return;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _radius.id);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, begin * sizeof(float), (end - begin) * sizeof(float), radius + begin);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    // Sorts splats [0, count) by ascending view-space z, as DepthSorter does,
+    // and binds the order at shader storage binding index. With planes,
+    // those outside them (FrustumCuller::cull() with radius_scale) go last
+    // and are left out of draw().
+    void sort(size_t count, const Eigen::Matrix4f& viewmat, const FrustumCuller::Planes* planes, float radius_scale,
+              GLuint index) {
+
+        // the newest count of an earlier frame the GPU has copied out by now,
+        // oldest copy first; a copy whose fence passed is read without waiting
+        for (int k = 0; k < READBACK_RING; ++k) {
+            Readback& slot = _readback[(_readback_next + k) % READBACK_RING];
+            if (!slot.fence) continue;
+            if (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) break;
+            deleteSync(slot.fence);
+            slot.fence = nullptr;
+            uint32_t instances = 0;
+            glBindBuffer(GL_COPY_READ_BUFFER, slot.buffer.id);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(uint32_t), &instances);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            _visible = instances;
+        }
+        _count = count;
+        if (!planes) _visible = count;
+
+        // depth_keys.comp counts the instances up from zero
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _command.id);
+        glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, sizeof(uint32_t), sizeof(uint32_t), GL_RED_INTEGER,
+                             GL_UNSIGNED_INT, nullptr);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        if (count == 0) return;
+
+        for (int i = 0; i < 2; ++i) {
+            _keys[i].reserve(count * sizeof(uint32_t));
+            _values[i].reserve(count * sizeof(uint32_t));
+        }
+        _keys[0].bind(8);
+        _values[0].bind(9);
+        _radius.bind(13);
+        _command.bind(14);
+        _keys_shader->bind(false);
+        _keys_shader->set_uniform("count", static_cast<int>(count));
+        _keys_shader->set_uniform("depth_row", Eigen::Vector3f(viewmat.row(2).head<3>().transpose()));
+        _keys_shader->set_uniform("cull", static_cast<int>(planes != nullptr));
+        if (planes) {
+            for (int p = 0; p < FrustumCuller::PLANES; ++p) {
+                const std::string i = std::to_string(p);
+                _keys_shader->set_uniform("planes[" + i + "]", Eigen::Vector4f(planes->row(p).head<4>().transpose()));
+                _keys_shader->set_uniform("margins[" + i + "]", (*planes)(p, 4) * radius_scale);
+            }
+        }
+        GpuRadixSort::dispatch(GpuRadixSort::groups(count, GpuRadixSort::GROUP));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+        // copy the count out for visible(), unless every copy is still in flight;
+        // _command itself is rewritten by the next frame
+        Readback& slot = _readback[_readback_next];
+        if (planes && !slot.fence) {
+            glBindBuffer(GL_COPY_READ_BUFFER, _command.id);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, slot.buffer.id);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sizeof(uint32_t), 0, sizeof(uint32_t));
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            slot.fence = fenceSync();
+            _readback_next = (_readback_next + 1) % READBACK_RING;
+        }
+
+        _sorted = _radix.sort(_keys, _values, count, 32);
+        _values[_sorted].bind(index);
+    }
+
+    // Draws a quad (4 vertex triangle fan) per sorted splat that was not
+    // culled, with the bound program and vertex array.
+    void draw() const {
+        if (_count == 0) return;
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _command.id);
+        glDrawArraysIndirect(GL_TRIANGLE_FAN, nullptr);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // splats of the last sort, and how many of a recent one were not culled
+    size_t count() const { return _count; }
+
+    size_t visible() const { return std::min(_visible, _count); }
+
+    // buffer holding the last sort's order, count() words
+    GLuint order() const { return _values[_sorted].id; }
+
+private:
+    static constexpr int READBACK_RING = 3;
+
+    // a copy of the instance count, with the fence after it
+    struct Readback {
+        GpuBuffer   buffer;
+        GLsync      fence = nullptr;
+    };
+
+    GpuRadixSort            _radix;
+    std::unique_ptr<Shader> _keys_shader;
+    GpuBuffer               _keys[2];
+    GpuBuffer               _values[2];     // splat per key, the sorted order in one of them
+    GpuBuffer               _radius;
+    GpuBuffer               _command;       // glDrawArraysIndirect's, the instances counted by depth_keys.comp
+    Readback                _readback[READBACK_RING];
+    int                     _readback_next = 0;     // slot of the next copy, the oldest one
+    int                     _sorted     = 0;        // slot of _values with the order
+    size_t                  _count      = 0;
+    size_t                  _visible    = 0;
+};
+
+#endif // __GPU_SORTER_H__
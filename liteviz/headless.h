@@ -0,0 +1,116 @@
+#ifndef __HEADLESS_H__
+#define __HEADLESS_H__
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <iostream>
+#include <liteviz/buffer.h>
+
+// An OpenGL 4.3 core context without a window or a display server, made
+// through EGL: on Mesa's surfaceless platform when the driver has it (which
+// is what llvmpipe offers on machines without a GPU), on the default EGL
+// display otherwise. Nothing is drawn to a surface; render into an
+// OffscreenTarget instead.
+class HeadlessContext {
+
+public:
+    bool init() {
+
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay) {
+            _display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (_display == EGL_NO_DISPLAY) {
+            _display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        EGLint major, minor;
+        if (_display == EGL_NO_DISPLAY || !eglInitialize(_display, &major, &minor)) {
+            std::cerr << "Failed to initialize EGL!" << std::endl;
+            return false;
+        }
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            std::cerr << "EGL has no desktop OpenGL!" << std::endl;
+            return false;
+        }
+
+        // surfaceless displays may offer no config at all, the context does not need one
+        const EGLint config_attribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLConfig config = nullptr;
+        EGLint configs = 0;
+        eglChooseConfig(_display, config_attribs, &config, 1, &configs);
+
+        const EGLint context_attribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 4,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        _context = eglCreateContext(_display, configs > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+        if (_context == EGL_NO_CONTEXT || !eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, _context)) {
+            std::cerr << "Failed to create a surfaceless OpenGL 4.3 context (EGL error 0x" << std::hex
+                      << eglGetError() << std::dec << ")!" << std::endl;
+            return false;
+        }
+
+        if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+            std::cerr << "GLAD init failed" << std::endl;
+            return false;
+        }
+        StreamBuffer::setProcLoader((GLADloadproc)eglGetProcAddress);
+        return true;
+    }
+
+    ~HeadlessContext() {
+        if (_display == EGL_NO_DISPLAY) return;
+        eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (_context != EGL_NO_CONTEXT) eglDestroyContext(_display, _context);
+        eglTerminate(_display);
+    }
+
+private:
+    EGLDisplay  _display = EGL_NO_DISPLAY;
+    EGLContext  _context = EGL_NO_CONTEXT;
+};
+
+// A framebuffer object with an RGBA8 color renderbuffer, the format of the
+// viewer's default framebuffer, so splats blend and clamp exactly as there.
+class OffscreenTarget {
+
+public:
+    OffscreenTarget(int width, int height): _width(width), _height(height) {
+        glGenFramebuffers(1, &_fbo);
+        glGenRenderbuffers(1, &_color);
+        glBindRenderbuffer(GL_RENDERBUFFER, _color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _color);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Offscreen framebuffer is incomplete" << std::endl;
+        }
+    }
+
+    ~OffscreenTarget() {
+        glDeleteFramebuffers(1, &_fbo);
+        glDeleteRenderbuffers(1, &_color);
+    }
+
+    // for drawing and, through FrameCapture, for reading back
+    void bind() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+        glViewport(0, 0, _width, _height);
+    }
+
+    int width() const { return _width; }
+
+    int height() const { return _height; }
+
+private:
+    int     _width;
+    int     _height;
+    GLuint  _fbo;
+    GLuint  _color;
+};
+
+#endif // __HEADLESS_H__
@@ -0,0 +1,213 @@
+#ifndef __IMAGE_WRITER_H__
+#define __IMAGE_WRITER_H__
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <liteviz/utils.h>
+
+// Encodes RGBA8 frames to disk on a pool of worker threads, so that encoding
+// the last frames overlaps rendering the next ones. At most max_pending
+// frames wait for a worker; write() blocks beyond that instead of letting a
+// slow disk pile up frames in memory.
+class ImageWriter {
+
+public:
+    struct Stats {
+        size_t  written = 0;
+        size_t  failed  = 0;
+        double  encode  = 0.0;  // seconds, summed over the workers
+    };
+
+    explicit ImageWriter(int threads = 2, size_t max_pending = 8): _max_pending(max_pending) {
+        for (int i = 0; i < std::max(threads, 1); ++i) _workers.emplace_back([this]() { work(); });
+    }
+
+    ~ImageWriter() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _ready.notify_all();
+        for (std::thread& worker : _workers) worker.join();
+    }
+
+    // rgba: width x height pixels, bottom row first as glReadPixels returns
+    // them. The file format follows the extension, .ppm or else .png.
+    void write(const std::string& path, int width, int height, std::vector<uint8_t>&& rgba) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _space.wait(lock, [&]() { return _queue.size() < _max_pending; });
+        _queue.push_back({ path, width, height, std::move(rgba) });
+        lock.unlock();
+        _ready.notify_one();
+    }
+
+    // as write(), but drops the frame and returns false instead of waiting for room
+    bool tryWrite(const std::string& path, int width, int height, std::vector<uint8_t>&& rgba) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_queue.size() >= _max_pending) return false;
+        _queue.push_back({ path, width, height, std::move(rgba) });
+        lock.unlock();
+        _ready.notify_one();
+        return true;
+    }
+
+    // waits until every frame written so far is on disk
+    void finish() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _idle.wait(lock, [&]() { return _queue.empty() && _busy == 0; });
+    }
+
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    static bool encode(const std::string& path, int width, int height, const std::vector<uint8_t>& rgba) {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) return false;
+        const bool ppm = path.size() > 4 && path.substr(path.size() - 4) == ".ppm";
+        const std::vector<uint8_t> bytes = ppm ? toPPM(width, height, rgba) : toPNG(width, height, rgba);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        return bool(file);
+    }
+
+private:
+    struct Frame {
+        std::string             path;
+        int                     width;
+        int                     height;
+        std::vector<uint8_t>    rgba;
+    };
+
+    void work() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _ready.wait(lock, [&]() { return _stop || !_queue.empty(); });
+            if (_queue.empty()) return;
+            Frame frame = std::move(_queue.front());
+            _queue.pop_front();
+            ++_busy;
+            lock.unlock();
+            _space.notify_one();
+
+            Timer timer;
+            const bool ok = encode(frame.path, frame.width, frame.height, frame.rgba);
+            const double time = timer.elapsed();
+            if (!ok) std::cerr << "Failed to write " << frame.path << std::endl;
+
+            lock.lock();
+            --_busy;
+            ++(ok ? _stats.written : _stats.failed);
+            _stats.encode += time;
+            if (_queue.empty() && _busy == 0) _idle.notify_all();
+        }
+    }
+
+    // binary RGB, top row first
+    static std::vector<uint8_t> toPPM(int width, int height, const std::vector<uint8_t>& rgba) {
+        const std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+        std::vector<uint8_t> out(header.begin(), header.end());
+        out.reserve(header.size() + size_t(width) * height * 3);
+        for (int y = height - 1; y >= 0; --y) {
+            const uint8_t* row = &rgba[size_t(y) * width * 4];
+            for (int x = 0; x < width; ++x) out.insert(out.end(), row + 4 * x, row + 4 * x + 3);
+        }
+        return out;
+    }
+
+    // RGBA8 PNG, top row first, with the image data in stored (uncompressed)
+    // deflate blocks: no zlib needed, and encoding costs little more than
+    // the two checksums.
+    static std::vector<uint8_t> toPNG(int width, int height, const std::vector<uint8_t>& rgba) {
+        const size_t stride = size_t(width) * 4 + 1;    // filter byte + pixels
+        std::vector<uint8_t> raw(stride * height);
+        for (int y = 0; y < height; ++y) {
+            raw[y * stride] = 0;
+            std::copy_n(&rgba[size_t(height - 1 - y) * width * 4], width * 4, &raw[y * stride + 1]);
+        }
+
+        std::vector<uint8_t> zlib = { 0x78, 0x01 };
+        zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+        size_t pos = 0;
+        do {
+            const size_t len = std::min<size_t>(65535, raw.size() - pos);
+            zlib.push_back(pos + len == raw.size() ? 1 : 0);    // last block
+            zlib.push_back(len & 0xff);
+            zlib.push_back(len >> 8);
+            zlib.push_back(~len & 0xff);
+            zlib.push_back((~len >> 8) & 0xff);
+            zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+            pos += len;
+        } while (pos < raw.size());
+        uint32_t a = 1, b = 0;
+        for (size_t k = 0; k < raw.size(); ) {
+            // 5552 bytes keep b from overflowing before the modulo
+            const size_t end = std::min(raw.size(), k + 5552);
+            for (; k < end; ++k) {
+                a += raw[k];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        putBE(zlib, b << 16 | a);
+
+        std::vector<uint8_t> out = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        std::vector<uint8_t> ihdr;
+        putBE(ihdr, width);
+        putBE(ihdr, height);
+        ihdr.insert(ihdr.end(), { 8, 6, 0, 0, 0 });    // 8 bit RGBA, deflate, no interlace
+        chunk(out, "IHDR", ihdr);
+        chunk(out, "IDAT", zlib);
+        chunk(out, "IEND", {});
+        return out;
+    }
+
+    static void putBE(std::vector<uint8_t>& out, uint32_t v) {
+        out.insert(out.end(), { uint8_t(v >> 24), uint8_t(v >> 16), uint8_t(v >> 8), uint8_t(v) });
+    }
+
+    static void chunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+        putBE(out, static_cast<uint32_t>(data.size()));
+        const size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        putBE(out, crc32(&out[start], out.size() - start));
+    }
+
+    static uint32_t crc32(const uint8_t* data, size_t size) {
+        static const std::vector<uint32_t> table = []() {
+            std::vector<uint32_t> t(256);
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+        uint32_t c = 0xffffffffu;
+        for (size_t i = 0; i < size; ++i) c = table[(c ^ data[i]) & 0xff] ^ (c >> 8);
+        return c ^ 0xffffffffu;
+    }
+
+    size_t                      _max_pending;
+    std::vector<std::thread>    _workers;
+    std::deque<Frame>           _queue;
+    std::mutex                  _mutex;
+    std::condition_variable     _ready;     // a frame was queued, or stop
+    std::condition_variable     _space;     // a frame left the queue
+    std::condition_variable     _idle;      // queue empty and no frame in a worker
+    size_t                      _busy = 0;
+    bool                        _stop = false;
+    Stats                       _stats;
+};
+
+#endif // __IMAGE_WRITER_H__
@@ -0,0 +1,325 @@
+#ifndef __LOD_H__
+#define __LOD_H__
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <tbb/parallel_for.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/culling.h>
+#include <liteviz/octree.h>
+
+// Level of detail over a SplatOctree: every node holding more than one splat
+// gets a merged parent Gaussian that stands in for everything below it, and a
+// frame draws a cut through the tree instead of the whole scene.
+//
+// Parents are moment matched. With per-splat weight w = opacity x area of the
+// largest cross-section, a parent takes the weighted mean of the centers,
+// the weighted covariance of the children plus their spread about that mean,
+// the weighted mean of the SH coefficients, and the opacity that keeps the
+// summed w over its own cross-section. Moments compose, so inner nodes merge
+// their children's parents and match merging all their splats at once.
+//
+// Indices below size() name scene splats, size() + j the j-th parent, so a
+// renderer holding both blocks back to back draws a cut as it draws a sort.
+class SplatLOD {
+
+public:
+    SplatLOD() = default;
+
+    explicit SplatLOD(const GaussianData& data, uint32_t leaf_size = SplatOctree::LEAF_SIZE) {
+        build(data, leaf_size);
+    }
+
+    // data must outlive the LOD, see SplatOctree::build().
+    void build(const GaussianData& data, uint32_t leaf_size = SplatOctree::LEAF_SIZE) {
+
+        _octree.build(data, leaf_size);
+        _size = data.size();
+
+        const std::vector<SplatOctree::Node>& nodes = _octree.nodes();
+        const size_t num_nodes = nodes.size();
+        const int dim = data.sh_dim();
+
+        // a single splat is its own parent
+        _representative.assign(num_nodes, 0);
+        size_t num_parents = 0;
+        for (size_t id = 0; id < num_nodes; ++id) {
+            _representative[id] = nodes[id].count() == 1 ? _octree.order()[nodes[id].begin]
+                                                        : static_cast<uint32_t>(_size + num_parents++);
+        }
+
+        _weight.assign(num_nodes, 0.0);
+        _mean.resize(num_nodes);
+        _cov.resize(num_nodes);
+        _sh.assign(num_nodes * dim, 0.0f);
+        _extent.assign(num_nodes, 0.0f);
+
+        // bottom-up, one level at a time
+        const auto& levels = _octree.levels();
+        for (auto level = levels.rbegin(); level != levels.rend(); ++level) {
+            tbb::parallel_for(tbb::blocked_range<uint32_t>(level->first, level->second, 64),
+                [&](const tbb::blocked_range<uint32_t>& r) {
+                    std::vector<float> attr(GaussianData::SH + dim);
+                    for (uint32_t id = r.begin(); id < r.end(); ++id) {
+                        if (nodes[id].leaf()) {
+                            mergeSplats(data, nodes[id], id, attr.data());
+                        } else {
+                            mergeChildren(nodes[id], id, dim);
+                        }
+                    }
+                });
+        }
+
+        // parents in the data's storage format, so both share the shader path
+        _parents = GaussianData();
+        _parents.xyz.resize(num_parents, 3);
+        if (data.isCompact()) {
+            _parents.packed.reset(num_parents, dim, data.packed.sh_format);
+            _parents.packed.sh_range = data.packed.sh_range;
+        } else {
+            _parents.attributes.resize(num_parents, GaussianData::SH + dim);
+        }
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, num_nodes, 1024),
+            [&](const tbb::blocked_range<size_t>& r) {
+                std::vector<float> attr(GaussianData::SH + dim);
+                for (size_t id = r.begin(); id < r.end(); ++id) {
+                    const float extent = toAttributes(id, dim, attr.data());
+                    _extent[id] = extent;
+                    if (_representative[id] < _size) continue;
+
+                    const size_t j = _representative[id] - _size;
+                    _parents.xyz.row(j) = _mean[id].cast<float>().transpose();
+                    if (data.isCompact()) {
+                        _parents.packed.packRow(j, attr.data());
+                    } else {
+                        std::copy_n(attr.data(), attr.size(), &_parents.attributes(j, 0));
+                    }
+                }
+            });
+
+        _positions.resize(_size + num_parents, 3);
+        _positions.topRows(_size) = data.xyz;
+        _positions.bottomRows(num_parents) = _parents.xyz;
+
+        // the moments are only needed while building
+        std::vector<double>().swap(_weight);
+        std::vector<Eigen::Vector3d>().swap(_mean);
+        std::vector<Eigen::Matrix3d>().swap(_cov);
+        std::vector<float>().swap(_sh);
+    }
+
+    bool empty() const { return _octree.empty(); }
+
+    // scene splats, the indices below the parents
+    size_t size() const { return _size; }
+
+    const SplatOctree& octree() const { return _octree; }
+
+    // merged Gaussians, parent j has index size() + j
+    const GaussianData& parents() const { return _parents; }
+
+    // centers of the scene splats followed by the parents
+    const GaussianData::Positions& positions() const { return _positions; }
+
+    // Chooses the cut to draw from eye: starting at the root, the node that
+    // looks largest on screen (3-sigma extent of its parent, focal in pixels,
+    // at its distance from the eye) is replaced by its children until every
+    // node of the cut is under threshold pixels or refining the next one would
+    // exceed budget splats (0: no limit). Refined leaves give their splats.
+    // With planes, nodes and leaf splats outside the frustum (see
+    // SplatOctree::classify() and collect()) are dropped. Writes the cut's
+    // indices to cut and returns their count.
+    size_t select(const Eigen::Vector3f& eye, float focal, float threshold, size_t budget,
+                  const FrustumCuller::Planes* planes, float radius_scale, std::vector<uint32_t>& cut) const {
+
+        cut.clear();
+        if (empty()) return 0;
+
+        const std::vector<SplatOctree::Node>& nodes = _octree.nodes();
+        const std::vector<uint32_t>& order = _octree.order();
+
+        struct Candidate {
+            float       size;       // projected extent in pixels
+            uint32_t    id;
+            bool        inside;     // whole node in the frustum, children need no test
+
+            bool operator<(const Candidate& other) const { return size < other.size; }
+        };
+
+        auto candidate = [&](uint32_t id, bool parent_inside, Candidate& c) {
+            c.id = id;
+            c.inside = parent_inside || !planes;
+            if (!c.inside) {
+                const FrustumCuller::Containment containment = SplatOctree::classify(nodes[id], *planes, radius_scale);
+                if (containment == FrustumCuller::OUTSIDE) return false;
+                c.inside = containment == FrustumCuller::INSIDE;
+            }
+            const float distance = nodes[id].bounds.exteriorDistance(eye);
+            c.size = distance > 0.0f ? focal * _extent[id] / distance : std::numeric_limits<float>::infinity();
+            return true;
+        };
+
+        std::vector<Candidate> heap;
+        Candidate root;
+        if (candidate(0, false, root)) heap.push_back(root);
+        size_t total = heap.size();
+
+        while (!heap.empty() && heap.front().size >= threshold) {
+            std::pop_heap(heap.begin(), heap.end());
+            const Candidate top = heap.back();
+            heap.pop_back();
+            const SplatOctree::Node& node = nodes[top.id];
+
+            if (node.leaf()) {
+                const size_t before = cut.size();
+                if (top.inside) {
+                    cut.insert(cut.end(), order.begin() + node.begin, order.begin() + node.end);
+                } else {
+                    _octree.collect(node, *planes, radius_scale, cut);
+                }
+                const size_t count = cut.size() - before;
+                if (budget && total - 1 + count > budget) {
+                    cut.resize(before);
+                    cut.push_back(_representative[top.id]);
+                } else {
+                    total = total - 1 + count;
+                }
+                continue;
+            }
+
+            Candidate children[8];
+            int count = 0;
+            for (uint32_t c = node.first_child; c < node.first_child + node.num_children; ++c) {
+                count += candidate(c, top.inside, children[count]);
+            }
+            if (budget && total - 1 + count > budget) {
+                cut.push_back(_representative[top.id]);
+                continue;
+            }
+            for (int c = 0; c < count; ++c) {
+                heap.push_back(children[c]);
+                std::push_heap(heap.begin(), heap.end());
+            }
+            total = total - 1 + count;
+        }
+
+        for (const Candidate& c : heap) cut.push_back(_representative[c.id]);
+        return cut.size();
+    }
+
+private:
+
+    // Per-splat moment weight: opacity times the area of the largest
+    // cross-section, what the splat covers on screen when seen face on.
+    static double splatWeight(const float* attr) {
+        float s[3] = { attr[GaussianData::SCALE], attr[GaussianData::SCALE + 1], attr[GaussianData::SCALE + 2] };
+        std::sort(s, s + 3);
+        return std::max(double(attr[GaussianData::OPACITY]), 1e-6) * std::max(double(s[1]) * s[2], 1e-30);
+    }
+
+    static void splatRow(const GaussianData& data, size_t i, float* attr) {
+        if (data.isCompact()) {
+            data.packed.unpackRow(i, attr);
+        } else {
+            std::copy_n(&data.attributes(i, 0), data.attributes.cols(), attr);
+        }
+    }
+
+    void mergeSplats(const GaussianData& data, const SplatOctree::Node& node, uint32_t id, float* attr) {
+
+        const int dim = data.sh_dim();
+        const std::vector<uint32_t>& order = _octree.order();
+
+        double weight = 0.0;
+        Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+        Eigen::Matrix3d second = Eigen::Matrix3d::Zero();   // sum w (cov + mu mu^T)
+        float* sh = &_sh[size_t(id) * dim];
+
+        for (uint32_t k = node.begin; k < node.end; ++k) {
+            const uint32_t i = order[k];
+            splatRow(data, i, attr);
+            const double w = splatWeight(attr);
+
+            const Eigen::Matrix3d R = Eigen::Quaterniond(attr[0], attr[1], attr[2], attr[3]).normalized().toRotationMatrix();
+            const Eigen::Vector3d s2 = Eigen::Map<const Eigen::Vector3f>(attr + GaussianData::SCALE).cast<double>().cwiseAbs2();
+            const Eigen::Vector3d mu = data.xyz.row(i).transpose().cast<double>();
+
+            weight += w;
+            mean += w * mu;
+            second += w * (R * s2.asDiagonal() * R.transpose() + mu * mu.transpose());
+            for (int c = 0; c < dim; ++c) sh[c] += static_cast<float>(w) * attr[GaussianData::SH + c];
+        }
+
+        _weight[id] = weight;
+        _mean[id] = mean / weight;
+        _cov[id] = second / weight - _mean[id] * _mean[id].transpose();
+        for (int c = 0; c < dim; ++c) sh[c] = static_cast<float>(sh[c] / weight);
+    }
+
+    void mergeChildren(const SplatOctree::Node& node, uint32_t id, int dim) {
+
+        double weight = 0.0;
+        Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+        float* sh = &_sh[size_t(id) * dim];
+        const uint32_t first = node.first_child, last = node.first_child + node.num_children;
+
+        for (uint32_t c = first; c < last; ++c) {
+            weight += _weight[c];
+            mean += _weight[c] * _mean[c];
+            for (int k = 0; k < dim; ++k) sh[k] += static_cast<float>(_weight[c]) * _sh[size_t(c) * dim + k];
+        }
+        mean /= weight;
+
+        Eigen::Matrix3d cov = Eigen::Matrix3d::Zero();
+        for (uint32_t c = first; c < last; ++c) {
+            const Eigen::Vector3d d = _mean[c] - mean;
+            cov += _weight[c] * (_cov[c] + d * d.transpose());
+        }
+
+        _weight[id] = weight;
+        _mean[id] = mean;
+        _cov[id] = cov / weight;
+        for (int k = 0; k < dim; ++k) sh[k] = static_cast<float>(sh[k] / weight);
+    }
+
+    // Attribute row of node id's parent from its moments; returns its
+    // 3-sigma extent.
+    float toAttributes(size_t id, int dim, float* attr) const {
+
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigen(_cov[id]);
+        Eigen::Matrix3d R = eigen.eigenvectors();
+        if (R.determinant() < 0.0) R.col(0) = -R.col(0);
+        const Eigen::Vector3d scale = eigen.eigenvalues().cwiseMax(1e-14).cwiseSqrt();   // ascending
+
+        const Eigen::Quaterniond q(R);
+        attr[GaussianData::ROT] = static_cast<float>(q.w());
+        attr[GaussianData::ROT + 1] = static_cast<float>(q.x());
+        attr[GaussianData::ROT + 2] = static_cast<float>(q.y());
+        attr[GaussianData::ROT + 3] = static_cast<float>(q.z());
+        for (int k = 0; k < 3; ++k) attr[GaussianData::SCALE + k] = static_cast<float>(scale[k]);
+        attr[GaussianData::OPACITY] = static_cast<float>(std::min(1.0, _weight[id] / (scale[1] * scale[2])));
+        std::copy_n(&_sh[id * dim], dim, attr + GaussianData::SH);
+
+        return static_cast<float>(3.0 * scale[2]);
+    }
+
+    SplatOctree                     _octree;
+    size_t                          _size = 0;
+    GaussianData                    _parents;
+    GaussianData::Positions         _positions;
+    std::vector<uint32_t>           _representative;    // per node: the splat or parent drawn for it
+    std::vector<float>              _extent;            // per node: 3-sigma extent of the parent
+
+    // build() only: per node moments
+    std::vector<double>             _weight;
+    std::vector<Eigen::Vector3d>    _mean;
+    std::vector<Eigen::Matrix3d>    _cov;
+    std::vector<float>              _sh;
+};
+
+#endif // __LOD_H__
@@ -0,0 +1,476 @@
+#ifndef __OCTREE_H__
+#define __OCTREE_H__
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/culling.h>
+
+// Octree over the splat centers, built in parallel from Morton codes: the
+// centers are sorted along a Z-order curve, so every octree cell is a range of
+// that order and a node splits by binary searching the next 3 code bits. The
+// splats themselves are not moved; order() lists them in Morton order and each
+// node covers order()[begin, end).
+//
+// Per node: the bounds of the centers, the largest splat scale below it (the
+// bounds grown by 3 * scale_modifier * radius hold every drawn quad), the
+// opacity-weighted centroid and the splat count. The data passed to build()
+// must outlive the tree and stay unchanged, as ray casts read its attributes.
+class SplatOctree {
+
+public:
+    static constexpr int        MAX_DEPTH   = 21;   // 3 x 21 bit Morton codes
+    static constexpr uint32_t   LEAF_SIZE   = 64;
+    static constexpr uint32_t   NONE        = UINT32_MAX;
+
+    struct Node {
+        Eigen::AlignedBox3f bounds;         // splat centers
+        Eigen::Vector3f     centroid;       // opacity-weighted mean center
+        float               radius      = 0.0f;     // largest splat scale below
+        float               opacity     = 0.0f;     // summed opacity
+        uint32_t            begin       = 0;        // splats order()[begin, end)
+        uint32_t            end         = 0;
+        uint32_t            first_child = NONE;     // children are contiguous
+        uint8_t             num_children = 0;
+        uint8_t             octant      = 0;        // x | y << 1 | z << 2 within the parent cell
+        uint8_t             level       = 0;
+
+        uint32_t count() const { return end - begin; }
+
+        bool leaf() const { return num_children == 0; }
+    };
+
+    struct Hit {
+        uint32_t        splat   = NONE;
+        float           t       = std::numeric_limits<float>::infinity();  // along the ray
+        Eigen::Vector3f position = Eigen::Vector3f::Zero();
+
+        bool valid() const { return splat != NONE; }
+    };
+
+    SplatOctree() = default;
+
+    explicit SplatOctree(const GaussianData& data, uint32_t leaf_size = LEAF_SIZE) {
+        build(data, leaf_size);
+    }
+
+    void build(const GaussianData& data, uint32_t leaf_size = LEAF_SIZE) {
+
+        _data = &data;
+        _nodes.clear();
+        const size_t N = data.size();
+        if (N == 0) return;
+
+        computeCube(data);
+
+        // Morton order
+        std::vector<std::pair<uint64_t, uint32_t>> keys(N);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    keys[i] = { mortonCode(data.xyz.row(i).transpose()), static_cast<uint32_t>(i) };
+                }
+            });
+        tbb::parallel_sort(keys.begin(), keys.end());
+
+        // per splat data in Morton order, so that leaves read it contiguously
+        _order.resize(N);
+        _codes.resize(N);
+        _xyz.resize(3 * N);
+        _radius.resize(N);
+        _opacity.resize(N);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                float attr[GaussianData::SH];
+                for (size_t k = r.begin(); k < r.end(); ++k) {
+                    const uint32_t i = keys[k].second;
+                    _codes[k] = keys[k].first;
+                    _order[k] = i;
+                    std::copy_n(&data.xyz(i, 0), 3, &_xyz[3 * k]);
+                    data.shape(i, attr);
+                    _radius[k] = std::max({ attr[GaussianData::SCALE], attr[GaussianData::SCALE + 1], attr[GaussianData::SCALE + 2] });
+                    _opacity[k] = attr[GaussianData::OPACITY];
+                }
+            });
+
+        buildNodes(std::max<uint32_t>(1, leaf_size));
+        computeNodeStats();
+    }
+
+    bool empty() const { return _nodes.empty(); }
+
+    const std::vector<Node>& nodes() const { return _nodes; }
+
+    const Node& root() const { return _nodes.front(); }
+
+    // splat indices in Morton order, the ranges nodes refer to
+    const std::vector<uint32_t>& order() const { return _order; }
+
+    // the cube the codes quantize, its min corner and side
+    const Eigen::Vector3f& origin() const { return _origin; }
+
+    float side() const { return _side; }
+
+    int depth() const { return static_cast<int>(_levels.size()); }
+
+    // node id range [first, second) of each depth, root first
+    const std::vector<std::pair<uint32_t, uint32_t>>& levels() const { return _levels; }
+
+    // Node against the planes of FrustumCuller::cull(), splats below taken as
+    // spheres of radius_scale times their largest scale.
+    static FrustumCuller::Containment classify(const Node& node, const FrustumCuller::Planes& planes, float radius_scale) {
+        return FrustumCuller::classify(planes, node.bounds, radius_scale * node.radius);
+    }
+
+    // Splats whose bounding sphere (radius_scale * largest scale) passes all
+    // planes, the same test as FrustumCuller::cull(). Nodes entirely inside
+    // are taken whole, nodes entirely outside are skipped. Appends splat
+    // indices to out in Morton order and returns how many were added.
+    size_t queryFrustum(const FrustumCuller::Planes& planes, float radius_scale, std::vector<uint32_t>& out) const {
+
+        const size_t before = out.size();
+        if (empty()) return 0;
+
+        uint32_t stack[8 * MAX_DEPTH + 8];
+        int top = 0;
+        stack[top++] = 0;
+
+        while (top > 0) {
+            const Node& node = _nodes[stack[--top]];
+
+            const FrustumCuller::Containment containment = classify(node, planes, radius_scale);
+            if (containment == FrustumCuller::OUTSIDE) continue;
+
+            if (containment == FrustumCuller::INSIDE) {
+                out.insert(out.end(), _order.begin() + node.begin, _order.begin() + node.end);
+            } else if (node.leaf()) {
+                collect(node, planes, radius_scale, out);
+            } else {
+                for (int c = node.num_children - 1; c >= 0; --c) {
+                    stack[top++] = node.first_child + c;
+                }
+            }
+        }
+        return out.size() - before;
+    }
+
+    // Appends the splats of node whose bounding sphere passes all planes.
+    void collect(const Node& node, const FrustumCuller::Planes& planes, float radius_scale, std::vector<uint32_t>& out) const {
+        for (uint32_t k = node.begin; k < node.end; ++k) {
+            const float* p_xyz = &_xyz[3 * k];
+            float margin = std::numeric_limits<float>::max();
+            for (int p = 0; p < FrustumCuller::PLANES; ++p) {
+                const float dist = planes(p, 0) * p_xyz[0] + planes(p, 1) * p_xyz[1] + planes(p, 2) * p_xyz[2] +
+                                   planes(p, 3) + planes(p, 4) * radius_scale * _radius[k];
+                margin = std::min(margin, dist);
+            }
+            if (margin >= 0.0f) out.push_back(_order[k]);
+        }
+    }
+
+    // Nearest splat along origin + t * dir (t >= 0), each splat taken as the
+    // ellipsoid of sigma standard deviations the shader draws. Splats below
+    // min_opacity are transparent to the ray, as are splats containing the
+    // origin, which would otherwise hide everything behind the camera plane.
+    // At most max_leaves leaves are tested, which bounds the cost of a ray
+    // grazing dense regions; once they run out, the nearest hit found so far
+    // is returned. Leaves come nearest entry first, so that is rarely wrong.
+    Hit raycast(const Eigen::Vector3f& origin, const Eigen::Vector3f& dir, float sigma = 3.0f,
+                float scale_modifier = 1.0f, float min_opacity = 0.0f, size_t max_leaves = SIZE_MAX) const {
+
+        Hit hit;
+        if (empty()) return hit;
+
+        const Eigen::Vector3f inv_dir = dir.cwiseInverse();
+        const float grow = sigma * scale_modifier;
+
+        // (entry t, node), popped nearest first
+        std::pair<float, uint32_t> stack[8 * MAX_DEPTH + 8];
+        int top = 0;
+        float t_root;
+        if (!slab(root(), origin, inv_dir, grow, t_root)) return hit;
+        stack[top++] = { t_root, 0 };
+
+        while (top > 0) {
+            const auto [t_node, id] = stack[--top];
+            if (t_node > hit.t) continue;
+            const Node& node = _nodes[id];
+
+            if (node.leaf()) {
+                if (max_leaves-- == 0) break;
+                for (uint32_t k = node.begin; k < node.end; ++k) {
+                    if (_opacity[k] < min_opacity) continue;
+                    float t;
+                    if (intersect(*_data, _order[k], origin, dir, sigma, scale_modifier, t) && t < hit.t) {
+                        hit.t = t;
+                        hit.splat = _order[k];
+                    }
+                }
+                continue;
+            }
+
+            // push the children far to near so the nearest comes off first
+            std::pair<float, uint32_t> children[8];
+            int count = 0;
+            for (uint32_t c = node.first_child; c < node.first_child + node.num_children; ++c) {
+                float t;
+                if (slab(_nodes[c], origin, inv_dir, grow, t) && t <= hit.t) {
+                    children[count++] = { t, c };
+                }
+            }
+            std::sort(children, children + count, [](const auto& a, const auto& b) { return a.first > b.first; });
+            std::copy_n(children, count, stack + top);
+            top += count;
+        }
+
+        if (hit.valid()) hit.position = origin + hit.t * dir;
+        return hit;
+    }
+
+    // Ray against the sigma ellipsoid of splat i; t is the entry distance.
+    static bool intersect(const GaussianData& data, size_t i, const Eigen::Vector3f& origin, const Eigen::Vector3f& dir,
+                          float sigma, float scale_modifier, float& t) {
+
+        float attr[GaussianData::SH];
+        data.shape(i, attr);
+        const Eigen::Matrix3f R = Eigen::Quaternionf(attr[0], attr[1], attr[2], attr[3]).normalized().toRotationMatrix();
+        const Eigen::Array3f axes = (sigma * scale_modifier *
+            Eigen::Map<const Eigen::Array3f>(attr + GaussianData::SCALE)).max(std::numeric_limits<float>::min());
+
+        // into the frame where the ellipsoid is the unit sphere
+        const Eigen::Vector3f o = (R.transpose() * (origin - data.xyz.row(i).transpose())).array() / axes;
+        const Eigen::Vector3f d = (R.transpose() * dir).array() / axes;
+
+        const float a = d.squaredNorm();
+        const float b = o.dot(d);
+        const float c = o.squaredNorm() - 1.0f;
+        const float disc = b * b - a * c;
+        if (c <= 0.0f || disc < 0.0f || a == 0.0f) return false;
+
+        t = (-b - std::sqrt(disc)) / a;
+        return t >= 0.0f;
+    }
+
+    // Walks the tree from the root visiting each node before its children,
+    // children in front-to-back order as seen from eye (back-to-front if asked).
+    // For octree cells, visiting octant k ^ (octant holding the eye) for
+    // k = 0..7 never puts a cell before one that can hide it. Splats reach past
+    // their cells, so this orders nodes, not individual splats.
+    // visit(const Node&) returns whether to descend into the node's children.
+    template <typename Visit>
+    void traverseDepthOrder(const Eigen::Vector3f& eye, Visit&& visit, bool back_to_front = false) const {
+        if (empty()) return;
+        traverse(0, _origin, _side, eye, visit, back_to_front);
+    }
+
+private:
+    static constexpr size_t GRAIN = 1 << 14;
+
+    void computeCube(const GaussianData& data) {
+
+        const size_t N = data.size();
+        Eigen::AlignedBox3f box = tbb::parallel_reduce(
+            tbb::blocked_range<size_t>(0, N, GRAIN), Eigen::AlignedBox3f(),
+            [&](const tbb::blocked_range<size_t>& r, Eigen::AlignedBox3f b) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    b.extend(data.xyz.row(i).transpose());
+                }
+                return b;
+            },
+            [](const Eigen::AlignedBox3f& a, const Eigen::AlignedBox3f& b) { return a.merged(b); });
+
+        _origin = box.min();
+        _side = box.sizes().maxCoeff();
+        // keep the max corner strictly inside the last cell
+        _side = _side > 0.0f ? _side * (1.0f + 1e-6f) : 1.0f;
+    }
+
+    static uint64_t expandBits(uint64_t v) {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffffull;
+        v = (v | v << 16) & 0x1f0000ff0000ffull;
+        v = (v | v << 8)  & 0x100f00f00f00f00full;
+        v = (v | v << 4)  & 0x10c30c30c30c30c3ull;
+        v = (v | v << 2)  & 0x1249249249249249ull;
+        return v;
+    }
+
+    uint64_t mortonCode(const Eigen::Vector3f& p) const {
+        constexpr float CELLS = static_cast<float>(1 << MAX_DEPTH);
+        const Eigen::Array3f q = ((p - _origin) / _side * CELLS).array().max(0.0f).min(CELLS - 1.0f);
+        return expandBits(static_cast<uint64_t>(q.x())) |
+               expandBits(static_cast<uint64_t>(q.y())) << 1 |
+               expandBits(static_cast<uint64_t>(q.z())) << 2;
+    }
+
+    // Breadth first, one parallel pass per level: every node over leaf_size
+    // finds its octant ranges, then the children of the whole level are
+    // allocated at once with a prefix sum.
+    void buildNodes(uint32_t leaf_size) {
+
+        Node root;
+        root.begin = 0;
+        root.end = static_cast<uint32_t>(_order.size());
+        _nodes.assign(1, root);
+        _levels.clear();
+
+        uint32_t level_begin = 0, level_end = 1;
+        while (level_begin < level_end) {
+            _levels.emplace_back(level_begin, level_end);
+            const size_t M = level_end - level_begin;
+
+            std::vector<std::array<uint32_t, 9>> bounds(M);
+            std::vector<uint32_t> offsets(M + 1, 0);
+
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, M, 64),
+                [&](const tbb::blocked_range<size_t>& r) {
+                    for (size_t m = r.begin(); m < r.end(); ++m) {
+                        const Node& node = _nodes[level_begin + m];
+                        if (node.count() <= leaf_size || node.level >= MAX_DEPTH) continue;
+
+                        // the codes of a cell share every bit above shift
+                        const int shift = 3 * (MAX_DEPTH - 1 - node.level);
+                        std::array<uint32_t, 9>& b = bounds[m];
+                        b[0] = node.begin;
+                        b[8] = node.end;
+                        for (int o = 1; o < 8; ++o) {
+                            b[o] = static_cast<uint32_t>(std::partition_point(
+                                _codes.begin() + b[o - 1], _codes.begin() + node.end,
+                                [&](uint64_t code) { return static_cast<int>((code >> shift) & 7) < o; }) - _codes.begin());
+                        }
+                        uint32_t children = 0;
+                        for (int o = 0; o < 8; ++o) children += b[o + 1] > b[o];
+                        offsets[m + 1] = children;
+                    }
+                });
+
+            for (size_t m = 0; m < M; ++m) offsets[m + 1] += offsets[m];
+            const uint32_t first = static_cast<uint32_t>(_nodes.size());
+            _nodes.resize(first + offsets[M]);
+
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, M, 64),
+                [&](const tbb::blocked_range<size_t>& r) {
+                    for (size_t m = r.begin(); m < r.end(); ++m) {
+                        if (offsets[m + 1] == offsets[m]) continue;
+                        Node& node = _nodes[level_begin + m];
+                        node.first_child = first + offsets[m];
+                        node.num_children = static_cast<uint8_t>(offsets[m + 1] - offsets[m]);
+                        uint32_t c = node.first_child;
+                        for (int o = 0; o < 8; ++o) {
+                            if (bounds[m][o + 1] == bounds[m][o]) continue;
+                            Node& child = _nodes[c++];
+                            child.begin = bounds[m][o];
+                            child.end = bounds[m][o + 1];
+                            child.octant = static_cast<uint8_t>(o);
+                            child.level = node.level + 1;
+                        }
+                    }
+                });
+
+            level_begin = first;
+            level_end = static_cast<uint32_t>(_nodes.size());
+        }
+    }
+
+    // Leaves from their splats, then inner nodes from their children, one
+    // level at a time from the bottom.
+    void computeNodeStats() {
+
+        for (auto level = _levels.rbegin(); level != _levels.rend(); ++level) {
+            tbb::parallel_for(tbb::blocked_range<uint32_t>(level->first, level->second, 64),
+                [&](const tbb::blocked_range<uint32_t>& r) {
+                    for (uint32_t id = r.begin(); id < r.end(); ++id) {
+                        Node& node = _nodes[id];
+                        node.bounds.setEmpty();
+                        node.radius = 0.0f;
+                        node.opacity = 0.0f;
+                        Eigen::Vector3f weighted = Eigen::Vector3f::Zero();
+                        Eigen::Vector3f sum = Eigen::Vector3f::Zero();
+
+                        if (node.leaf()) {
+                            for (uint32_t k = node.begin; k < node.end; ++k) {
+                                const Eigen::Vector3f p = Eigen::Map<const Eigen::Vector3f>(&_xyz[3 * k]);
+                                node.bounds.extend(p);
+                                node.radius = std::max(node.radius, _radius[k]);
+                                node.opacity += _opacity[k];
+                                weighted += _opacity[k] * p;
+                                sum += p;
+                            }
+                        } else {
+                            for (uint32_t c = node.first_child; c < node.first_child + node.num_children; ++c) {
+                                const Node& child = _nodes[c];
+                                node.bounds.extend(child.bounds);
+                                node.radius = std::max(node.radius, child.radius);
+                                node.opacity += child.opacity;
+                                weighted += child.opacity * child.centroid;
+                                sum += static_cast<float>(child.count()) * child.centroid;
+                            }
+                        }
+                        // fully transparent nodes fall back to the plain mean
+                        node.centroid = node.opacity > 0.0f ? Eigen::Vector3f(weighted / node.opacity)
+                                                            : Eigen::Vector3f(sum / static_cast<float>(node.count()));
+                    }
+                });
+        }
+    }
+
+    // Entry distance of the ray into node's bounds grown by grow * radius.
+    static bool slab(const Node& node, const Eigen::Vector3f& origin, const Eigen::Vector3f& inv_dir, float grow, float& t) {
+        const Eigen::Array3f margin = Eigen::Array3f::Constant(grow * node.radius);
+        const Eigen::Array3f t0 = (node.bounds.min().array() - margin - origin.array()) * inv_dir.array();
+        const Eigen::Array3f t1 = (node.bounds.max().array() + margin - origin.array()) * inv_dir.array();
+        const float t_near = std::max(t0.min(t1).maxCoeff(), 0.0f);
+        const float t_far = t0.max(t1).minCoeff();
+        t = t_near;
+        return t_near <= t_far;
+    }
+
+    template <typename Visit>
+    void traverse(uint32_t id, const Eigen::Vector3f& cell_min, float cell_side, const Eigen::Vector3f& eye,
+                  Visit& visit, bool back_to_front) const {
+
+        const Node& node = _nodes[id];
+        if (!visit(node) || node.leaf()) return;
+
+        const float half = 0.5f * cell_side;
+        const Eigen::Vector3f center = cell_min + Eigen::Vector3f::Constant(half);
+        const int eye_octant = (eye.x() >= center.x()) | (eye.y() >= center.y()) << 1 | (eye.z() >= center.z()) << 2;
+
+        uint32_t by_octant[8];
+        std::fill_n(by_octant, 8, NONE);
+        for (uint32_t c = node.first_child; c < node.first_child + node.num_children; ++c) {
+            by_octant[_nodes[c].octant] = c;
+        }
+
+        for (int k = 0; k < 8; ++k) {
+            const int octant = (back_to_front ? 7 - k : k) ^ eye_octant;
+            if (by_octant[octant] == NONE) continue;
+            const Eigen::Vector3f child_min = cell_min + half * Eigen::Vector3f(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1);
+            traverse(by_octant[octant], child_min, half, eye, visit, back_to_front);
+        }
+    }
+
+    const GaussianData*     _data = nullptr;
+    Eigen::Vector3f         _origin = Eigen::Vector3f::Zero();
+    float                   _side = 1.0f;
+
+    std::vector<Node>       _nodes;
+    std::vector<std::pair<uint32_t, uint32_t>> _levels;    // node id range per depth
+    std::vector<uint32_t>   _order;
+    std::vector<uint64_t>   _codes;     // Morton order from here on
+    std::vector<float>      _xyz;
+    std::vector<float>      _radius;
+    std::vector<float>      _opacity;
+};
+
+#endif // __OCTREE_H__
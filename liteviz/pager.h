@@ -0,0 +1,349 @@
+#ifndef __PAGER_H__
+#define __PAGER_H__
+
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <tbb/parallel_for.h>
+#include <liteviz/utils.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/container.h>
+#include <liteviz/culling.h>
+
+// Out-of-core viewing of a spatial .lvz (liteviz-convert --spatial), whose
+// chunks each cover a small region and carry their bounds. Only a fixed pool
+// of chunk slots is held in memory, host side in pool() and on the GPU in the
+// renderer's buffers, so the scene may be far larger than either.
+//
+// Every frame the chunks in the frustum, nearest first and within range, are
+// wanted; after them the chunks the camera will see PREFETCH_SECONDS ahead
+// along its current motion. Wanted chunks that are not resident are read and
+// decompressed on a background thread straight into a free slot, or into the
+// slot of the least recently wanted chunk, which is evicted. Finished slots
+// are handed to the renderer for upload by the render thread.
+class ChunkPager {
+
+public:
+    static constexpr uint32_t   NONE                = UINT32_MAX;
+    static constexpr size_t     MAX_IN_FLIGHT       = 8;        // chunk reads queued or running
+    static constexpr size_t     MAX_INSTALL_BYTES   = 64 << 20; // uploaded per frame at most
+    static constexpr float      PREFETCH_SECONDS    = 0.5f;
+
+    struct Stats {
+        size_t      chunks          = 0;
+        size_t      slots           = 0;
+        size_t      resident        = 0;
+        size_t      visible         = 0;    // chunks in the frustum and in range
+        size_t      visible_resident = 0;
+        size_t      prefetching     = 0;    // wanted for the predicted view only
+        size_t      loading         = 0;
+        uint64_t    loads           = 0;
+        uint64_t    evictions       = 0;
+        uint64_t    bytes_read      = 0;    // from the file, compressed
+        uint64_t    bytes_uploaded  = 0;
+        double      read_rate       = 0.0;  // MB/s over the last second
+        double      upload_rate     = 0.0;
+    };
+
+    // budget_bytes: memory for splats, taken once on the host and once on the
+    // GPU; range: farthest chunk distance kept resident, 0 for no limit
+    ChunkPager(const char* filename, size_t budget_bytes, float range = 0.0f):
+        _reader(filename), _range(range) {
+
+        const LvzHeader& header = _reader.header();
+        if (!(header.flags & LVZ_SPATIAL)) {
+            throw std::runtime_error("Out-of-core viewing needs a .lvz written with --spatial: " + std::string(filename));
+        }
+
+        _chunk_size = header.chunk_size;
+        const size_t chunk_bytes = _chunk_size * (3 * sizeof(float) + _reader.rowBytes());
+        const size_t slots = std::clamp<size_t>(budget_bytes / chunk_bytes, 1, _reader.chunks());
+        _reader.allocate(_pool, slots * _chunk_size);
+
+        const size_t chunks = _reader.chunks();
+        _boxes.resize(chunks);
+        _radius.resize(chunks);
+        for (size_t c = 0; c < chunks; ++c) {
+            const LvzBounds& b = _reader.bounds()[c];
+            _boxes[c] = Eigen::AlignedBox3f(Eigen::Vector3f(b.min[0], b.min[1], b.min[2]),
+                                            Eigen::Vector3f(b.max[0], b.max[1], b.max[2]));
+            _radius[c] = b.radius;
+        }
+        _chunk_slot.assign(chunks, NONE);
+        _state.assign(chunks, EMPTY);
+        _last_wanted.assign(chunks, 0);
+        _slot_chunk.assign(slots, NONE);
+        for (size_t s = slots; s > 0; --s) _free.push_back(static_cast<uint32_t>(s - 1));
+
+        _stats.chunks = chunks;
+        _stats.slots = slots;
+        _thread = std::thread(&ChunkPager::loadLoop, this);
+    }
+
+    ~ChunkPager() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_one();
+        if (_thread.joinable()) _thread.join();
+    }
+
+    ChunkPager(const ChunkPager&) = delete;
+    ChunkPager& operator=(const ChunkPager&) = delete;
+
+    // slots() x chunk size rows; rows of slots not installed hold stale data
+    const GaussianData& pool() const { return _pool; }
+
+    size_t sceneSize() const { return _reader.header().count; }
+
+    const Stats& stats() const { return _stats; }
+
+    // Render thread, once per frame: installs finished reads, picks the wanted
+    // chunks for a camera at eye and starts reading the missing ones.
+    void update(const Eigen::Vector3f& eye, const FrustumCuller::Planes& planes, float radius_scale) {
+
+        const double now = _timer.elapsed();
+        const double dt = now - _last_time;
+        if (_frame > 0 && dt > 0.0) {
+            _velocity = 0.8f * _velocity + 0.2f * (eye - _last_eye) / static_cast<float>(dt);
+        }
+        _last_eye = eye;
+        _last_time = now;
+        ++_frame;
+
+        install();
+
+        // the same view moved ahead: a plane n.x + d >= 0 seen from eye + delta
+        // is n.x + d - n.delta >= 0
+        const Eigen::Vector3f ahead = eye + PREFETCH_SECONDS * _velocity;
+        FrustumCuller::Planes predicted = planes;
+        predicted.col(3) -= planes.leftCols<3>() * (ahead - eye);
+
+        struct Want {
+            int         tier;   // 0: visible now, 1: visible from ahead
+            float       distance;
+            uint32_t    chunk;
+            bool operator<(const Want& other) const {
+                return tier != other.tier ? tier < other.tier : distance < other.distance;
+            }
+        };
+        std::vector<Want> wanted;
+        _stats.visible = _stats.visible_resident = _stats.prefetching = 0;
+        for (uint32_t c = 0; c < _boxes.size(); ++c) {
+            const float radius = radius_scale * _radius[c];
+            const float distance = _boxes[c].exteriorDistance(eye);
+            if (inRange(distance) && FrustumCuller::classify(planes, _boxes[c], radius) != FrustumCuller::OUTSIDE) {
+                wanted.push_back({ 0, distance, c });
+                ++_stats.visible;
+                _stats.visible_resident += _state[c] == RESIDENT;
+                continue;
+            }
+            const float distance_ahead = _boxes[c].exteriorDistance(ahead);
+            if (inRange(distance_ahead) && FrustumCuller::classify(predicted, _boxes[c], radius) != FrustumCuller::OUTSIDE) {
+                wanted.push_back({ 1, distance_ahead, c });
+                ++_stats.prefetching;
+            }
+        }
+
+        // what the pool can hold, in priority order
+        const size_t keep = std::min(wanted.size(), _slot_chunk.size());
+        std::partial_sort(wanted.begin(), wanted.begin() + keep, wanted.end());
+        wanted.resize(keep);
+        for (const Want& w : wanted) _last_wanted[w.chunk] = _frame;
+
+        std::vector<Job> jobs;
+        for (const Want& w : wanted) {
+            if (_in_flight + jobs.size() >= MAX_IN_FLIGHT) break;
+            if (_state[w.chunk] != EMPTY) continue;
+            const uint32_t slot = claimSlot();
+            if (slot == NONE) break;
+            _slot_chunk[slot] = w.chunk;
+            _chunk_slot[w.chunk] = slot;
+            _state[w.chunk] = LOADING;
+            jobs.push_back({ w.chunk, slot });
+        }
+
+        if (!jobs.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _jobs.insert(_jobs.end(), jobs.begin(), jobs.end());
+            }
+            _in_flight += jobs.size();
+            _wake.notify_one();
+        }
+
+        _stats.loading = _in_flight;
+        _stats.bytes_read = _bytes_read.load(std::memory_order_relaxed);
+        if (now - _rate_time >= 1.0) {
+            _stats.read_rate = (_stats.bytes_read - _rate_read) / (now - _rate_time) / (1 << 20);
+            _stats.upload_rate = (_stats.bytes_uploaded - _rate_uploaded) / (now - _rate_time) / (1 << 20);
+            _rate_read = _stats.bytes_read;
+            _rate_uploaded = _stats.bytes_uploaded;
+            _rate_time = now;
+        }
+    }
+
+    // Pool rows [first, second) installed since the last call; the renderer
+    // uploads them before drawing.
+    std::vector<std::pair<size_t, size_t>> takeInstalled() {
+        std::vector<std::pair<size_t, size_t>> rows;
+        rows.swap(_installed);
+        return rows;
+    }
+
+    // Pool rows of the resident chunks that pass planes (all resident chunks
+    // without planes). Writes them to rows and returns their count.
+    size_t select(const FrustumCuller::Planes* planes, float radius_scale, std::vector<uint32_t>& rows) const {
+        rows.clear();
+        for (uint32_t slot = 0; slot < _slot_chunk.size(); ++slot) {
+            const uint32_t c = _slot_chunk[slot];
+            if (c == NONE || _state[c] != RESIDENT) continue;
+            if (planes && FrustumCuller::classify(*planes, _boxes[c], radius_scale * _radius[c]) == FrustumCuller::OUTSIDE) {
+                continue;
+            }
+            const uint32_t first = slot * _chunk_size;
+            for (uint32_t k = 0; k < _reader.chunk(c).count; ++k) rows.push_back(first + k);
+        }
+        return rows.size();
+    }
+
+private:
+
+    enum State : uint8_t {
+        EMPTY,
+        LOADING,
+        RESIDENT,
+    };
+
+    struct Job {
+        uint32_t    chunk;
+        uint32_t    slot;
+    };
+
+    bool inRange(float distance) const { return _range <= 0.0f || distance <= _range; }
+
+    // a free slot, else the slot of the least recently wanted resident chunk
+    // not wanted this frame, which is evicted
+    uint32_t claimSlot() {
+        if (!_free.empty()) {
+            const uint32_t slot = _free.back();
+            _free.pop_back();
+            return slot;
+        }
+        uint32_t victim = NONE;
+        for (uint32_t slot = 0; slot < _slot_chunk.size(); ++slot) {
+            const uint32_t c = _slot_chunk[slot];
+            if (c == NONE || _state[c] != RESIDENT || _last_wanted[c] == _frame) continue;
+            if (victim == NONE || _last_wanted[c] < _last_wanted[_slot_chunk[victim]]) victim = slot;
+        }
+        if (victim == NONE) return NONE;
+
+        const uint32_t c = _slot_chunk[victim];
+        _state[c] = EMPTY;
+        _chunk_slot[c] = NONE;
+        _slot_chunk[victim] = NONE;
+        --_stats.resident;
+        ++_stats.evictions;
+        return victim;
+    }
+
+    // finished reads become resident, up to MAX_INSTALL_BYTES of them per frame
+    void install() {
+        std::vector<Job> done;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            size_t bytes = 0, n = 0;
+            while (n < _done.size() && bytes < MAX_INSTALL_BYTES) {
+                bytes += _reader.chunk(_done[n].chunk).count * (3 * sizeof(float) + _reader.rowBytes());
+                ++n;
+            }
+            done.assign(_done.begin(), _done.begin() + n);
+            _done.erase(_done.begin(), _done.begin() + n);
+        }
+
+        for (const Job& job : done) {
+            const size_t first = size_t(job.slot) * _chunk_size;
+            const size_t count = _reader.chunk(job.chunk).count;
+            _state[job.chunk] = RESIDENT;
+            _installed.emplace_back(first, first + count);
+            _stats.bytes_uploaded += count * (3 * sizeof(float) + _reader.rowBytes());
+            ++_stats.resident;
+            ++_stats.loads;
+            --_in_flight;
+        }
+    }
+
+    // Background thread: reads every queued chunk into its slot, in parallel.
+    void loadLoop() {
+        for (;;) {
+            std::vector<Job> jobs;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [this] { return _stop || !_jobs.empty(); });
+                if (_stop) return;
+                jobs.swap(_jobs);
+            }
+
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, jobs.size(), 1),
+                [&](const tbb::blocked_range<size_t>& r) {
+                    for (size_t j = r.begin(); j < r.end(); ++j) {
+                        _reader.read(jobs[j].chunk, _pool, size_t(jobs[j].slot) * _chunk_size);
+                        const LvzChunk& chunk = _reader.chunk(jobs[j].chunk);
+                        _bytes_read.fetch_add(chunk.bytes[0] + chunk.bytes[1], std::memory_order_relaxed);
+                    }
+                });
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done.insert(_done.end(), jobs.begin(), jobs.end());
+        }
+    }
+
+    LvzReader                   _reader;
+    GaussianData                _pool;          // written by the loader thread in LOADING slots only
+    uint32_t                    _chunk_size = 0;
+    float                       _range;
+
+    // per chunk
+    std::vector<Eigen::AlignedBox3f> _boxes;
+    std::vector<float>          _radius;
+    std::vector<uint32_t>       _chunk_slot;
+    std::vector<State>          _state;
+    std::vector<uint64_t>       _last_wanted;   // frame
+
+    // per slot
+    std::vector<uint32_t>       _slot_chunk;
+    std::vector<uint32_t>       _free;
+
+    // render thread
+    Timer                       _timer;
+    uint64_t                    _frame = 0;
+    double                      _last_time = 0.0;
+    Eigen::Vector3f             _last_eye = Eigen::Vector3f::Zero();
+    Eigen::Vector3f             _velocity = Eigen::Vector3f::Zero();
+    size_t                      _in_flight = 0;
+    std::vector<std::pair<size_t, size_t>> _installed;
+    Stats                       _stats;
+    double                      _rate_time = 0.0;
+    uint64_t                    _rate_read = 0;
+    uint64_t                    _rate_uploaded = 0;
+
+    // shared with the loader thread
+    std::thread                 _thread;
+    std::mutex                  _mutex;
+    std::condition_variable     _wake;
+    std::vector<Job>            _jobs;
+    std::vector<Job>            _done;
+    bool                        _stop = false;
+    std::atomic<uint64_t>       _bytes_read { 0 };
+};
+
+#endif // __PAGER_H__
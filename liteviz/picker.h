@@ -0,0 +1,103 @@
+#ifndef __PICKER_H__
+#define __PICKER_H__
+
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <Eigen/Dense>
+#include <liteviz/utils.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/viewport.h>
+#include <liteviz/octree.h>
+
+// Pivot picking for the camera controls: the first opaque splat under the
+// cursor, found by a ray cast through a SplatOctree on the CPU. Nothing is
+// read back from the GPU, so a press never waits for the frame in flight.
+// A splat counts as opaque where its one sigma ellipsoid is, if its opacity
+// is at least MIN_OPACITY; the ray cast tests at most MAX_LEAVES leaves,
+// which bounds the latency of a pick.
+class SplatPicker {
+
+public:
+    static constexpr float  SIGMA       = 1.0f;
+    static constexpr float  MIN_OPACITY = 0.5f;
+    static constexpr size_t MAX_LEAVES  = 4096;
+
+    struct Latency {
+        double  last    = 0.0;  // seconds
+        double  max     = 0.0;
+        double  total   = 0.0;
+        size_t  picks   = 0;
+        size_t  hits    = 0;
+
+        double mean() const { return picks ? total / picks : 0.0; }
+    };
+
+    SplatPicker() = default;
+
+    ~SplatPicker() {
+        if (_thread.joinable()) _thread.join();
+    }
+
+    // Builds an octree over data on a background thread; picks miss until
+    // it is ready. data must outlive the picker and stay unchanged.
+    void build(const GaussianData& data) {
+        _thread = std::thread([this, &data]() {
+            _own.build(data);
+            _octree = &_own;
+            _ready = true;
+        });
+    }
+
+    // picks through an octree built elsewhere, e.g. SplatLOD::octree()
+    void use(const SplatOctree& octree) {
+        _octree = &octree;
+        _ready = true;
+    }
+
+    bool ready() const { return _ready; }
+
+    // build() or use() was called
+    bool started() const { return _ready || _thread.joinable(); }
+
+    // Window depth in [0, 1] of the first opaque splat under the window
+    // position pos (pixels, top left origin), as glReadPixels would return
+    // it from a depth buffer; false if the ray hits nothing.
+    bool pick(const Viewport& viewport, const Eigen::Vector2f& pos, float scale_modifier, float& depth) {
+
+        if (!_ready) return false;
+        Timer timer;
+
+        // the OpenGL camera looks down -z with y up
+        const Eigen::Vector2f tanxy = viewport.getTanXY();
+        const Eigen::Vector2f ndc(2.0f * pos.x() / viewport.windowSize.x() - 1.0f,
+                                  1.0f - 2.0f * pos.y() / viewport.windowSize.y());
+        const Eigen::Vector3f dir = viewport.getCameraRotation() *
+                                    Eigen::Vector3f(ndc.x() * tanxy.x(), ndc.y() * tanxy.y(), -1.0f);
+        const SplatOctree::Hit hit = _octree->raycast(viewport.getCameraPosition(), dir, SIGMA, scale_modifier,
+                                                      MIN_OPACITY, MAX_LEAVES);
+        if (hit.valid()) {
+            const Eigen::Vector4f clip = viewport.getProjectionMatrix() * viewport.getViewMatrix() *
+                                         hit.position.homogeneous();
+            depth = 0.5f * clip.z() / clip.w() + 0.5f;
+        }
+
+        _latency.last = timer.elapsed();
+        _latency.max = std::max(_latency.max, _latency.last);
+        _latency.total += _latency.last;
+        ++_latency.picks;
+        _latency.hits += hit.valid();
+        return hit.valid() && depth > 0.0f && depth < 1.0f;
+    }
+
+    const Latency& latency() const { return _latency; }
+
+private:
+    SplatOctree             _own;
+    const SplatOctree*      _octree     = nullptr;
+    std::thread             _thread;
+    std::atomic<bool>       _ready      { false };
+    Latency                 _latency;
+};
+
+#endif // __PICKER_H__
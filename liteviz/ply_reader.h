@@ -0,0 +1,139 @@
+#ifndef __PLY_READER_H__
+#define __PLY_READER_H__
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+
+public:
+    MappedFile(const std::string& filename) {
+        _fd = ::open(filename.c_str(), O_RDONLY);
+        if (_fd < 0) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+        struct stat st;
+        if (fstat(_fd, &st) != 0) {
+            ::close(_fd);
+            throw std::runtime_error("Failed to stat file: " + filename);
+        }
+        _size = static_cast<size_t>(st.st_size);
+        if (_size > 0) {
+            void* ptr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+            if (ptr == MAP_FAILED) {
+                ::close(_fd);
+                throw std::runtime_error("Failed to map file: " + filename);
+            }
+            _data = static_cast<const uint8_t*>(ptr);
+        }
+    }
+
+    ~MappedFile() {
+        if (_data) munmap(const_cast<uint8_t*>(_data), _size);
+        if (_fd >= 0) ::close(_fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // ask the kernel to start reading [offset, offset + length) ahead of use
+    void prefetch(size_t offset, size_t length) const {
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t begin = offset / page * page;
+        if (begin >= _size) return;
+        madvise(const_cast<uint8_t*>(_data) + begin, std::min(_size - begin, length + offset - begin), MADV_WILLNEED);
+    }
+
+    const uint8_t* data() const { return _data; }
+
+    size_t size() const { return _size; }
+
+private:
+    int             _fd     = -1;
+    const uint8_t*  _data   = nullptr;
+    size_t          _size   = 0;
+};
+
+// Header of a PLY file whose first element is "vertex" with only float
+// properties stored as binary little endian, i.e. the layout every 3DGS
+// trainer writes. Anything else is left to the generic tinyply path.
+struct PlyVertexLayout {
+
+    size_t                      count       = 0;    // number of vertices
+    size_t                      data_offset = 0;    // first byte after end_header
+    size_t                      stride      = 0;    // bytes per vertex record
+    std::vector<std::string>    properties;         // in record order
+
+    // byte offset of a property within a record, or -1
+    int offset(const std::string& name) const {
+        for (size_t i = 0; i < properties.size(); ++i) {
+            if (properties[i] == name) return static_cast<int>(i * sizeof(float));
+        }
+        return -1;
+    }
+
+    static bool parse(const uint8_t* data, size_t size, PlyVertexLayout& layout) {
+
+        static const char* END = "end_header";
+        if (size < 4 || std::memcmp(data, "ply", 3) != 0) return false;
+
+        const char* begin = reinterpret_cast<const char*>(data);
+        const size_t limit = std::min<size_t>(size, 1 << 20);
+        const char* end = static_cast<const char*>(memmem(begin, limit, END, strlen(END)));
+        if (end == nullptr) return false;
+
+        const char* body = static_cast<const char*>(memchr(end, '\n', limit - (end - begin)));
+        if (body == nullptr) return false;
+
+        const uint16_t probe = 1;
+        const bool host_little_endian = *reinterpret_cast<const uint8_t*>(&probe) == 1;
+
+        std::istringstream header(std::string(begin, end));
+        std::string line;
+        int element = -1;
+        bool binary_le = false;
+
+        while (std::getline(header, line)) {
+            std::istringstream tokens(line);
+            std::string keyword;
+            tokens >> keyword;
+
+            if (keyword == "format") {
+                std::string format;
+                tokens >> format;
+                binary_le = (format == "binary_little_endian");
+            } else if (keyword == "element") {
+                std::string name;
+                tokens >> name;
+                ++element;
+                if (element == 0) {
+                    if (name != "vertex") return false;
+                    tokens >> layout.count;
+                }
+            } else if (keyword == "property" && element == 0) {
+                std::string type, name;
+                tokens >> type >> name;
+                if (type != "float" && type != "float32") return false;
+                layout.properties.push_back(name);
+            }
+        }
+
+        if (!binary_le || !host_little_endian || layout.properties.empty()) return false;
+
+        layout.data_offset = static_cast<size_t>(body + 1 - begin);
+        layout.stride = layout.properties.size() * sizeof(float);
+        return layout.data_offset + layout.count * layout.stride <= size;
+    }
+};
+
+#endif // __PLY_READER_H__
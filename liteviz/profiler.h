@@ -0,0 +1,304 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <array>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <glad/glad.h>
+
+// Frame profiler: named CPU zones timed with the steady clock and GPU zones
+// timed with GL_TIME_ELAPSED queries, summed per frame into a rolling
+// window of WINDOW frames per stage from which the percentiles are taken.
+//
+// GPU zones never wait for the GPU: each stage cycles through QUERY_RING
+// queries, and newFrame() only reads back those whose result is available,
+// a few frames later. If all of a stage's queries are still in flight, the
+// zone goes untimed that frame. GL allows one GL_TIME_ELAPSED query at a
+// time, so a GPU zone inside another is not timed either.
+//
+// While tracing, every zone is also kept as a Chrome trace event (see
+// writeTrace(), opens in chrome://tracing or Perfetto); GPU zones appear on
+// their own track at the time they were issued, with the GPU's duration.
+//
+// Zones take a null Profiler* as profiling off, so code can be instrumented
+// unconditionally. A CPU stage gets one sample per frame, the sum of its
+// zones; a GPU stage one sample per zone.
+class Profiler {
+
+public:
+    static constexpr int        WINDOW      = 240;
+    static constexpr int        QUERY_RING  = 4;
+    static constexpr size_t     MAX_EVENTS  = 1 << 20;
+    static constexpr uint64_t   MAX_GPU_NS  = 60000000000ull;  // longer GPU zones are taken as bogus
+
+    struct Summary {
+        double  last    = 0.0;  // seconds
+        double  p50     = 0.0;
+        double  p95     = 0.0;
+        double  p99     = 0.0;
+    };
+
+    // CPU time from construction to end() or destruction.
+    class Zone {
+    public:
+        Zone(Profiler* profiler, const char* name):
+            _profiler(profiler), _stage(profiler ? profiler->stage(name, false) : 0),
+            _start(profiler ? profiler->now() : 0.0) {}
+
+        ~Zone() { end(); }
+
+        void end() {
+            if (!_profiler) return;
+            _profiler->record(_stage, _start, _profiler->now() - _start);
+            _profiler = nullptr;
+        }
+
+    private:
+        Profiler*   _profiler;
+        int         _stage;
+        double      _start;
+    };
+
+    // GPU time of the commands issued from construction to end() or destruction.
+    class GpuZone {
+    public:
+        GpuZone(Profiler* profiler, const char* name): _profiler(profiler) {
+            if (_profiler && !_profiler->beginQuery(profiler->stage(name, true))) _profiler = nullptr;
+        }
+
+        ~GpuZone() { end(); }
+
+        void end() {
+            if (!_profiler) return;
+            _profiler->endQuery();
+            _profiler = nullptr;
+        }
+
+    private:
+        Profiler*   _profiler;
+    };
+
+    Profiler(): _epoch(std::chrono::steady_clock::now()) {}
+
+    ~Profiler() {
+        for (Stage& stage : _stages) {
+            for (Query& query : stage.queries) {
+                if (query.id) glDeleteQueries(1, &query.id);
+            }
+        }
+    }
+
+    // Closes the previous frame: its time since the last call goes to the
+    // "frame" stage, its zone sums into their windows, and finished GPU
+    // queries are read back. Call once at the top of every frame.
+    void newFrame() {
+        const double now = this->now();
+        if (_frame_start >= 0.0) {
+            const double frame = now - _frame_start;
+            push(_frame_stats, frame);
+            if (_tracing) event(-1, _frame_start, frame);
+        }
+        _frame_start = now;
+
+        for (size_t i = 0; i < _stages.size(); ++i) {
+            Stage& stage = _stages[i];
+            if (stage.gpu) {
+                collect(static_cast<int>(i));
+            } else if (stage.touched) {
+                push(stage.stats, stage.sum);
+            }
+            stage.sum = 0.0;
+            stage.touched = false;
+        }
+    }
+
+    // Stops the frame clock while profiling is off, so the next newFrame()
+    // does not take the time in between for one long frame.
+    void pause() {
+        _frame_start = -1.0;
+    }
+
+    // stage names, in the order their first zone ran; GPU ones are marked
+    size_t stages() const { return _stages.size(); }
+
+    const std::string& name(size_t stage) const { return _stages[stage].name; }
+
+    bool gpu(size_t stage) const { return _stages[stage].gpu; }
+
+    Summary summary(size_t stage) const { return summarize(_stages[stage].stats); }
+
+    Summary frameSummary() const { return summarize(_frame_stats); }
+
+    // frame times in milliseconds, oldest first, for a graph
+    const std::vector<float>& frameGraph() {
+        _graph.resize(_frame_stats.count);
+        for (int k = 0; k < _frame_stats.count; ++k) {
+            _graph[k] = static_cast<float>(_frame_stats.window[(_frame_stats.next + WINDOW - _frame_stats.count + k) % WINDOW] * 1e3);
+        }
+        return _graph;
+    }
+
+    // Chrome trace events are collected between startTrace() and writeTrace().
+    void startTrace() {
+        _events.clear();
+        _tracing = true;
+    }
+
+    bool tracing() const { return _tracing; }
+
+    // Writes the events collected since startTrace() as Chrome trace JSON
+    // and stops tracing; false if the file could not be written.
+    bool writeTrace(const std::string& path) {
+        _tracing = false;
+        std::ofstream file(path);
+        if (!file) return false;
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n"
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+        char line[256];
+        for (const Event& e : _events) {
+            const bool gpu = e.stage >= 0 && _stages[e.stage].gpu;
+            std::snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                          e.stage >= 0 ? _stages[e.stage].name.c_str() : "frame", e.stage < 0 ? "frame" : gpu ? "gpu" : "cpu",
+                          e.start * 1e6, e.duration * 1e6, gpu ? 1 : 0);
+            file << line;
+        }
+        file << "\n]}\n";
+        _events.clear();
+        return bool(file);
+    }
+
+    size_t traceEvents() const { return _events.size(); }
+
+private:
+    struct Window {
+        std::array<double, WINDOW>  window {};
+        int                         next    = 0;
+        int                         count   = 0;
+    };
+
+    struct Query {
+        GLuint  id      = 0;
+        bool    pending = false;
+        double  issued  = 0.0;  // CPU time of the begin, for the trace
+    };
+
+    struct Stage {
+        std::string                         name;
+        bool                                gpu     = false;
+        double                              sum     = 0.0;  // CPU: this frame so far
+        bool                                touched = false;
+        Window                              stats;
+        std::array<Query, QUERY_RING>       queries;
+        int                                 next    = 0;
+    };
+
+    struct Event {
+        int         stage;      // -1 for the whole frame
+        double      start;
+        double      duration;
+    };
+
+    double now() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - _epoch).count();
+    }
+
+    int stage(const char* name, bool gpu) {
+        for (size_t i = 0; i < _stages.size(); ++i) {
+            if (_stages[i].gpu == gpu && _stages[i].name == name) return static_cast<int>(i);
+        }
+        _stages.emplace_back();
+        _stages.back().name = name;
+        _stages.back().gpu = gpu;
+        return static_cast<int>(_stages.size() - 1);
+    }
+
+    void record(int index, double start, double duration) {
+        Stage& stage = _stages[index];
+        stage.sum += duration;
+        stage.touched = true;
+        if (_tracing) event(index, start, duration);
+    }
+
+    bool beginQuery(int index) {
+        if (_gpu_active >= 0) return false;
+        Stage& stage = _stages[index];
+        Query& query = stage.queries[stage.next];
+        if (query.pending) {
+            collect(index);
+            if (query.pending) return false;
+        }
+        if (!query.id) glGenQueries(1, &query.id);
+        glBeginQuery(GL_TIME_ELAPSED, query.id);
+        query.pending = true;
+        query.issued = now();
+        _gpu_active = index;
+        return true;
+    }
+
+    void endQuery() {
+        glEndQuery(GL_TIME_ELAPSED);
+        Stage& stage = _stages[_gpu_active];
+        stage.next = (stage.next + 1) % QUERY_RING;
+        _gpu_active = -1;
+    }
+
+    // reads back the stage's finished queries, oldest first, without waiting
+    void collect(int index) {
+        Stage& stage = _stages[index];
+        for (int k = 0; k < QUERY_RING; ++k) {
+            Query& query = stage.queries[(stage.next + k) % QUERY_RING];
+            if (!query.pending) continue;
+            GLint available = 0;
+            glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break;
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &ns);
+            query.pending = false;
+            // llvmpipe times the first query of a context from its clock's zero
+            if (ns > MAX_GPU_NS) continue;
+            push(stage.stats, ns * 1e-9);
+            if (_tracing) event(index, query.issued, ns * 1e-9);
+        }
+    }
+
+    void event(int stage, double start, double duration) {
+        if (_events.size() < MAX_EVENTS) _events.push_back({ stage, start, duration });
+    }
+
+    static void push(Window& w, double value) {
+        w.window[w.next] = value;
+        w.next = (w.next + 1) % WINDOW;
+        w.count = std::min(w.count + 1, WINDOW);
+    }
+
+    static Summary summarize(const Window& w) {
+        Summary summary;
+        if (w.count == 0) return summary;
+        summary.last = w.window[(w.next + WINDOW - 1) % WINDOW];
+        std::array<double, WINDOW> sorted;
+        std::copy_n(w.window.begin(), w.count, sorted.begin());
+        std::sort(sorted.begin(), sorted.begin() + w.count);
+        auto percentile = [&](double p) { return sorted[std::min(w.count - 1, int(p * w.count))]; };
+        summary.p50 = percentile(0.50);
+        summary.p95 = percentile(0.95);
+        summary.p99 = percentile(0.99);
+        return summary;
+    }
+
+    std::chrono::steady_clock::time_point   _epoch;
+    std::vector<Stage>                      _stages;
+    Window                                  _frame_stats;
+    std::vector<float>                      _graph;
+    double                                  _frame_start    = -1.0;
+    int                                     _gpu_active     = -1;
+    bool                                    _tracing        = false;
+    std::vector<Event>                      _events;
+};
+
+#endif // __PROFILER_H__
@@ -0,0 +1,219 @@
+#ifndef __PROGRESSIVE_H__
+#define __PROGRESSIVE_H__
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <algorithm>
+#include <limits>
+#include <tbb/parallel_for.h>
+#include <tbb/spin_mutex.h>
+#include <tbb/task_arena.h>
+#include <liteviz/utils.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/container.h>
+
+// Loads a scene on a background thread while it is already being drawn. The
+// constructor only reads the header, plus a fixed sample of rows for 8-bit
+// SH, and sizes the storage for the full scene; the thread then fills it
+// front to back and publishes how many leading splats are complete. The
+// renderer draws that prefix and grows with it.
+//  - .lvz: chunk by chunk, in importance order when the converter sorted it
+//  - binary .ply: record ranges in file order through GaussianData::MappedPly
+//  - anything else: loaded in full up front
+class ProgressiveLoader {
+
+public:
+    static constexpr size_t PLY_CHUNK       = 1 << 16;
+    static constexpr size_t RANGE_SAMPLE    = 1 << 16;  // rows the first 8-bit SH range is taken from
+
+    // seconds since the loader was created, -1 until reached; the first two are
+    // written by the loader thread and safe to read once loaded() covers them
+    struct Timing {
+        double  first_chunk = -1.0;     // first splats decoded
+        double  first_pixel = -1.0;     // first frame drawn with splats
+        double  loaded      = -1.0;     // all splats decoded
+        double  complete    = -1.0;     // first frame drawn with all splats
+    };
+
+    ProgressiveLoader(const char* filename, int max_sh_degree = 3, GaussianData::Storage storage = GaussianData::FP32) {
+
+        if (SceneContainer::is_lvz(filename)) {
+            _lvz = std::make_unique<LvzReader>(filename);
+            _lvz->allocate(_data);
+            _thread = std::thread(&ProgressiveLoader::loadLvz, this);
+            return;
+        }
+
+        _ply = std::make_unique<GaussianData::MappedPly>();
+        if (_ply->open(filename, max_sh_degree)) {
+            const size_t N = _ply->count();
+            if (storage == GaussianData::FP32) {
+                _data.resize(N, _ply->sh_dim());
+            } else {
+                _data.xyz.resize(N, 3);
+                _data.packed.reset(N, _ply->sh_dim(), GaussianData::shFormat(storage));
+                if (storage == GaussianData::COMPACT_UINT8) {
+                    // the renderer needs the SH ranges from the start: a first guess from
+                    // rows spread over the file, made exact once all rows are decoded
+                    const size_t sample = std::min(N, RANGE_SAMPLE);
+                    _data.packed.computeRange(sample, [this, N, sample](size_t i, float* attr) {
+                        float pos[3];
+                        _ply->decode(i * N / sample, pos, attr);
+                    });
+                }
+            }
+            _thread = std::thread(&ProgressiveLoader::loadPly, this);
+            return;
+        }
+
+        _ply.reset();
+        _data = GaussianData::load_ply(filename, max_sh_degree, storage);
+        publish(_data.size());
+    }
+
+    ~ProgressiveLoader() {
+        _cancel = true;
+        if (_thread.joinable()) _thread.join();
+    }
+
+    ProgressiveLoader(const ProgressiveLoader&) = delete;
+    ProgressiveLoader& operator=(const ProgressiveLoader&) = delete;
+
+    // Sized for the whole scene; only the first loaded() splats hold data.
+    const GaussianData& data() const { return _data; }
+
+    size_t loaded() const { return _loaded.load(std::memory_order_acquire); }
+
+    bool done() const { return loaded() == _data.size(); }
+
+    const Timing& timing() const { return _timing; }
+
+    // 8-bit SH from a .ply: rows beyond the first range are clamped while
+    // loading, and once all are decoded they are packed again with the exact
+    // range if it differs. rangeVersion() counts those re-packs; the render
+    // thread holds lock() while it reads packed rows or the range, and when
+    // the version moved uploads both again (Renderer::requantize()).
+    std::unique_lock<std::mutex> lock() { return std::unique_lock<std::mutex>(_mutex); }
+
+    // as lock(), without waiting out a re-pack; check owns_lock()
+    std::unique_lock<std::mutex> tryLock() { return std::unique_lock<std::mutex>(_mutex, std::try_to_lock); }
+
+    size_t rangeVersion() const { return _range_version.load(std::memory_order_acquire); }
+
+    // render thread: report how many splats the frame just drawn contained
+    // after culling, and how many it had uploaded to draw from
+    void frameDrawn(size_t drawn, size_t uploaded) {
+        if (drawn > 0 && _timing.first_pixel < 0.0) {
+            _timing.first_pixel = _timer.elapsed();
+        }
+        if (uploaded == _data.size() && _timing.complete < 0.0) {
+            _timing.complete = _timer.elapsed();
+        }
+    }
+
+private:
+
+    // Chunks are read in growing batches: the first alone so something is on
+    // screen quickly, later ones wide enough to keep every core busy.
+    void loadLvz() {
+        const size_t chunks = _lvz->chunks();
+        const size_t max_batch = std::max(1, tbb::this_task_arena::max_concurrency());
+        size_t batch = 1;
+        for (size_t c = 0; c < chunks && !_cancel; c += batch, batch = std::min(2 * batch, max_batch)) {
+            const size_t end = std::min(chunks, c + batch);
+            tbb::parallel_for(tbb::blocked_range<size_t>(c, end, 1),
+                [&](const tbb::blocked_range<size_t>& r) {
+                    for (size_t k = r.begin(); k < r.end(); ++k) _lvz->read(k, _data);
+                });
+            publish(_lvz->chunkEnd(end - 1));
+        }
+    }
+
+    void loadPly() {
+        const size_t N = _ply->count();
+        const int cols = GaussianData::SH + _ply->sh_dim();
+        const size_t max_rows = PLY_CHUNK * std::max(1, tbb::this_task_arena::max_concurrency());
+        const bool quantized = _data.isCompact() && _data.packed.sh_format == CompactSplats::SH_UINT8;
+        const int dim = _ply->sh_dim();
+        // SH value range of the rows decoded so far
+        std::vector<float> lo(dim, std::numeric_limits<float>::max());
+        std::vector<float> hi(dim, std::numeric_limits<float>::lowest());
+        tbb::spin_mutex range_mutex;
+
+        size_t rows = PLY_CHUNK;
+        size_t begin = 0;
+        for (; begin < N && !_cancel; begin += rows, rows = std::min(2 * rows, max_rows)) {
+            const size_t end = std::min(N, begin + rows);
+            tbb::parallel_for(tbb::blocked_range<size_t>(begin, end, 1 << 14),
+                [&](const tbb::blocked_range<size_t>& r) {
+                    std::vector<float> attr(cols);
+                    std::vector<float> block_lo(lo.size(), std::numeric_limits<float>::max());
+                    std::vector<float> block_hi(hi.size(), std::numeric_limits<float>::lowest());
+                    for (size_t i = r.begin(); i < r.end(); ++i) {
+                        if (_data.isCompact()) {
+                            _ply->decode(i, &_data.xyz(i, 0), attr.data());
+                            _data.packed.packRow(i, attr.data());
+                        } else {
+                            _ply->decode(i, &_data.xyz(i, 0), &_data.attributes(i, 0));
+                        }
+                        if (!quantized) continue;
+                        for (int k = 0; k < dim; ++k) {
+                            block_lo[k] = std::min(block_lo[k], attr[GaussianData::SH + k]);
+                            block_hi[k] = std::max(block_hi[k], attr[GaussianData::SH + k]);
+                        }
+                    }
+                    if (!quantized) return;
+                    tbb::spin_mutex::scoped_lock guard(range_mutex);
+                    for (int k = 0; k < dim; ++k) {
+                        lo[k] = std::min(lo[k], block_lo[k]);
+                        hi[k] = std::max(hi[k], block_hi[k]);
+                    }
+                });
+            // the last rows wait for the exact range
+            if (end < N || !quantized) publish(end);
+        }
+        if (!quantized || begin < N) return;
+
+        CompactSplats exact;
+        exact.sh_dim = dim;
+        exact.setRange(lo.data(), hi.data());
+        if (exact.sh_range != _data.packed.sh_range) {
+            std::lock_guard<std::mutex> guard(_mutex);
+            _data.packed.sh_range = exact.sh_range;
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, N, 1 << 14),
+                [&](const tbb::blocked_range<size_t>& r) {
+                    std::vector<float> attr(cols);
+                    float pos[3];
+                    for (size_t i = r.begin(); i < r.end() && !_cancel; ++i) {
+                        _ply->decode(i, pos, attr.data());
+                        _data.packed.packRow(i, attr.data());
+                    }
+                });
+            if (_cancel) return;
+            _range_version.fetch_add(1, std::memory_order_release);
+        }
+        publish(N);
+    }
+
+    void publish(size_t count) {
+        if (_timing.first_chunk < 0.0) _timing.first_chunk = _timer.elapsed();
+        if (count == _data.size()) _timing.loaded = _timer.elapsed();
+        _loaded.store(count, std::memory_order_release);
+    }
+
+    Timer                                       _timer;
+    GaussianData                                _data;
+    std::unique_ptr<LvzReader>                  _lvz;
+    std::unique_ptr<GaussianData::MappedPly>    _ply;
+    std::thread                                 _thread;
+    std::atomic<size_t>                         _loaded { 0 };
+    std::atomic<bool>                           _cancel { false };
+    std::mutex                                  _mutex;             // around re-packing the rows
+    std::atomic<size_t>                         _range_version { 0 };
+    Timing                                      _timing;
+};
+
+#endif // __PROGRESSIVE_H__
@@ -0,0 +1,250 @@
+#ifndef __QUANTIZE_H__
+#define __QUANTIZE_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <tbb/parallel_for.h>
+
+// IEEE binary16 conversion, round to nearest even. Matches GLSL packHalf2x16.
+inline uint16_t float_to_half(float value) {
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof(f));
+    const uint16_t sign = static_cast<uint16_t>((f >> 16) & 0x8000);
+    f &= 0x7fffffff;
+
+    if (f >= 0x47800000) {
+        // too large for a half: inf, or a quiet nan
+        return sign | (f > 0x7f800000 ? 0x7e00 : 0x7c00);
+    }
+    if (f < 0x38800000) {
+        // subnormal half, counted in steps of 2^-24
+        float magnitude;
+        std::memcpy(&magnitude, &f, sizeof(f));
+        return sign | static_cast<uint16_t>(std::nearbyint(magnitude * 16777216.0f));
+    }
+    // rebias the exponent and round the 13 dropped mantissa bits
+    f += 0xc8000fff + ((f >> 13) & 1);
+    return sign | static_cast<uint16_t>(f >> 13);
+}
+
+inline float half_to_float(uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1f;
+    const uint32_t mantissa = h & 0x3ff;
+
+    if (exponent == 0) {
+        float value = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -value : value;
+    }
+    uint32_t bits = exponent == 31 ? (sign | 0x7f800000 | (mantissa << 13))
+                                   : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline uint32_t pack_half2(float a, float b) {
+    return static_cast<uint32_t>(float_to_half(a)) | (static_cast<uint32_t>(float_to_half(b)) << 16);
+}
+
+// Unit quaternion in 32 bits, "smallest three": the index of the largest
+// component in the top 2 bits and the other three, which lie within
+// +-1/sqrt(2), as 10-bit fixed point. q and -q are the same rotation, so the
+// sign is flipped to make the dropped component positive.
+inline uint32_t pack_quaternion(const float q[4]) {
+    int largest = 0;
+    for (int i = 1; i < 4; ++i) {
+        if (std::abs(q[i]) > std::abs(q[largest])) largest = i;
+    }
+    const float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+    uint32_t word = static_cast<uint32_t>(largest) << 30;
+    int shift = 20;
+    for (int i = 0; i < 4; ++i) {
+        if (i == largest) continue;
+        float v = std::clamp(sign * q[i] * static_cast<float>(M_SQRT2), -1.0f, 1.0f);
+        word |= static_cast<uint32_t>(std::lround((v * 0.5f + 0.5f) * 1023.0f)) << shift;
+        shift -= 10;
+    }
+    return word;
+}
+
+// CPU twin of get_rotation() in draw_splat.vert.
+inline void unpack_quaternion(uint32_t word, float q[4]) {
+    const int largest = static_cast<int>(word >> 30);
+    float v[3];
+    float sum = 0.0f;
+    for (int j = 0; j < 3; ++j) {
+        v[j] = ((((word >> (20 - 10 * j)) & 1023u) / 1023.0f) * 2.0f - 1.0f) * static_cast<float>(M_SQRT1_2);
+        sum += v[j] * v[j];
+    }
+    for (int i = 0, j = 0; i < 4; ++i) {
+        q[i] = i == largest ? std::sqrt(std::max(0.0f, 1.0f - sum)) : v[j++];
+    }
+}
+
+// Compact encoding of the per-splat attributes (everything except the
+// position), stored as 32-bit words per splat:
+//   word 0      rotation, smallest-three
+//   word 1      scale.x | scale.y          (fp16 x 2)
+//   word 2      scale.z | opacity          (fp16 x 2)
+//   word 3..    SH coefficients, fp16 (2 per word) or 8-bit (4 per word)
+// 8-bit SH values are min + q * step with one (min, step) pair per coefficient
+// across the whole scene. Read by the COMPACT_STORAGE path of draw_splat.vert.
+struct CompactSplats {
+
+    enum SHFormat {
+        SH_FP16,
+        SH_UINT8,
+    };
+
+    static constexpr int ROT_WORD           = 0;
+    static constexpr int SCALE_WORD         = 1;
+    static constexpr int SCALE_OPACITY_WORD = 2;
+    static constexpr int SH_WORD            = 3;
+
+    SHFormat                sh_format   = SH_FP16;
+    int                     sh_dim      = 0;
+    int                     stride      = 0;    // words per splat
+    std::vector<uint32_t>   words;              // N x stride
+    std::vector<float>      sh_range;           // SH_UINT8 only: min[sh_dim] | step[sh_dim]
+
+    bool empty() const { return words.empty(); }
+
+    size_t size() const { return stride ? words.size() / stride : 0; }
+
+    // GPU bytes per splat including the fp32 position
+    size_t bytesPerSplat() const { return stride * sizeof(uint32_t) + 3 * sizeof(float); }
+
+    static int shWords(int sh_dim, SHFormat format) {
+        return format == SH_FP16 ? (sh_dim + 1) / 2 : (sh_dim + 3) / 4;
+    }
+
+    static constexpr size_t GRAIN = 1 << 14;
+
+    // Encodes N splats whose attribute rows (quaternion | scale | opacity | SH,
+    // the GaussianData layout) are produced on demand by row(i, float* out).
+    // 8-bit SH takes a first pass over all rows to find the value ranges.
+    template <typename RowFn>
+    void build(size_t N, int dim, SHFormat format, RowFn&& row) {
+
+        reset(N, dim, format);
+        if (format == SH_UINT8) {
+            computeRange(N, row);
+        }
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                std::vector<float> attr(8 + dim);
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    row(i, attr.data());
+                    packRow(i, attr.data());
+                }
+            });
+    }
+
+    // Sizes zeroed storage for N splats; packRow() fills it splat by splat.
+    void reset(size_t N, int dim, SHFormat format) {
+        sh_format = format;
+        sh_dim = dim;
+        stride = SH_WORD + shWords(dim, format);
+        words.assign(N * stride, 0);
+        sh_range.clear();
+    }
+
+    // 8-bit SH: per coefficient min and step over all N rows.
+    template <typename RowFn>
+    void computeRange(size_t N, RowFn&& row) {
+
+        const int dim = sh_dim;
+        const int cols = 8 + dim;
+        const size_t blocks = (N + GRAIN - 1) / GRAIN;
+        std::vector<float> lo(blocks * dim, std::numeric_limits<float>::max());
+        std::vector<float> hi(blocks * dim, std::numeric_limits<float>::lowest());
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, blocks, 1),
+            [&](const tbb::blocked_range<size_t>& r) {
+                std::vector<float> attr(cols);
+                for (size_t b = r.begin(); b < r.end(); ++b) {
+                    float* block_lo = &lo[b * dim];
+                    float* block_hi = &hi[b * dim];
+                    for (size_t i = b * GRAIN; i < std::min(N, (b + 1) * GRAIN); ++i) {
+                        row(i, attr.data());
+                        for (int k = 0; k < dim; ++k) {
+                            block_lo[k] = std::min(block_lo[k], attr[8 + k]);
+                            block_hi[k] = std::max(block_hi[k], attr[8 + k]);
+                        }
+                    }
+                }
+            });
+
+        std::vector<float> min_k(dim, 0.0f), max_k(dim, 0.0f);
+        for (int k = 0; k < dim && N > 0; ++k) {
+            min_k[k] = std::numeric_limits<float>::max();
+            max_k[k] = std::numeric_limits<float>::lowest();
+            for (size_t b = 0; b < blocks; ++b) {
+                min_k[k] = std::min(min_k[k], lo[b * dim + k]);
+                max_k[k] = std::max(max_k[k], hi[b * dim + k]);
+            }
+        }
+        setRange(min_k.data(), max_k.data());
+    }
+
+    // 8-bit SH: the range that spans [lo[k], hi[k]] for each coefficient k.
+    void setRange(const float* lo, const float* hi) {
+        sh_range.assign(2 * sh_dim, 0.0f);
+        for (int k = 0; k < sh_dim; ++k) {
+            sh_range[k] = lo[k];
+            sh_range[sh_dim + k] = (hi[k] - lo[k]) / 255.0f;
+        }
+    }
+
+    // Encodes splat i from an attribute row into storage sized by reset().
+    void packRow(size_t i, const float* attr) {
+        uint32_t* w = &words[i * stride];
+        w[ROT_WORD] = pack_quaternion(attr);
+        w[SCALE_WORD] = pack_half2(attr[4], attr[5]);
+        w[SCALE_OPACITY_WORD] = pack_half2(attr[6], attr[7]);
+
+        const float* sh = attr + 8;
+        uint32_t* sh_words = w + SH_WORD;
+        if (sh_format == SH_FP16) {
+            for (int k = 0; k < sh_dim; k += 2) {
+                sh_words[k / 2] = pack_half2(sh[k], k + 1 < sh_dim ? sh[k + 1] : 0.0f);
+            }
+        } else {
+            std::fill_n(sh_words, shWords(sh_dim, SH_UINT8), 0u);
+            for (int k = 0; k < sh_dim; ++k) {
+                const float step = sh_range[sh_dim + k];
+                const float q = step > 0.0f ? std::round((sh[k] - sh_range[k]) / step) : 0.0f;
+                sh_words[k / 4] |= static_cast<uint32_t>(std::clamp(q, 0.0f, 255.0f)) << (8 * (k % 4));
+            }
+        }
+    }
+
+    // Decodes splat i back into an attribute row, as the shader sees it.
+    void unpackRow(size_t i, float* attr) const {
+        const uint32_t* w = &words[i * stride];
+        unpack_quaternion(w[ROT_WORD], attr);
+        attr[4] = half_to_float(w[SCALE_WORD] & 0xffff);
+        attr[5] = half_to_float(w[SCALE_WORD] >> 16);
+        attr[6] = half_to_float(w[SCALE_OPACITY_WORD] & 0xffff);
+        attr[7] = half_to_float(w[SCALE_OPACITY_WORD] >> 16);
+
+        float* sh = attr + 8;
+        const uint32_t* sh_words = w + SH_WORD;
+        for (int k = 0; k < sh_dim; ++k) {
+            if (sh_format == SH_FP16) {
+                sh[k] = half_to_float((sh_words[k / 2] >> (16 * (k % 2))) & 0xffff);
+            } else {
+                sh[k] = sh_range[k] + static_cast<float>((sh_words[k / 4] >> (8 * (k % 4))) & 0xff) * sh_range[sh_dim + k];
+            }
+        }
+    }
+};
+
+#endif // __QUANTIZE_H__
@@ -0,0 +1,336 @@
+#ifndef __RASTERIZER_H__
+#define __RASTERIZER_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <Eigen/Dense>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/viewport.h>
+#include <liteviz/render_config.h>
+#include <liteviz/sh.h>
+
+// Reference splat rasterizer on the CPU, for machines without a GPU (CI,
+// batch nodes): no GL context is made and no GL call is issued.
+//
+// It follows draw_splat.vert/.frag: the same center rejection, 2D
+// covariance with low-pass dilation, 3-sigma quads, opacity falloff and
+// render modes, so on an RGBA8 target its image matches the viewer's up to
+// rounding. The pipeline is the tile-based one of the 3DGS reference:
+//  - project every splat in parallel and count the 16x16 tiles its quad covers,
+//  - emit one (tile, depth) key per covered tile and sort them, which leaves a
+//    front-to-back list per tile,
+//  - composite each tile front to back on its own, 16 pixels of a row at a time
+//    in loops vectorized like sh.h's kernels, and stop once every pixel is opaque.
+// Front-to-back differs from the viewer's back-to-front blending only by
+// what falls behind a transmittance of T_MIN.
+class CpuRasterizer {
+
+public:
+    static constexpr int    TILE    = 16;
+    static constexpr size_t GRAIN   = 1 << 12;
+    static constexpr float  T_MIN   = 1e-4f;    // transmittance below which a pixel counts as opaque
+
+    // Renders data seen from viewport with config's render mode and scale
+    // modifier into rgba: viewport.frameBufferSize pixels, top row first,
+    // rgb composited over background and alpha the coverage 1 - T.
+    void render(const GaussianData& data, const Viewport& viewport, const RenderConfig& config,
+                std::vector<float>& rgba, const Eigen::Vector3f& background = Eigen::Vector3f::Zero()) {
+
+        _width = viewport.getFrameBufferSize().x();
+        _height = viewport.getFrameBufferSize().y();
+        _tiles_x = (_width + TILE - 1) / TILE;
+        _tiles_y = (_height + TILE - 1) / TILE;
+
+        project(data, viewport, config);
+        bin();
+
+        rgba.resize(size_t(4) * _width * _height);
+        const bool gauss_ball = config.render_mode == RenderConfig::GAUSS_BALL;
+        tbb::parallel_for(size_t(0), size_t(_tiles_x) * _tiles_y, [&](size_t tile) {
+            composite(static_cast<int>(tile), gauss_ball, background, rgba.data());
+        });
+    }
+
+    // (tile, splat) pairs composited by the last render()
+    size_t entries() const { return _keys.size(); }
+
+private:
+    using Key = std::pair<uint64_t, uint32_t>;     // (tile << 32 | depth, splat)
+
+    // a splat as draw_splat.vert leaves it, in image pixels with y down
+    struct Projected {
+        Eigen::Vector2f center;
+        Eigen::Vector3f conic;      // inverse 2D covariance: xx, xy, yy
+        Eigen::Vector3f color;
+        float           opacity;
+        float           depth;
+        int             rect[4];    // covered pixels x0, y0, x1, y1, inclusive
+        uint32_t        tiles;      // covered tiles, 0 when rejected
+    };
+
+    void project(const GaussianData& data, const Viewport& viewport, const RenderConfig& config) {
+
+        const size_t N = data.size();
+        const Eigen::Matrix4f viewmat = viewport.getViewMatrix();
+        const Eigen::Matrix4f projmat = viewport.getProjectionMatrix();
+        const Eigen::Vector3f cam_pos = viewport.getCameraPosition();
+        const Eigen::Vector2f tanxy = viewport.getTanXY();
+        const float focal = viewport.getFocal();
+        const float modifier2 = config.scale_modifier * config.scale_modifier;
+        const int mode = config.render_mode;
+
+        // the shader measures the quad in pixels of the window, wh of them
+        // across, which may differ from the framebuffer's on high-DPI screens
+        const Eigen::Vector2f wh = 2.0f * tanxy * focal;
+        const Eigen::Vector2f to_image(_width / wh.x(), _height / wh.y());
+
+        if (mode != RenderConfig::DEPTH) {
+            _rgb.resize(3 * N);
+            eval_sh_colors(data, 0, N, cam_pos, std::min(mode, 3), _rgb.data());
+        }
+
+        _projected.resize(N);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                float c[GaussianData::COV_DIM], attr[GaussianData::SH];
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    Projected& s = _projected[i];
+                    s.tiles = 0;
+
+                    const Eigen::Vector4f view = viewmat * data.xyz.row(i).transpose().homogeneous();
+                    const Eigen::Vector4f clip = projmat * view;
+                    if (clip.w() <= 0.0f) continue;
+                    const Eigen::Vector3f ndc = clip.head<3>() / clip.w();
+                    // the shader's rejection, then GL's clipping of the quad at the near and far planes
+                    if (std::abs(ndc.x()) > 1.3f || std::abs(ndc.y()) > 1.3f || std::abs(ndc.z()) > 1.0f) continue;
+
+                    data.covariance(i, c);
+                    Eigen::Matrix3f cov3d;
+                    cov3d << c[0], c[1], c[2],
+                             c[1], c[3], c[4],
+                             c[2], c[4], c[5];
+                    cov3d *= modifier2;
+                    const Eigen::Vector3f cov2d = computeCov2D(view.head<3>(), focal, tanxy, cov3d, viewmat);
+
+                    const float det = cov2d.x() * cov2d.z() - cov2d.y() * cov2d.y();
+                    if (!(det > 0.0f)) continue;
+
+                    // the shader's conic (z, -y, x) / det, for offsets in image pixels with y down
+                    s.conic = Eigen::Vector3f(cov2d.z() / (to_image.x() * to_image.x()),
+                                              cov2d.y() / (to_image.x() * to_image.y()),
+                                              cov2d.x() / (to_image.y() * to_image.y())) / det;
+                    s.center = Eigen::Vector2f((ndc.x() + 1.0f) * 0.5f * _width, (1.0f - ndc.y()) * 0.5f * _height);
+                    const Eigen::Vector2f half(3.0f * std::sqrt(cov2d.x()) * to_image.x(),
+                                               3.0f * std::sqrt(cov2d.z()) * to_image.y());
+
+                    // pixels whose centers fall inside the quad
+                    s.rect[0] = std::max(0, static_cast<int>(std::ceil(s.center.x() - half.x() - 0.5f)));
+                    s.rect[1] = std::max(0, static_cast<int>(std::ceil(s.center.y() - half.y() - 0.5f)));
+                    s.rect[2] = std::min(_width - 1, static_cast<int>(std::floor(s.center.x() + half.x() - 0.5f)));
+                    s.rect[3] = std::min(_height - 1, static_cast<int>(std::floor(s.center.y() + half.y() - 0.5f)));
+                    if (s.rect[0] > s.rect[2] || s.rect[1] > s.rect[3]) continue;
+
+                    data.shape(i, attr);
+                    s.opacity = attr[GaussianData::OPACITY];
+                    s.depth = -view.z();
+                    if (mode == RenderConfig::DEPTH) {
+                        const float depth = s.depth < 0.05f ? 1.0f : 1.0f / s.depth;
+                        s.color = Eigen::Vector3f::Constant(depth);
+                    } else {
+                        s.color = Eigen::Map<const Eigen::Vector3f>(&_rgb[3 * i]);
+                    }
+                    // an RGBA8 target clamps what the fragment shader writes
+                    if (mode != RenderConfig::GAUSS_BALL) s.color = s.color.cwiseMax(0.0f).cwiseMin(1.0f);
+
+                    s.tiles = (s.rect[2] / TILE - s.rect[0] / TILE + 1) * (s.rect[3] / TILE - s.rect[1] / TILE + 1);
+                }
+            });
+    }
+
+    // computeCov2D of draw_splat.vert with focal_x = focal_y = focal:
+    // xx, xy, yy in window pixels with y up
+    static Eigen::Vector3f computeCov2D(Eigen::Vector3f t, float focal, const Eigen::Vector2f& tanxy,
+                                        const Eigen::Matrix3f& cov3d, const Eigen::Matrix4f& viewmat) {
+        const float limx = 1.3f * tanxy.x();
+        const float limy = 1.3f * tanxy.y();
+        t.x() = std::min(limx, std::max(-limx, t.x() / t.z())) * t.z();
+        t.y() = std::min(limy, std::max(-limy, t.y() / t.z())) * t.z();
+
+        Eigen::Matrix<float, 2, 3> J;
+        J << focal / t.z(), 0.0f, -(focal * t.x()) / (t.z() * t.z()),
+             0.0f, focal / t.z(), -(focal * t.y()) / (t.z() * t.z());
+        const Eigen::Matrix<float, 2, 3> T = J * viewmat.topLeftCorner<3, 3>();
+        const Eigen::Matrix2f cov = T * cov3d * T.transpose();
+        return Eigen::Vector3f(cov(0, 0) + 0.3f, cov(0, 1), cov(1, 1) + 0.3f);
+    }
+
+    // One key per covered tile: tile index above the depth's bits, which
+    // order like the float for the positive depths that pass project().
+    void bin() {
+
+        const size_t N = _projected.size();
+        _offsets.resize(N + 1);
+        _offsets[0] = 0;
+        for (size_t i = 0; i < N; ++i) _offsets[i + 1] = _offsets[i] + _projected[i].tiles;
+
+        _keys.resize(_offsets[N]);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    const Projected& s = _projected[i];
+                    if (s.tiles == 0) continue;
+                    uint32_t depth;
+                    std::memcpy(&depth, &s.depth, sizeof(depth));
+                    size_t k = _offsets[i];
+                    for (int ty = s.rect[1] / TILE; ty <= s.rect[3] / TILE; ++ty) {
+                        for (int tx = s.rect[0] / TILE; tx <= s.rect[2] / TILE; ++tx) {
+                            const uint64_t tile = uint64_t(ty) * _tiles_x + tx;
+                            _keys[k++] = { tile << 32 | depth, static_cast<uint32_t>(i) };
+                        }
+                    }
+                }
+            });
+        tbb::parallel_sort(_keys.begin(), _keys.end());
+
+        // [begin, end) of each tile's run of keys
+        const size_t tiles = size_t(_tiles_x) * _tiles_y;
+        _ranges.assign(tiles, { 0, 0 });
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _keys.size(), GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t k = r.begin(); k < r.end(); ++k) {
+                    const size_t tile = _keys[k].first >> 32;
+                    if (k == 0 || (_keys[k - 1].first >> 32) != tile) _ranges[tile].first = k;
+                    if (k + 1 == _keys.size() || (_keys[k + 1].first >> 32) != tile) _ranges[tile].second = k + 1;
+                }
+            });
+    }
+
+    void composite(int tile, bool gauss_ball, const Eigen::Vector3f& background, float* rgba) const {
+
+        const int x0 = (tile % _tiles_x) * TILE;
+        const int y0 = (tile / _tiles_x) * TILE;
+
+        // transmittance and color per pixel, row by row
+        alignas(64) float T[TILE * TILE];
+        alignas(64) float C[3 * TILE * TILE];
+        std::fill_n(T, TILE * TILE, 1.0f);
+        std::fill_n(C, 3 * TILE * TILE, 0.0f);
+        blendTile(_projected.data(), _keys.data() + _ranges[tile].first, _ranges[tile].second - _ranges[tile].first,
+                  x0, y0, gauss_ball, T, C);
+
+        for (int y = 0; y < TILE && y0 + y < _height; ++y) {
+            for (int x = 0; x < TILE && x0 + x < _width; ++x) {
+                float* pixel = rgba + 4 * (size_t(y0 + y) * _width + x0 + x);
+                const int p = y * TILE + x;
+                for (int c = 0; c < 3; ++c) pixel[c] = C[c * TILE * TILE + p] + T[p] * background[c];
+                pixel[3] = 1.0f - T[p];
+            }
+        }
+    }
+
+    // Front-to-back blending of a tile's sorted splats into T and C. Every
+    // splat is evaluated on all TILE pixels of each row it covers, in plain
+    // loops the compiler vectorizes: what the fragment shader discards, and
+    // pixels already opaque, just get a weight of 0. GCC keeps the weight
+    // loop's float selects as branches unless it has mask registers, so that
+    // loop is vectorized in the AVX-512 clone and the blend loops in all.
+    LITEVIZ_SIMD_CLONES
+    static void blendTile(const Projected* projected, const Key* keys, size_t count, int x0, int y0, bool gauss_ball,
+                          float* __restrict T, float* __restrict C) {
+
+        for (size_t k = 0; k < count; ++k) {
+            const Projected& s = projected[keys[k].second];
+            const float a = s.conic.x(), b = s.conic.y(), c = s.conic.z();
+            const float cx = s.center.x() - x0 - 0.5f;
+            alignas(64) float inside[TILE];
+            for (int x = 0; x < TILE; ++x) inside[x] = x0 + x >= s.rect[0] && x0 + x <= s.rect[2] ? 1.0f : 0.0f;
+            const int row_begin = std::max(s.rect[1], y0) - y0;
+            const int row_end = std::min(s.rect[3], y0 + TILE - 1) - y0;
+
+            for (int y = row_begin; y <= row_end; ++y) {
+                const float dy = y0 + y + 0.5f - s.center.y();
+                float* __restrict t = T + y * TILE;
+                float* __restrict r = C + y * TILE;
+                float* __restrict g = r + TILE * TILE;
+                float* __restrict bl = g + TILE * TILE;
+
+                alignas(64) float weight[TILE], falloff[TILE];
+                for (int x = 0; x < TILE; ++x) {
+                    const float dx = x - cx;
+                    const float power = -0.5f * (a * dx * dx + c * dy * dy) - b * dx * dy;
+                    falloff[x] = expNegative(power);
+                    float alpha = s.opacity * falloff[x];
+                    alpha = alpha > 0.99f ? 0.99f : alpha;
+                    // the fragment shader's discards, and pixels already opaque
+                    alpha = power > 0.0f || alpha < 1.0f / 255.0f ? 0.0f : alpha;
+                    weight[x] = t[x] < T_MIN ? 0.0f : alpha * inside[x];
+                }
+                if (gauss_ball) {
+                    for (int x = 0; x < TILE; ++x) {
+                        const float w = weight[x] > 0.22f ? t[x] : 0.0f;
+                        r[x] += w * clamp01(s.color.x() * falloff[x]);
+                        g[x] += w * clamp01(s.color.y() * falloff[x]);
+                        bl[x] += w * clamp01(s.color.z() * falloff[x]);
+                        t[x] -= w;
+                    }
+                } else {
+                    for (int x = 0; x < TILE; ++x) {
+                        const float w = t[x] * weight[x];
+                        r[x] += w * s.color.x();
+                        g[x] += w * s.color.y();
+                        bl[x] += w * s.color.z();
+                        t[x] -= w;
+                    }
+                }
+            }
+
+            // stopping early only pays once the whole tile is opaque
+            if (k % 32 == 31) {
+                bool opaque = true;
+                for (int p = 0; p < TILE * TILE; ++p) opaque &= T[p] < T_MIN;
+                if (opaque) break;
+            }
+        }
+    }
+
+    static float clamp01(float x) {
+        return x < 0.0f ? 0.0f : x > 1.0f ? 1.0f : x;
+    }
+
+    // exp(x) for x <= 0, as in Cephes (and Eigen's packet exp): 2^n by the
+    // exponent bits times a polynomial on the remainder. No libm call,
+    // unlike std::exp, so loops over it can vectorize. x is clamped to
+    // -20, far below the 1/255 cutoff: most lanes of a row lie well outside
+    // a small splat, and denormal results there cost microcode assists.
+    static float expNegative(float x) {
+        x = x < -20.0f ? -20.0f : x > 0.0f ? 0.0f : x;
+        // round to nearest by the float mantissa, without a call to rintf
+        const float n = (x * 1.44269504088896341f + 12582912.0f) - 12582912.0f;
+        x = x - n * 0.693359375f + n * 2.12194440e-4f;
+        const float z = x * x;
+        const float p = (((((1.9875691500e-4f * x + 1.3981999507e-3f) * x + 8.3334519073e-3f) * x +
+                           4.1665795894e-2f) * x + 1.6666665459e-1f) * x + 5.0000001201e-1f) * z + x + 1.0f;
+        const int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+
+    int                                         _width = 0;
+    int                                         _height = 0;
+    int                                         _tiles_x = 0;
+    int                                         _tiles_y = 0;
+    std::vector<float>                          _rgb;           // SH colors of every splat
+    std::vector<Projected>                      _projected;
+    std::vector<size_t>                         _offsets;       // of each splat's first key
+    std::vector<Key>                            _keys;
+    std::vector<std::pair<size_t, size_t>>      _ranges;        // per tile, of _keys
+};
+
+#endif // __RASTERIZER_H__
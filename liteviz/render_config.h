@@ -0,0 +1,52 @@
+#ifndef __RENDER_CONFIG_H__
+#define __RENDER_CONFIG_H__
+
+#include <cstddef>
+
+struct RenderConfig{
+    
+    enum RenderMode {
+        COLOR_SH_0,
+        COLOR_SH_1,
+        COLOR_SH_2,
+        COLOR_SH_3,
+        DEPTH,
+        GAUSS_BALL,
+        SURFEL,
+    };
+    
+    // system setting
+    RenderMode  render_mode     = COLOR_SH_3;
+    bool        vsync           = true;
+    bool        depth_sort      = true;
+    int         sort_key_bits   = 32;
+    bool        coherent_sort   = true;
+    bool        async_sort      = false;
+    bool        gpu_sort        = false;    // depth-sort in compute shaders (GpuSorter), nothing uploaded per frame
+    bool        frustum_culling = true;
+    bool        level_of_detail = true;     // draw a cut of the SplatLOD, when there is one
+    size_t      splat_budget    = 4000000;  // most splats a cut may hold, 0 for no limit
+    float       lod_threshold   = 2.0f;     // pixels; smaller nodes are drawn merged
+    bool        color_cache     = true;     // draw SH colors baked by bake_color.comp
+    bool        precomputed_cov3d = true;   // fp32 splats: upload R S^2 R^T in place of rotation and scale
+    float       cache_angle     = 0.5f;     // degrees a view direction may turn before its color is re-baked
+    bool        tile_render     = false;    // blend 16x16 tiles in compute shaders (TileRenderer) instead of a quad per splat
+    bool        dynamic_resolution = false; // draw moving frames at a scale that fits frame_budget (DynamicResolution)
+    float       frame_budget    = 16.0f;    // GPU milliseconds for the splat pass while the camera moves
+    float       min_render_scale = 0.25f;
+
+    // camera setting
+    float       scale_modifier  = 1.0f;
+    float       fov             = 60.0f;
+
+    // data info
+    size_t      num_primitives  = 0;
+    size_t      max_sh_dim      = 4 * 4 * 3;
+    size_t      bytes_per_splat = 0;    // GPU storage, position included
+    size_t      num_culled      = 0;    // outside the frustum in the last frame
+    size_t      num_baked       = 0;    // colors re-baked in the last frame
+    size_t      sh_bytes_saved  = 0;    // SH reads the color cache spared the last frame
+    float       render_scale    = 1.0f; // of the framebuffer the last frame's scene was drawn at
+};
+
+#endif // __RENDER_CONFIG_H__
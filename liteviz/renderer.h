@@ -5,45 +5,37 @@
 #include <liteviz/viewport.h>
 #include <liteviz/utils.h>
 #include <liteviz/shader.h>
+#include <liteviz/sort_worker.h>
+#include <liteviz/culling.h>
+#include <liteviz/lod.h>
+#include <liteviz/pager.h>
+#include <liteviz/color_cache.h>
+#include <liteviz/buffer.h>
+#include <liteviz/render_config.h>
+#include <liteviz/profiler.h>
+#include <liteviz/tile_renderer.h>
+#include <liteviz/gpu_sorter.h>
+#include <liteviz/resolution.h>
 
 
-struct RenderConfig{
-    
-    enum RenderMode {
-        COLOR_SH_0,
-        COLOR_SH_1,
-        COLOR_SH_2,
-        COLOR_SH_3,
-        DEPTH,
-        GAUSS_BALL,
-        SURFEL,
-    };
-    
-    // system setting
-    RenderMode  render_mode     = COLOR_SH_3;
-    bool        vsync           = true;
-    bool        depth_sort      = true;
-
-    // camera setting
-    float       scale_modifier  = 1.0f;
-    float       fov             = 60.0f;
-
-    // data info
-    size_t      num_primitives  = 0;
-    size_t      max_sh_dim      = 4 * 4 * 3;
-};
-
 class Renderer {
 
 public:
 
-    Renderer(const GaussianData& data, Shader* shader): _data(data) , _shader(shader){
+    // available: how many leading splats of data hold data yet, the rest arrive
+    // through append() while a progressive load is running
+    // lod: levels of detail built over data, its parents are stored after the
+    // scene; not for progressive loads
+    Renderer(const GaussianData& data, Shader* shader, size_t available = SIZE_MAX, const SplatLOD* lod = nullptr):
+        _data(data) , _shader(shader), _caller_shader(shader), _lod(lod){
         
         std::vector<float> _vertices = {-1.0f,  1.0f, 1.0f,  1.0f, 1.0f, -1.0f, -1.0f, -1.0f};
 
         _config = RenderConfig();
-        _config.num_primitives = _data.size();
         _config.max_sh_dim = _data.sh_dim();
+        _cov3d = _config.precomputed_cov3d && !_data.isCompact();
+        _config.bytes_per_splat = _data.isCompact() ? _data.packed.bytesPerSplat()
+                                                    : (3 + _data.attributes.cols()) * sizeof(float);
 
         glGenVertexArrays(1, &_vao);
         glGenBuffers(1, &_vbo);
@@ -53,28 +45,82 @@ public:
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
         glEnableVertexAttribArray(0);
 
-        std::vector<float> flatData = _data.flat();
+        // storage for the whole scene up front, so growing never reallocates
+        const size_t parents = _lod ? _lod->parents().size() : 0;
+        _radius.resize(_data.size());
+        glGenBuffers(1, &_ssbo_xyz);
+        allocate(_ssbo_xyz, (_data.size() + parents) * xyzBytes());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _ssbo_xyz);
+
         glGenBuffers(1, &_ssbo_splat);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _ssbo_splat);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, flatData.size() * sizeof(float), flatData.data(), GL_STATIC_DRAW);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _ssbo_splat);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        allocate(_ssbo_splat, (_data.size() + parents) * splatBytes());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _ssbo_splat);
+
+        // sized when the cache is first baked, see bakeColors()
+        glGenBuffers(1, &_ssbo_colors);
+        allocate(_ssbo_colors, sizeof(uint32_t));
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _ssbo_colors);
 
-        _index = sort(_data, Eigen::Matrix4f::Identity());
+        if (parents > 0) {
+            const GaussianData& merged = _lod->parents();
+            upload(_ssbo_xyz, merged.xyz.data(), _data.size() * xyzBytes(), parents * xyzBytes());
+            uploadSplats(merged, 0, parents, _data.size());
+        }
+
+        if (_data.isCompact() && _data.packed.sh_format == CompactSplats::SH_UINT8) {
+            const std::vector<float>& sh_range = _data.packed.sh_range;
+            glGenBuffers(1, &_ssbo_sh_range);
+            allocate(_ssbo_sh_range, sh_range.size() * sizeof(float));
+            upload(_ssbo_sh_range, sh_range.data(), 0, sh_range.size() * sizeof(float));
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _ssbo_sh_range);
+        }
+
+        append(std::min(available, _data.size()), SIZE_MAX);
+        _sorter.sort(_data.xyz.topRows(_available), Eigen::Matrix4f::Identity(), _index);
 
         glDisable(GL_CULL_FACE);
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
 
+    // Out-of-core: the buffers mirror the pager's pool and chunks are
+    // uploaded as the pager installs them.
+    Renderer(ChunkPager& pager, Shader* shader): Renderer(pager.pool(), shader, 0) {
+        _pager = &pager;
+        _config.num_primitives = pager.sceneSize();
+    }
+
     void render(const Viewport viewport){
 
+        Timer stage;
+        // fp32 rows change layout with the switch, see uploadSplats()
+        const bool cov3d = _config.precomputed_cov3d && !_data.isCompact();
+        if (cov3d != _cov3d) {
+            switchCov3D(cov3d);
+        }
         Eigen::Matrix4f projmat = viewport.getProjectionMatrix();
         Eigen::Matrix4f viewmat = viewport.getViewMatrix();
         Eigen::Vector3f cam_pos = viewport.camera.getPosition();
         Eigen::Vector2f tanxy = viewport.getTanXY();
         float focal = viewport.getFocal();
 
+        // the tile renderer blends in order of its own keys, and evaluates each color once anyway
+        const bool tiles = _config.tile_render;
+        const bool depth_sort = _config.depth_sort && !tiles;
+        // needs the whole scene in place, the pager moves chunks between slots; the baked
+        // colors are clamped to 8 bits, which would darken GAUSS_BALL's unclamped shading
+        const bool color_cache = _config.color_cache && !_pager && _available == _data.size() &&
+                                 _config.render_mode != RenderConfig::DEPTH &&
+                                 _config.render_mode != RenderConfig::GAUSS_BALL && !tiles;
+        if (color_cache) {
+            Profiler::Zone zone(_profiler, "bake");
+            Profiler::GpuZone gpu_zone(_profiler, "bake");
+            bakeColors(cam_pos);
+        } else {
+            _config.num_baked = 0;
+        }
+
+        _shader->bind(false);
         _shader->set_uniform("projmat", projmat);
         _shader->set_uniform("viewmat", viewmat);
         _shader->set_uniform("cam_pos", cam_pos);
@@ -83,35 +129,481 @@ public:
         _shader->set_uniform("max_sh_dim", _config.max_sh_dim);
         _shader->set_uniform("render_mod", _config.render_mode);
         _shader->set_uniform("scale_modifier", _config.scale_modifier);
+        _shader->set_uniform("color_cache", static_cast<int>(color_cache));
+        if (_data.isCompact()) {
+            _shader->set_uniform("splat_words", _data.packed.stride);
+        }
+        _timings.draw = stage.elapsed();
+        stage.reset();
+        Profiler::Zone sort_zone(_profiler, "sort");
 
-        if (_config.depth_sort) {
-            _index = sort(_data, viewmat);
+        const auto xyz = _data.xyz.topRows(_available);
+        const bool culling = _config.frustum_culling;
+        const float radius_scale = 3.0f * _config.scale_modifier;
+        FrustumCuller::Planes planes;
+        if (culling || _pager) {
+            // guard band for the shader's 0.3 px^2 low-pass, 3 sigma of it is under 2 px
+            const Eigen::Vector2f widen = 2.0f * GUARD_PIXELS / (2.0f * focal * tanxy.array());
+            planes = FrustumCuller::planes(projmat, viewmat, widen);
         }
 
-        glGenBuffers(1, &_ssbo_index);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _ssbo_index);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, _index.size() * sizeof(int), _index.data(), GL_STATIC_DRAW);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _ssbo_index);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-        
-        _shader->bind(false);
-        glBindVertexArray(_vao);
-        glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, static_cast<int>(_data.size()));
+        // a subset of the splats picked per frame: a LOD cut or the resident chunks
+        const bool lod = !_pager && _lod && _config.level_of_detail && _available == _data.size();
+        const bool selection = lod || _pager;
+        const bool gpu = !selection && depth_sort && _config.gpu_sort;
+        const bool async = !selection && !gpu && depth_sort && _config.async_sort;
+        const bool direct = !selection && !gpu && depth_sort && !_config.async_sort && !_config.coherent_sort;
+
+        if (gpu) {
+            if (_worker.running()) {
+                _worker.stop();
+            }
+            if (!_gpu_sorter) {
+                _gpu_sorter = std::make_unique<GpuSorter>(_data.size());
+                _gpu_sorter->uploadRadii(_radius.data(), 0, _available);
+            }
+            Profiler::GpuZone gpu_zone(_profiler, "sort");
+            _gpu_sorter->sort(_available, viewmat, culling ? &planes : nullptr, radius_scale, 1);
+            _index_count = _gpu_sorter->visible();
+            _config.num_culled = _available - _index_count;
+            _sorter.reset();
+            _index_dirty = true;    // the CPU's order is not on the GPU
+        } else if (selection) {
+            if (_worker.running()) {
+                _worker.stop();
+                _sorter.reset();
+            }
+            size_t count;
+            if (_pager) {
+                _pager->update(cam_pos, planes, radius_scale);
+                for (const std::pair<size_t, size_t>& rows : _pager->takeInstalled()) {
+                    uploadRows(rows.first, rows.second);
+                }
+                count = _pager->select(culling ? &planes : nullptr, radius_scale, _cut);
+                uploadSelection(_data.xyz, viewmat, count, depth_sort);
+            } else {
+                count = _lod->select(cam_pos, focal, _config.lod_threshold, _config.splat_budget,
+                                     culling ? &planes : nullptr, radius_scale, _cut);
+                uploadSelection(_lod->positions(), viewmat, count, depth_sort);
+            }
+            _index_count = count;
+            _config.num_culled = 0;
+            _index_dirty = true;    // the kept order is not on the GPU
+        } else if (async) {
+            _worker.start(_data.xyz, _radius.data());
+            SortWorker::Request request;
+            request.viewmat = viewmat;
+            request.frame = _frame;
+            request.key_bits = _config.sort_key_bits;
+            request.coherent = _config.coherent_sort;
+            request.count = _available;
+            request.cull = culling;
+            request.radius_scale = radius_scale;
+            request.planes = planes;
+            _worker.submit(request);
+            if (_worker.acquire(_frame)) {
+                const SortWorker::Result& result = _worker.latest();
+                _index_stream.upload(result.index.data(), result.index.size(), 1);
+                _index_count = result.index.size();
+                _config.num_culled = result.culled;
+                _index_dirty = false;
+            }
+        } else {
+            if (_worker.running()) {
+                _worker.stop();
+                _sorter.reset();
+            }
+            if (direct) {
+                // no previous order to keep; the sort reads back what it writes, so it runs
+                // in host memory and the write-only mapped section is filled in one copy
+                _direct_sorter.setKeyBits(static_cast<DepthSorter::KeyBits>(_config.sort_key_bits));
+                if (culling) {
+                    const size_t visible = _culler.cull(_data.xyz.data(), _radius.data(), _available, radius_scale, planes);
+                    _sorted.resize(visible);
+                    _direct_sorter.sortSubset(xyz, viewmat, _culler.visible().data(), visible, _sorted.data());
+                    _index_count = visible;
+                } else {
+                    _direct_sorter.sort(xyz, viewmat, _sorted);
+                    _index_count = _available;
+                }
+                _index_stream.upload(_sorted.data(), _index_count, 1);
+                _config.num_culled = _available - _index_count;
+                _sorter.reset();
+                _index_dirty = false;
+            } else if (depth_sort) {
+                _sorter.setKeyBits(static_cast<DepthSorter::KeyBits>(_config.sort_key_bits));
+                _index_dirty |= _sorter.sort(xyz, viewmat, _index);
+            } else if (_index.size() != _available) {
+                // not sorting, but splats arrived that the kept order lacks
+                _index_dirty |= _sorter.sort(xyz, viewmat, _index);
+            }
+        }
+        ++_frame;
+        _timings.sort = stage.elapsed();
+        stage.reset();
+        sort_zone.end();
+        Profiler::Zone upload_zone(_profiler, "upload");
+
+        if (selection || gpu) {
+            // drawn as mapped or sorted above
+        } else if (culling && !async && !direct) {
+            // draw the kept order without the splats outside the frustum
+            _culler.cull(_data.xyz.data(), _radius.data(), _available, radius_scale, planes);
+            _index_count = _culler.compact(_index.data(), _index.size(), _index_stream.map(_index.size()));
+            _index_stream.commit(1);
+            _config.num_culled = _index.size() - _index_count;
+            _index_dirty = true;    // the full order is not on the GPU
+        } else if (_index_dirty) {
+            _index_stream.upload(_index.data(), _index.size(), 1);
+            _index_count = _index.size();
+            _index_dirty = false;
+            _config.num_culled = 0;
+        } else {
+            _index_stream.bind(1);
+        }
+
+        _timings.upload = stage.elapsed();
+        stage.reset();
+        upload_zone.end();
+
+        // the bound ordering may cover fewer splats than have arrived (async sort)
+        if (tiles) {
+            Profiler::Zone zone(_profiler, "draw");
+            Profiler::GpuZone gpu_zone(_profiler, "tiles");
+            if (!_tile_renderer) {
+                _tile_renderer = std::make_unique<TileRenderer>(shaderDefines(_data, _cov3d));
+            }
+            if (_resolution) _resolution->passBegin();
+            _tile_renderer->render(_index_count, projmat, viewmat, cam_pos, tanxy, focal, viewport.getFrameBufferSize(),
+                                   _config, _data.isCompact() ? _data.packed.stride : 0);
+            if (_resolution) _resolution->passEnd();
+        } else {
+            Profiler::Zone zone(_profiler, "draw");
+            Profiler::GpuZone gpu_zone(_profiler, "splats");
+            glBindVertexArray(_vao);
+            if (_resolution) _resolution->passBegin();
+            if (gpu) {
+                // the sort's compute programs replaced the splat shader; as many
+                // instances as the GPU counted, the CPU's count is a frame late
+                _shader->bind(false);
+                _gpu_sorter->draw();
+            } else {
+                glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, static_cast<int>(_index_count));
+            }
+            if (_resolution) _resolution->passEnd();
+        }
+        _index_stream.fence();
+        _timings.draw += stage.elapsed();
+
+        // every vertex of a quad evaluates the SH unless the cache is on
+        if (color_cache) {
+            const size_t uncached = 4 * _index_count * shBytes();
+            const size_t cached = 4 * _index_count * sizeof(uint32_t) + _config.num_baked * shBytes();
+            _config.sh_bytes_saved = uncached > cached ? uncached - cached : 0;
+        } else {
+            _config.sh_bytes_saved = 0;
+        }
+    }
+
+    // Uploads splats [available(), count) that a progressive load has finished,
+    // at most max_bytes per call so a large batch does not stall one frame.
+    void append(size_t count, size_t max_bytes = MAX_APPEND_BYTES) {
+        count = std::min(count, _data.size());
+        if (count <= _available) return;
+
+        const size_t row_bytes = xyzBytes() + splatBytes();
+        count = std::min(count, _available + std::max<size_t>(1, max_bytes / row_bytes));
+
+        uploadRows(_available, count);
+        _available = count;
+        _config.num_primitives = _available;
+    }
+
+    // The 8-bit SH range of the data changed and its rows were packed again
+    // (ProgressiveLoader): uploads the range and the splats uploaded so far anew.
+    void requantize() {
+        if (!_ssbo_sh_range) return;
+        const std::vector<float>& sh_range = _data.packed.sh_range;
+        upload(_ssbo_sh_range, sh_range.data(), 0, sh_range.size() * sizeof(float));
+        uploadSplats(_data, 0, _available, 0);
+        _baked_mode = -1;
+    }
+
+    // splats uploaded so far, and how many the last frame drew
+    size_t available() const { return _available; }
+
+    size_t drawn() const { return _index_count; }
+
+    // (tile, splat) pairs the tile renderer blended in the last frame
+    size_t tileEntries() const { return _tile_renderer ? _tile_renderer->entries() : 0; }
+
+    bool hasLOD() const { return _lod != nullptr; }
+
+    // fp32 data, whose covariance RenderConfig::precomputed_cov3d may precompute
+    bool hasCov3D() const { return !_data.isCompact(); }
+
+    const ChunkPager* pager() const { return _pager; }
+
+    ~Renderer() {
+        _worker.stop();
+        glDeleteBuffers(1, &_ssbo_xyz);
+        glDeleteBuffers(1, &_ssbo_splat);
+        glDeleteBuffers(1, &_ssbo_colors);
+        if (_ssbo_bake_order) {
+            glDeleteBuffers(1, &_ssbo_bake_order);
+            glDeleteBuffers(1, &_ssbo_regions);
+        }
+        if (_ssbo_sh_range) {
+            glDeleteBuffers(1, &_ssbo_sh_range);
+        }
+        glDeleteBuffers(1, &_vbo);
+        glDeleteVertexArrays(1, &_vao);
+    }
+
+    // preprocessor lines the splat shader needs for the data's storage format;
+    // precomputed_cov3d as RenderConfig::precomputed_cov3d, for fp32 data
+    static std::string shaderDefines(const GaussianData& data, bool precomputed_cov3d = true) {
+        if (!data.isCompact()) return precomputed_cov3d ? "#define PRECOMPUTED_COV3D\n" : "";
+        std::string defines = "#define COMPACT_STORAGE\n";
+        if (data.packed.sh_format == CompactSplats::SH_UINT8) {
+            defines += "#define SH_UINT8\n";
+        }
+        return defines;
     }
 
     RenderConfig& config() {
         return _config;
     }
 
+    // CPU time of the last render() by stage, in seconds
+    struct Timings {
+        double  sort    = 0.0;  // culling, LOD or pager selection and the depth sort, or its dispatch on the GPU
+        double  upload  = 0.0;  // index upload; a direct sort writes into the mapped buffer under sort
+        double  draw    = 0.0;  // color bake dispatch, uniforms and the draw call, not the GPU's work;
+                                // the tile renderer waits here for its key count
+    };
+
+    const Timings& timings() const {
+        return _timings;
+    }
+
+    // profiles the stages above, and the GPU time of the color bake, the GPU sort and the splats or tiles;
+    // nullptr for none
+    void setProfiler(Profiler* profiler) {
+        _profiler = profiler;
+    }
+
+    // times the splat draw or tile dispatch for the dynamic resolution controller; nullptr for none
+    void setResolution(DynamicResolution* resolution) {
+        _resolution = resolution;
+    }
+
+    const CoherentSorter::Stats& sortStats() const {
+        return (_config.async_sort && _worker.hasResult()) ? _worker.latest().stats : _sorter.stats();
+    }
+
+    const SortWorker::Staleness& sortStaleness() const {
+        return _worker.staleness();
+    }
+
 private:
+
+    static constexpr size_t MAX_APPEND_BYTES = 64 << 20;
+    static constexpr float  GUARD_PIXELS = 2.0f;
+
+    static void allocate(GLuint buffer, size_t bytes) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    // Copies host data into a static buffer in bounded chunks, so the driver
+    // never has to stage a second copy of the whole scene at once.
+    static void upload(GLuint buffer, const void* data, size_t offset, size_t bytes) {
+        constexpr size_t CHUNK = 64 << 20;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(data);
+        for (size_t done = 0; done < bytes; done += CHUNK) {
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset + done, std::min(CHUNK, bytes - done), src + done);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    // RenderConfig::precomputed_cov3d changed: uploads the fp32 splats so far
+    // and the LOD parents again in the new layout, and draws with a splat
+    // shader built for it, or the caller's again, which has the default.
+    void switchCov3D(bool cov3d) {
+        _cov3d = cov3d;
+        uploadSplats(_data, 0, _available, 0);
+        if (_lod && _lod->parents().size() > 0) {
+            uploadSplats(_lod->parents(), 0, _lod->parents().size(), _data.size());
+        }
+        _tile_renderer.reset();
+        if (cov3d == RenderConfig().precomputed_cov3d) {
+            _own_shader.reset();
+            _shader = _caller_shader;
+        } else {
+            const std::string shader_path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+            _own_shader = std::make_unique<Shader>((shader_path + "/draw_splat.vert").c_str(),
+                                                   (shader_path + "/draw_splat.frag").c_str(), false,
+                                                   shaderDefines(_data, cov3d));
+            _shader = _own_shader.get();
+        }
+    }
+
+    // copies rows [begin, end) of the data to the GPU
+    void uploadRows(size_t begin, size_t end) {
+        upload(_ssbo_xyz, _data.xyz.row(begin).data(), begin * xyzBytes(), (end - begin) * xyzBytes());
+        uploadSplats(_data, begin, end, begin);
+        FrustumCuller::boundingRadii(_data, begin, end, _radius.data());
+        if (_gpu_sorter) _gpu_sorter->uploadRadii(_radius.data(), begin, end);
+    }
+
+    // Streams the order of the count splats in _cut. The selection changes with
+    // the view, so it is sorted from scratch like a direct sort, in host memory
+    // since the sort reads its output back (see DepthSorter::sortDepths).
+    template <typename Derived>
+    void uploadSelection(const Eigen::MatrixBase<Derived>& positions, const Eigen::Matrix4f& viewmat, size_t count,
+                         bool depth_sort) {
+        if (!depth_sort) {
+            _index_stream.upload(_cut.data(), count, 1);
+            return;
+        }
+        _direct_sorter.setKeyBits(static_cast<DepthSorter::KeyBits>(_config.sort_key_bits));
+        _sorted.resize(count);
+        _direct_sorter.sortSubset(positions, viewmat, _cut.data(), count, _sorted.data());
+        _index_stream.upload(_sorted.data(), count, 1);
+    }
+
+    // Copies attribute rows [begin, end) of block to splat row dst onwards.
+    // With _cov3d, fp32 rows go through a bounded staging copy that replaces
+    // quaternion and scale with the precomputed covariance
+    // (PRECOMPUTED_COV3D), so the shader skips computeCov3D at the same row
+    // size; otherwise, and for compact rows, they are uploaded as they are.
+    void uploadSplats(const GaussianData& block, size_t begin, size_t end, size_t dst) {
+        if (block.isCompact()) {
+            upload(_ssbo_splat, &block.packed.words[begin * block.packed.stride], dst * splatBytes(),
+                   (end - begin) * splatBytes());
+            return;
+        }
+        if (!_cov3d) {
+            upload(_ssbo_splat, &block.attributes(begin, 0), dst * splatBytes(), (end - begin) * splatBytes());
+            return;
+        }
+
+        const size_t cols = block.attributes.cols();
+        const size_t batch = std::max<size_t>(1, MAX_APPEND_BYTES / splatBytes());
+        for (size_t first = begin; first < end; first += batch) {
+            const size_t count = std::min(batch, end - first);
+            _staging.resize(count * cols);
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, count, 1 << 12),
+                [&](const tbb::blocked_range<size_t>& r) {
+                    for (size_t k = r.begin(); k < r.end(); ++k) {
+                        float* row = &_staging[k * cols];
+                        std::copy_n(&block.attributes(first + k, 0), cols, row);
+                        block.covariance(first + k, row + GaussianData::ROT);
+                        row[GaussianData::ROT + GaussianData::COV_DIM] = 0.0f;
+                    }
+                });
+            upload(_ssbo_splat, _staging.data(), (dst + first - begin) * splatBytes(), count * splatBytes());
+        }
+    }
+
+    // Re-evaluates the SH colors of the cache regions the camera has moved
+    // too far for, on the GPU; the first call sets up the cache over the
+    // scene and its LOD parents.
+    void bakeColors(const Eigen::Vector3f& cam_pos) {
+        if (!_bake_shader) {
+            const size_t rows = _data.size() + (_lod ? _lod->parents().size() : 0);
+            _color_cache.build(_lod ? _lod->positions() : _data.xyz, rows);
+
+            allocate(_ssbo_colors, rows * sizeof(uint32_t));
+            glGenBuffers(1, &_ssbo_bake_order);
+            allocate(_ssbo_bake_order, rows * sizeof(uint32_t));
+            upload(_ssbo_bake_order, _color_cache.order().data(), 0, rows * sizeof(uint32_t));
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, _ssbo_bake_order);
+            glGenBuffers(1, &_ssbo_regions);
+
+            const std::string shader_path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+            _bake_shader = std::make_unique<Shader>((shader_path + "/bake_color.comp").c_str(), shaderDefines(_data));
+        }
+
+        if (_baked_mode != _config.render_mode) {
+            _color_cache.invalidate();
+            _baked_mode = _config.render_mode;
+        }
+        const std::vector<ColorCache::Range>& stale = _color_cache.update(cam_pos, _config.cache_angle * float(M_PI) / 180.0f);
+        _config.num_baked = _color_cache.baked();
+        if (stale.empty()) return;
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _ssbo_regions);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, stale.size() * sizeof(ColorCache::Range), stale.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, _ssbo_regions);
+
+        _bake_shader->bind(false);
+        _bake_shader->set_uniform("cam_pos", cam_pos);
+        _bake_shader->set_uniform("render_mod", _config.render_mode);
+        _bake_shader->set_uniform("max_sh_dim", _config.max_sh_dim);
+        if (_data.isCompact()) {
+            _bake_shader->set_uniform("splat_words", _data.packed.stride);
+        }
+        glDispatchCompute(static_cast<GLuint>(stale.size()), 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // SH bytes a color evaluation reads at the current render mode
+    size_t shBytes() const {
+        const int degree = std::min<int>(_config.render_mode, 3);
+        const size_t coefficients = std::min<size_t>(_config.max_sh_dim, 3 * (degree + 1) * (degree + 1));
+        if (!_data.isCompact()) return coefficients * sizeof(float);
+        return _data.packed.sh_format == CompactSplats::SH_UINT8 ? coefficients : coefficients * 2;
+    }
+
+    static size_t xyzBytes() { return 3 * sizeof(float); }
+
+    size_t splatBytes() const {
+        return _data.isCompact() ? _data.packed.stride * sizeof(uint32_t) : _data.attributes.cols() * sizeof(float);
+    }
+
     GLuint              _vao;
     GLuint              _vbo;
+    GLuint              _ssbo_xyz;
     GLuint              _ssbo_splat;
-    GLuint              _ssbo_index;
-    Shader*             _shader;
+    GLuint              _ssbo_sh_range = 0;
+    GLuint              _ssbo_colors;
+    GLuint              _ssbo_bake_order = 0;
+    GLuint              _ssbo_regions = 0;
+    std::unique_ptr<Shader> _bake_shader;
+    std::unique_ptr<TileRenderer> _tile_renderer;   // made on the first tile_render frame
+    std::unique_ptr<GpuSorter> _gpu_sorter;         // made on the first gpu_sort frame
+    ColorCache          _color_cache;
+    int                 _baked_mode = -1;   // render mode the cached colors are for
+    Shader*             _shader;            // the splat shader drawn with
+    Shader*             _caller_shader;     // built by the caller with the default shaderDefines()
+    std::unique_ptr<Shader> _own_shader;    // for the other precomputed_cov3d
+    bool                _cov3d = false;     // fp32 rows on the GPU hold the covariance, see uploadSplats()
     RenderConfig        _config;
     const GaussianData& _data;
-    std::vector<int>    _index;
+    const SplatLOD*         _lod;
+    ChunkPager*             _pager = nullptr;
+    std::vector<uint32_t>   _cut;       // splats of the last LOD or out-of-core frame
+    CoherentSorter          _sorter;
+    DepthSorter             _direct_sorter;
+    SortWorker              _worker;
+    StreamBuffer            _index_stream;
+    std::vector<uint32_t>   _index;
+    std::vector<uint32_t>   _sorted;    // host scratch of the direct and selection sorts
+    FrustumCuller           _culler;
+    std::vector<float>      _radius;    // largest scale per splat, see FrustumCuller::boundingRadii
+    std::vector<float>      _staging;   // fp32 splat rows on their way to the GPU, see uploadSplats()
+    bool                    _index_dirty = true;
+    uint64_t                _frame = 0;
+    size_t                  _available = 0;
+    size_t                  _index_count = 0;   // splats in the bound ordering
+    Timings                 _timings;
+    Profiler*               _profiler = nullptr;
+    DynamicResolution*      _resolution = nullptr;
 
     Timer               _timer;
 };
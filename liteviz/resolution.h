@@ -0,0 +1,277 @@
+#ifndef __RESOLUTION_H__
+#define __RESOLUTION_H__
+
+#include <array>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <chrono>
+#include <Eigen/Dense>
+#include <glad/glad.h>
+#include <liteviz/shader.h>
+#include <liteviz/viewport.h>
+#include <liteviz/render_config.h>
+
+// Dynamic resolution for the viewer (RenderConfig::dynamic_resolution).
+// While the camera moves, the scene is drawn into the lower-left part of an
+// offscreen texture, at a scale of the framebuffer size, and upscale.frag
+// stretches it over the framebuffer with bilinear filtering. A controller
+// picks the scale that holds the GPU time of that pass to
+// RenderConfig::frame_budget:
+//  - the renderer brackets the splat draw or tile dispatch with
+//    passBegin() and passEnd() (Renderer::setResolution()), so CPU culling,
+//    sorting and uploads, which no scale makes faster, stay out of the time,
+//  - those write a pair of GL_TIMESTAMP queries, which unlike the
+//    profiler's GL_TIME_ELAPSED zones may enclose other queries; the
+//    results are read back a few frames later, without waiting,
+//  - taking the time as proportional to the pixels drawn, the time and the
+//    scale the pass ran at give the scale that would just fit the budget,
+//    and the scale moves GAIN of the way there, in whole steps of
+//    1/SCALE_STEPS so the target is not resized for every small change.
+// Once the view has stayed the same for SETTLE_FRAMES frames and SETTLE_MS
+// milliseconds, frames are drawn at full resolution straight to the
+// framebuffer, so the picture sharpens shortly after the camera stops; such
+// frames are not timed. A slow drag whose input misses a frame or two keeps
+// drawing at the controller's scale instead of popping to full resolution.
+class DynamicResolution {
+
+public:
+    static constexpr int        HISTORY     = 240;  // timed frames kept for the UI
+    static constexpr int        QUERY_RING  = 4;
+    static constexpr int        SCALE_STEPS = 32;
+    static constexpr float      GAIN        = 0.5f;
+    static constexpr uint64_t   MAX_GPU_NS  = 60000000000ull;  // longer passes are taken as bogus
+    static constexpr int        SETTLE_FRAMES = 4;      // unchanged frames before full resolution
+    static constexpr double     SETTLE_MS   = 100.0;    // and milliseconds
+
+    DynamicResolution() = default;
+
+    ~DynamicResolution() {
+        for (Query& query : _queries) {
+            if (query.ids[0]) glDeleteQueries(2, query.ids);
+        }
+        if (_fbo) glDeleteFramebuffers(1, &_fbo);
+        if (_texture) glDeleteTextures(1, &_texture);
+        if (_vao) glDeleteVertexArrays(1, &_vao);
+    }
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    // Returns the viewport to draw the scene with this frame, and sets
+    // config.render_scale. Below full resolution, the offscreen target is
+    // bound and cleared to clear_color; end() draws it over the framebuffer
+    // that was bound before.
+    Viewport begin(const Viewport& viewport, RenderConfig& config, const Eigen::Vector4f& clear_color) {
+
+        collect(config);
+
+        const Eigen::Matrix4f view = viewport.getViewMatrix();
+        const auto now = std::chrono::steady_clock::now();
+        if (view == _last_view && viewport.fov == _last_fov && viewport.frameBufferSize == _last_size) {
+            _unchanged = std::min(_unchanged + 1, SETTLE_FRAMES);
+        } else {
+            _unchanged = 0;
+            _changed_at = now;
+        }
+        const bool still = _unchanged >= SETTLE_FRAMES &&
+                           std::chrono::duration<double, std::milli>(now - _changed_at).count() >= SETTLE_MS;
+        _last_view = view;
+        _last_fov = viewport.fov;
+        _last_size = viewport.frameBufferSize;
+
+        _timed = config.dynamic_resolution && !still;
+        _scaled = _timed && _scale < 1.0f;
+        config.render_scale = _scaled ? _scale : 1.0f;
+        _full = viewport.frameBufferSize;
+        _size = _full;
+        if (!_timed) return viewport;
+
+        Query& query = _queries[_next];
+        if (query.pending) {
+            _timed = false;     // all queries in flight, this frame goes untimed
+        } else if (!query.ids[0]) {
+            glGenQueries(2, query.ids);
+        }
+        _stamps = 0;
+        if (!_scaled) return viewport;
+
+        Viewport scaled = viewport;
+        _size = (_full.cast<float>() * _scale).array().round().cast<int>().max(1);
+        scaled.frameBufferSize = _size;
+        scaled.windowSize = (viewport.windowSize.cast<float>() * _scale).array().round().cast<int>().max(1);
+
+        GLint bound = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &bound);
+        _framebuffer = static_cast<GLuint>(bound);
+        reserve(_full);
+        glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+        glViewport(0, 0, _size.x(), _size.y());
+        glClearBufferfv(GL_COLOR, 0, clear_color.data());
+        return scaled;
+    }
+
+    // Around the GPU work that scales with the pixels drawn, between begin()
+    // and end(); untimed frames ignore them.
+    void passBegin() {
+        if (!_timed || _stamps != 0) return;
+        glQueryCounter(_queries[_next].ids[0], GL_TIMESTAMP);
+        _stamps = 1;
+    }
+
+    void passEnd() {
+        if (_stamps != 1) return;
+        glQueryCounter(_queries[_next].ids[1], GL_TIMESTAMP);
+        _stamps = 2;
+    }
+
+    // After the scene is drawn: upscales it to the framebuffer if it was
+    // drawn offscreen, and closes the timing of the pass.
+    void end() {
+        if (_scaled) {
+            glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+            glViewport(0, 0, _full.x(), _full.y());
+            if (!_upscale) {
+                const std::string path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+                _upscale = std::make_unique<Shader>((path + "/tile_composite.vert").c_str(),
+                                                    (path + "/upscale.frag").c_str(), false);
+                glGenVertexArrays(1, &_vao);
+            }
+            _upscale->bind(false);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, _texture);
+            _upscale->set_uniform("image");
+            _upscale->set_uniform("region", Eigen::Vector2f(_size.cast<float>()));
+            _upscale->set_uniform("target", Eigen::Vector2f(_full.cast<float>()));
+            // the scene already holds the clear color, replace the framebuffer
+            glDisable(GL_BLEND);
+            glBindVertexArray(_vao);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glEnable(GL_BLEND);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        // a frame whose pass was not bracketed goes untimed
+        if (_timed && _stamps == 2) {
+            Query& query = _queries[_next];
+            query.pending = true;
+            query.scale = _scaled ? _scale : 1.0f;
+            _next = (_next + 1) % QUERY_RING;
+        }
+    }
+
+    // the controller's scale for moving frames
+    float scale() const { return _scale; }
+
+    // pixels the scene was drawn at in the last frame
+    const Eigen::Vector2i& size() const { return _size; }
+
+    // scale and GPU milliseconds of the timed frames, oldest first, for graphs
+    const std::vector<float>& scaleHistory() { return linearize(_scales, _scale_graph); }
+
+    const std::vector<float>& timeHistory() { return linearize(_times, _time_graph); }
+
+    // GPU milliseconds of the last timed frame
+    float lastTime() const { return _count ? _times[(_head + HISTORY - 1) % HISTORY] : 0.0f; }
+
+private:
+    struct Query {
+        GLuint  ids[2]  = { 0, 0 };     // timestamps before and after the pass
+        bool    pending = false;
+        float   scale   = 1.0f;         // the pass ran at
+    };
+
+    // the offscreen target, as large as the framebuffer
+    void reserve(const Eigen::Vector2i& size) {
+        if (_texture && _texture_size == size) return;
+        if (!_fbo) glGenFramebuffers(1, &_fbo);
+        if (_texture) glDeleteTextures(1, &_texture);
+        glGenTextures(1, &_texture);
+        glBindTexture(GL_TEXTURE_2D, _texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x(), size.y(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Dynamic resolution framebuffer is incomplete" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        _texture_size = size;
+    }
+
+    // reads back the finished queries, oldest first, and steps the controller on each
+    void collect(const RenderConfig& config) {
+        for (int k = 0; k < QUERY_RING; ++k) {
+            Query& query = _queries[(_next + k) % QUERY_RING];
+            if (!query.pending) continue;
+            GLint available = 0;
+            glGetQueryObjectiv(query.ids[1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break;
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(query.ids[0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(query.ids[1], GL_QUERY_RESULT, &end);
+            query.pending = false;
+            if (end <= begin || end - begin > MAX_GPU_NS) continue;
+            step(query.scale, (end - begin) * 1e-6f, config);
+        }
+    }
+
+    void step(float scale, float ms, const RenderConfig& config) {
+        _scales[_head] = scale;
+        _times[_head] = ms;
+        _head = (_head + 1) % HISTORY;
+        _count = std::min(_count + 1, HISTORY);
+
+        if (!config.dynamic_resolution) return;
+        const float min_scale = std::clamp(config.min_render_scale, 1.0f / SCALE_STEPS, 1.0f);
+        // milliseconds the whole framebuffer would take, by pixel count
+        const float full = std::max(ms / (scale * scale), 1e-3f);
+        const float fit = std::clamp(std::sqrt(config.frame_budget / full), min_scale, 1.0f);
+        // at least a step when a step or more off, none closer than that
+        const float error = (fit - _scale) * SCALE_STEPS;
+        if (std::abs(error) < 1.0f) return;
+        const float steps = std::copysign(std::max(1.0f, std::round(std::abs(GAIN * error))), error);
+        _scale = std::clamp(_scale + steps / SCALE_STEPS, min_scale, 1.0f);
+    }
+
+    const std::vector<float>& linearize(const std::array<float, HISTORY>& ring, std::vector<float>& graph) const {
+        graph.resize(_count);
+        for (int k = 0; k < _count; ++k) graph[k] = ring[(_head + HISTORY - _count + k) % HISTORY];
+        return graph;
+    }
+
+    float                               _scale          = 1.0f;
+    bool                                _timed          = false;
+    bool                                _scaled         = false;
+    int                                 _stamps         = 0;    // timestamps written this frame
+    Eigen::Vector2i                     _full           = Eigen::Vector2i::Zero();
+    Eigen::Vector2i                     _size           = Eigen::Vector2i::Zero();
+    Eigen::Matrix4f                     _last_view      = Eigen::Matrix4f::Zero();
+    float                               _last_fov       = 0.0f;
+    Eigen::Vector2i                     _last_size      = Eigen::Vector2i::Zero();
+    int                                 _unchanged      = 0;    // frames the view has stayed the same
+    std::chrono::steady_clock::time_point _changed_at;
+    std::array<Query, QUERY_RING>       _queries;
+    int                                 _next           = 0;
+    std::array<float, HISTORY>          _scales {};
+    std::array<float, HISTORY>          _times {};
+    int                                 _head           = 0;
+    int                                 _count          = 0;
+    std::vector<float>                  _scale_graph;
+    std::vector<float>                  _time_graph;
+    GLuint                              _framebuffer    = 0;    // to upscale into
+    GLuint                              _fbo            = 0;
+    GLuint                              _texture        = 0;
+    Eigen::Vector2i                     _texture_size   = Eigen::Vector2i::Zero();
+    GLuint                              _vao            = 0;
+    std::unique_ptr<Shader>             _upscale;
+};
+
+#endif // __RESOLUTION_H__
@@ -0,0 +1,241 @@
+#ifndef __SH_H__
+#define __SH_H__
+
+#include <cmath>
+#include <algorithm>
+#include <Eigen/Dense>
+#include <tbb/parallel_for.h>
+#include <liteviz/dataloader.h>
+
+// Real spherical harmonics constants, same as draw_splat.vert
+constexpr float SH_C0 = 0.28209479177387814f;
+constexpr float SH_C1 = 0.4886025119029199f;
+constexpr float SH_C2[5] = { 1.0925484305920792f, -1.0925484305920792f, 0.31539156525252005f,
+                             -1.0925484305920792f, 0.5462742152960396f };
+constexpr float SH_C3[7] = { -0.5900435899266435f, 2.890611442640554f, -0.4570457994644658f,
+                             0.3731763325901154f, -0.4570457994644658f, 1.445305721320277f,
+                             -0.5900435899266435f };
+
+// View-dependent color of one splat, the CPU reference of the vertex shader's
+// SH evaluation. sh holds sh_dim floats as rgb triples per coefficient, dir is
+// the normalized direction from the camera to the splat.
+inline Eigen::Vector3f eval_sh(const float* sh, int sh_dim, int degree, const Eigen::Vector3f& dir) {
+
+    auto c = [sh](int i) { return Eigen::Map<const Eigen::Vector3f>(sh + 3 * i); };
+
+    Eigen::Vector3f color = SH_C0 * c(0);
+
+    if (degree >= 1 && sh_dim >= 4) {
+        const float x = dir.x(), y = dir.y(), z = dir.z();
+        color = color - SH_C1 * y * c(1) + SH_C1 * z * c(2) - SH_C1 * x * c(3);
+
+        if (degree >= 2 && sh_dim >= 9) {
+            const float xx = x * x, yy = y * y, zz = z * z;
+            const float xy = x * y, yz = y * z, xz = x * z;
+            color = color +
+                SH_C2[0] * xy * c(4) +
+                SH_C2[1] * yz * c(5) +
+                SH_C2[2] * (2.0f * zz - xx - yy) * c(6) +
+                SH_C2[3] * xz * c(7) +
+                SH_C2[4] * (xx - yy) * c(8);
+
+            if (degree >= 3 && sh_dim >= 16) {
+                color = color +
+                    SH_C3[0] * y * (3.0f * xx - yy) * c(9) +
+                    SH_C3[1] * xy * z * c(10) +
+                    SH_C3[2] * y * (4.0f * zz - xx - yy) * c(11) +
+                    SH_C3[3] * z * (2.0f * zz - 3.0f * xx - 3.0f * yy) * c(12) +
+                    SH_C3[4] * x * (4.0f * zz - xx - yy) * c(13) +
+                    SH_C3[5] * z * (xx - yy) * c(14) +
+                    SH_C3[6] * x * (xx - 3.0f * yy) * c(15);
+            }
+        }
+    }
+    return color.array() + 0.5f;
+}
+
+// The batch kernels below are plain loops the compiler vectorizes. On x86
+// they are also compiled for AVX-512 and AVX2 and the best clone the CPU runs
+// is picked at load time, so the build does not need a -march of its own.
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__APPLE__) && (!defined(__clang__) || __clang_major__ >= 14)
+#define LITEVIZ_SIMD_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define LITEVIZ_SIMD_CLONES
+#endif
+
+constexpr size_t SH_RUN = 64;     // splats per SoA block
+
+// eval_sh() over a block of n <= SH_RUN splats in SoA layout: sh holds
+// 3 * (DEGREE + 1)^2 planes of SH_RUN floats (coefficient-major rgb, as in
+// the attribute rows), dir (normalized) and rgb three planes each.
+template <int DEGREE>
+LITEVIZ_SIMD_CLONES
+void eval_sh_run(const float* __restrict sh, const float* __restrict dir, size_t n, float* __restrict rgb) {
+
+    for (size_t i = 0; i < n; ++i) {
+        const float x = dir[i], y = dir[SH_RUN + i], z = dir[2 * SH_RUN + i];
+        const float xx = x * x, yy = y * y, zz = z * z;
+        const float xy = x * y, yz = y * z, xz = x * z;
+
+        for (int c = 0; c < 3; ++c) {
+            auto k = [&](int coeff) { return sh[(3 * coeff + c) * SH_RUN + i]; };
+            float v = SH_C0 * k(0);
+            if constexpr (DEGREE >= 1) {
+                v = v - SH_C1 * y * k(1) + SH_C1 * z * k(2) - SH_C1 * x * k(3);
+            }
+            if constexpr (DEGREE >= 2) {
+                v = v +
+                    SH_C2[0] * xy * k(4) +
+                    SH_C2[1] * yz * k(5) +
+                    SH_C2[2] * (2.0f * zz - xx - yy) * k(6) +
+                    SH_C2[3] * xz * k(7) +
+                    SH_C2[4] * (xx - yy) * k(8);
+            }
+            if constexpr (DEGREE >= 3) {
+                v = v +
+                    SH_C3[0] * y * (3.0f * xx - yy) * k(9) +
+                    SH_C3[1] * xy * z * k(10) +
+                    SH_C3[2] * y * (4.0f * zz - xx - yy) * k(11) +
+                    SH_C3[3] * z * (2.0f * zz - 3.0f * xx - 3.0f * yy) * k(12) +
+                    SH_C3[4] * x * (4.0f * zz - xx - yy) * k(13) +
+                    SH_C3[5] * z * (xx - yy) * k(14) +
+                    SH_C3[6] * x * (xx - 3.0f * yy) * k(15);
+            }
+            rgb[c * SH_RUN + i] = v + 0.5f;
+        }
+    }
+}
+
+// Positions and SH coefficients of splats [first, first + n) as SoA planes:
+// xyz gets 3 planes of SH_RUN floats, sh the first dim coefficients' planes.
+inline void sh_planes(const GaussianData& data, size_t first, size_t n, int dim, float* xyz, float* sh) {
+    if (data.isCompact()) {
+        std::vector<float> attr(GaussianData::SH + data.sh_dim());
+        for (size_t j = 0; j < n; ++j) {
+            data.packed.unpackRow(first + j, attr.data());
+            for (int k = 0; k < dim; ++k) sh[k * SH_RUN + j] = attr[GaussianData::SH + k];
+        }
+    } else {
+        const float* rows = &data.attributes(first, GaussianData::SH);
+        const size_t stride = data.attributes.cols();
+        for (int k = 0; k < dim; ++k) {
+            for (size_t j = 0; j < n; ++j) sh[k * SH_RUN + j] = rows[j * stride + k];
+        }
+    }
+    for (int a = 0; a < 3; ++a) {
+        for (size_t j = 0; j < n; ++j) xyz[a * SH_RUN + j] = data.xyz(first + j, a);
+    }
+}
+
+// Colors of one SoA block seen from eye, as n rgb triples into rgb.
+template <int DEGREE>
+void eval_sh_planes(const float* xyz, const float* sh, size_t n, const Eigen::Vector3f& eye, float* rgb) {
+    using Plane = Eigen::Array<float, SH_RUN, 1>;
+    alignas(64) float dir[3 * SH_RUN];
+    alignas(64) float out[3 * SH_RUN];
+
+    // through Eigen's packet rsqrt: std::sqrt's errno path keeps loops from vectorizing
+    const Plane x = Eigen::Map<const Plane>(xyz) - eye.x();
+    const Plane y = Eigen::Map<const Plane>(xyz + SH_RUN) - eye.y();
+    const Plane z = Eigen::Map<const Plane>(xyz + 2 * SH_RUN) - eye.z();
+    const Plane inv = (x.square() + y.square() + z.square()).rsqrt();
+    Eigen::Map<Plane> dx(dir), dy(dir + SH_RUN), dz(dir + 2 * SH_RUN);
+    dx = x * inv;
+    dy = y * inv;
+    dz = z * inv;
+
+    eval_sh_run<DEGREE>(sh, dir, n, out);
+
+    for (size_t j = 0; j < n; ++j) {
+        for (int c = 0; c < 3; ++c) rgb[3 * j + c] = out[c * SH_RUN + j];
+    }
+}
+
+inline int sh_degree(int sh_dim) {
+    return static_cast<int>(std::lround(std::sqrt(sh_dim / 3.0))) - 1;
+}
+
+// View-dependent colors of splats [begin, end) seen from eye, up to SH
+// degree (capped by the data's), into rgb as (end - begin) rgb triples.
+// Matches eval_sh() and draw_splat.vert up to float rounding. Each block is
+// transposed on the way; see SHPlanes to color one scene from many views.
+inline void eval_sh_colors(const GaussianData& data, size_t begin, size_t end, const Eigen::Vector3f& eye, int degree,
+                           float* rgb) {
+
+    degree = std::min(degree, sh_degree(data.sh_dim()));
+    const int dim = 3 * (degree + 1) * (degree + 1);
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(begin, end, SH_RUN),
+        [&](const tbb::blocked_range<size_t>& r) {
+            std::vector<float> xyz(3 * SH_RUN, 0.0f), sh(dim * SH_RUN, 0.0f);
+            for (size_t first = r.begin(); first < r.end(); first += SH_RUN) {
+                const size_t n = std::min(SH_RUN, r.end() - first);
+                sh_planes(data, first, n, dim, xyz.data(), sh.data());
+                float* dst = rgb + 3 * (first - begin);
+                switch (degree) {
+                    case 0:  eval_sh_planes<0>(xyz.data(), sh.data(), n, eye, dst); break;
+                    case 1:  eval_sh_planes<1>(xyz.data(), sh.data(), n, eye, dst); break;
+                    case 2:  eval_sh_planes<2>(xyz.data(), sh.data(), n, eye, dst); break;
+                    default: eval_sh_planes<3>(xyz.data(), sh.data(), n, eye, dst); break;
+                }
+            }
+        });
+}
+
+// A scene's positions and SH coefficients kept in SoA blocks of SH_RUN
+// splats. Building it is the transposing pass eval_sh_colors() makes on
+// every call; after that each eval() streams the planes straight through the
+// kernels, which pays off when one scene is colored from many views.
+class SHPlanes {
+
+public:
+    SHPlanes() = default;
+
+    explicit SHPlanes(const GaussianData& data, int max_degree = 3) {
+        build(data, max_degree);
+    }
+
+    void build(const GaussianData& data, int max_degree = 3) {
+        _size = data.size();
+        _degree = std::min(max_degree, sh_degree(data.sh_dim()));
+        _dim = 3 * (_degree + 1) * (_degree + 1);
+        const size_t blocks = (_size + SH_RUN - 1) / SH_RUN;
+        _planes.assign(blocks * blockFloats(), 0.0f);
+        tbb::parallel_for(size_t(0), blocks, [&](size_t b) {
+            float* block = &_planes[b * blockFloats()];
+            sh_planes(data, b * SH_RUN, std::min(SH_RUN, _size - b * SH_RUN), _dim, block, block + 3 * SH_RUN);
+        });
+    }
+
+    size_t size() const { return _size; }
+
+    int degree() const { return _degree; }
+
+    // as eval_sh_colors() over the whole scene, degree capped by degree()
+    void eval(const Eigen::Vector3f& eye, int degree, float* rgb) const {
+        degree = std::min(degree, _degree);
+        const size_t blocks = (_size + SH_RUN - 1) / SH_RUN;
+        tbb::parallel_for(size_t(0), blocks, [&](size_t b) {
+            const float* block = &_planes[b * blockFloats()];
+            const size_t n = std::min(SH_RUN, _size - b * SH_RUN);
+            float* dst = rgb + 3 * b * SH_RUN;
+            switch (degree) {
+                case 0:  eval_sh_planes<0>(block, block + 3 * SH_RUN, n, eye, dst); break;
+                case 1:  eval_sh_planes<1>(block, block + 3 * SH_RUN, n, eye, dst); break;
+                case 2:  eval_sh_planes<2>(block, block + 3 * SH_RUN, n, eye, dst); break;
+                default: eval_sh_planes<3>(block, block + 3 * SH_RUN, n, eye, dst); break;
+            }
+        });
+    }
+
+private:
+    // 3 position planes, then one plane per SH coefficient
+    size_t blockFloats() const { return (3 + _dim) * SH_RUN; }
+
+    std::vector<float>  _planes;
+    size_t              _size = 0;
+    int                 _degree = 0;
+    int                 _dim = 3;
+};
+
+#endif // __SH_H__
@@ -75,11 +75,12 @@ template <> inline GLenum get_type_enum<GLfloat>() {
 
 class Shader {
 public:
-    Shader(const char *vshader_path, const char *fshader_path, bool create_buffer = true) {
+    // defines: extra lines ("#define NAME ...") inserted after each #version line
+    Shader(const char *vshader_path, const char *fshader_path, bool create_buffer = true, const std::string &defines = "") {
         GLint status;
 
-        std::string vshader_source = readShaderSourceFromFile(vshader_path);
-        std::string fshader_source = readShaderSourceFromFile(fshader_path);
+        std::string vshader_source = insertDefines(readShaderSourceFromFile(vshader_path), defines);
+        std::string fshader_source = insertDefines(readShaderSourceFromFile(fshader_path), defines);
 
         constexpr GLsizei MAX_INFO_LOG_LENGTH = 2000;
         GLsizei info_log_length;
@@ -125,6 +126,34 @@ public:
 
     }
 
+    // Compute program from a single .comp file.
+    explicit Shader(const char *cshader_path, const std::string &defines = "") {
+        std::string cshader_source = insertDefines(readShaderSourceFromFile(cshader_path), defines);
+
+        cshader = glCreateShader(GL_COMPUTE_SHADER);
+        const char* cshader_code = cshader_source.c_str();
+        glShaderSource(cshader, 1, &cshader_code, nullptr);
+        glCompileShader(cshader);
+        GLint status;
+        GLchar info_log[2000];
+        glGetShaderiv(cshader, GL_COMPILE_STATUS, &status);
+        if (status != GL_TRUE) {
+            glGetShaderInfoLog(cshader, sizeof(info_log), nullptr, info_log);
+            std::cerr << "Shader compilation error:\n" << info_log << std::endl;
+            exit(1);
+        }
+
+        program = glCreateProgram();
+        glAttachShader(program, cshader);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status != GL_TRUE) {
+            glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+            std::cerr << "Shader link error:\n" << info_log << std::endl;
+            exit(1);
+        }
+    }
+
     ~Shader() {
         for (auto [attrib, buffer] : attribute_buffers) {
             glDeleteBuffers(1, &buffer);
@@ -134,11 +163,12 @@ public:
         if (index_buffer != 0)
             glDeleteBuffers(1, &index_buffer);
 
-        glDetachShader(program, fshader);
-        glDetachShader(program, vshader);
+        for (GLuint shader : { vshader, fshader, cshader }) {
+            if (shader == 0) continue;
+            glDetachShader(program, shader);
+            glDeleteShader(shader);
+        }
         glDeleteProgram(program);
-        glDeleteShader(fshader);
-        glDeleteShader(vshader);
     }
 
     void bind(bool use_buffer = true) {
@@ -234,17 +264,35 @@ public:
     }
 
 private:
+    // Reads a shader file with its #include "name" lines replaced by the
+    // named file from the same directory, so stages can share code.
     std::string readShaderSourceFromFile(const std::string& filePath) {
         std::ifstream file(filePath);
         if (!file.is_open()) {
             std::cerr << "Failed to open shader file: " << filePath << std::endl;
             exit(1);
         }
+        const std::string directory = filePath.substr(0, filePath.find_last_of('/') + 1);
         std::stringstream buffer;
-        buffer << file.rdbuf();
+        std::string line;
+        while (std::getline(file, line)) {
+            const size_t open = line.find('"');
+            if (line.rfind("#include", 0) == 0 && open != std::string::npos) {
+                buffer << readShaderSourceFromFile(directory + line.substr(open + 1, line.find('"', open + 1) - open - 1));
+            } else {
+                buffer << line << '\n';
+            }
+        }
         return buffer.str();
     }
 
+    static std::string insertDefines(const std::string& source, const std::string& defines) {
+        if (defines.empty()) return source;
+        size_t line_end = source.find('\n');
+        if (line_end == std::string::npos) return source + "\n" + defines;
+        return source.substr(0, line_end + 1) + defines + source.substr(line_end + 1);
+    }
+
     GLint uniform(const std::string &name) {
         if (uniforms.count(name) == 0) {
             GLint location = glGetUniformLocation(program, name.c_str());
@@ -270,8 +318,9 @@ private:
     }
 
     GLuint program;
-    GLuint vshader;
-    GLuint fshader;
+    GLuint vshader = 0;
+    GLuint fshader = 0;
+    GLuint cshader = 0;
     std::map<std::string, GLint> uniforms;
     std::map<std::string, GLint> attributes;
     std::map<GLint, GLuint> attribute_buffers;
@@ -0,0 +1,175 @@
+// Splat storage and color evaluation shared by draw_splat.vert,
+// bake_color.comp and tile_preprocess.comp, pulled in through Shader's
+// #include expansion.
+
+#define SH_C0 0.28209479177387814f
+#define SH_C1 0.4886025119029199f
+
+#define SH_C2_0 1.0925484305920792f
+#define SH_C2_1 -1.0925484305920792f
+#define SH_C2_2 0.31539156525252005f
+#define SH_C2_3 -1.0925484305920792f
+#define SH_C2_4 0.5462742152960396f
+
+#define SH_C3_0 -0.5900435899266435f
+#define SH_C3_1 2.890611442640554f
+#define SH_C3_2 -0.4570457994644658f
+#define SH_C3_3 0.3731763325901154f
+#define SH_C3_4 -0.4570457994644658f
+#define SH_C3_5 1.445305721320277f
+#define SH_C3_6 -0.5900435899266435f
+
+#define R_INDEX 0
+#define COV_INDEX 0	// PRECOMPUTED_COV3D: xx xy xz yy yz zz | unused, in place of rotation and scale
+#define S_INDEX 4
+#define O_INDEX 7
+#define C_INDEX 8
+
+layout (std430, binding=0) buffer _positions {
+	float xyz[];
+};
+#ifdef COMPACT_STORAGE
+// see CompactSplats in quantize.h
+layout (std430, binding=2) buffer _splats {
+	uint splat[];
+};
+#ifdef SH_UINT8
+layout (std430, binding=3) buffer _sh_range {
+	float sh_range[];	// min[max_sh_dim] | step[max_sh_dim]
+};
+#endif
+uniform int splat_words;
+#else
+layout (std430, binding=2) buffer _splats {
+	float splat[];
+};
+#endif
+
+uniform int max_sh_dim;
+
+vec3 get_position(int splat_idx)
+{
+	return vec3(xyz[3 * splat_idx], xyz[3 * splat_idx + 1], xyz[3 * splat_idx + 2]);
+}
+
+#ifdef COMPACT_STORAGE
+int get_start(int splat_idx)
+{
+	return splat_idx * splat_words;
+}
+vec4 get_rotation(int start)
+{
+	// smallest three: index of the dropped component, then 3 x 10 bits
+	uint w = splat[start];
+	int largest = int(w >> 30);
+	vec3 v = (vec3((uvec3(w) >> uvec3(20, 10, 0)) & 1023u) / 1023.0 * 2.0 - 1.0) * 0.70710678;
+	float l = sqrt(max(0.0, 1.0 - dot(v, v)));
+	vec4 q;
+	int j = 0;
+	for (int i = 0; i < 4; ++i) {
+		if (i == largest) {
+			q[i] = l;
+		} else {
+			q[i] = v[j++];
+		}
+	}
+	return q;
+}
+vec3 get_scale(int start)
+{
+	return vec3(unpackHalf2x16(splat[start + 1]), unpackHalf2x16(splat[start + 2]).x);
+}
+float get_opacity(int start)
+{
+	return unpackHalf2x16(splat[start + 2]).y;
+}
+float get_sh(int start, int k)
+{
+#ifdef SH_UINT8
+	uint q = (splat[start + 3 + k / 4] >> (8 * (k & 3))) & 255u;
+	return sh_range[k] + float(q) * sh_range[max_sh_dim + k];
+#else
+	vec2 h = unpackHalf2x16(splat[start + 3 + k / 2]);
+	return (k & 1) == 0 ? h.x : h.y;
+#endif
+}
+// rgb of the i-th SH coefficient
+vec3 get_color(int start, int i)
+{
+	return vec3(get_sh(start, 3 * i), get_sh(start, 3 * i + 1), get_sh(start, 3 * i + 2));
+}
+#else
+int get_start(int splat_idx)
+{
+	return splat_idx * (4 + 3 + 1 + max_sh_dim);
+}
+vec3 get_vec3(int offset)
+{
+	return vec3(splat[offset], splat[offset + 1], splat[offset + 2]);
+}
+vec4 get_vec4(int offset)
+{
+	return vec4(splat[offset], splat[offset + 1], splat[offset + 2], splat[offset + 3]);
+}
+vec4 get_rotation(int start)
+{
+	return get_vec4(start + R_INDEX);
+}
+mat3 get_cov3d(int start)
+{
+	vec3 a = get_vec3(start + COV_INDEX);		// xx xy xz
+	vec3 b = get_vec3(start + COV_INDEX + 3);	// yy yz zz
+	return mat3(a.x, a.y, a.z, a.y, b.x, b.y, a.z, b.y, b.z);
+}
+vec3 get_scale(int start)
+{
+	return get_vec3(start + S_INDEX);
+}
+float get_opacity(int start)
+{
+	return splat[start + O_INDEX];
+}
+// rgb of the i-th SH coefficient
+vec3 get_color(int start, int i)
+{
+	return get_vec3(start + C_INDEX + i * 3);
+}
+#endif
+
+// SH color seen along dir, up to SH degree render_mod
+vec3 compute_color(int start, vec3 dir, int render_mod)
+{
+	vec3 color = SH_C0 * get_color(start, 0);
+
+	if (render_mod >= 1 && max_sh_dim >= 4){
+		float x = dir.x;
+		float y = dir.y;
+		float z = dir.z;
+		color = color -
+			SH_C1 * y * get_color(start, 1) +
+			SH_C1 * z * get_color(start, 2) -
+			SH_C1 * x * get_color(start, 3);
+		if (render_mod >= 2 && max_sh_dim >= 9){
+			float xx = x * x, yy = y * y, zz = z * z;
+			float xy = x * y, yz = y * z, xz = x * z;
+			color = color +
+				SH_C2_0 * xy * get_color(start, 4) +
+				SH_C2_1 * yz * get_color(start, 5) +
+				SH_C2_2 * (2.0f * zz - xx - yy) * get_color(start, 6) +
+				SH_C2_3 * xz * get_color(start, 7) +
+				SH_C2_4 * (xx - yy) * get_color(start, 8);
+
+			if (render_mod >= 3 && max_sh_dim >= 16){
+				color = color +
+					SH_C3_0 * y * (3.0f * xx - yy) * get_color(start, 9) +
+					SH_C3_1 * xy * z * get_color(start, 10) +
+					SH_C3_2 * y * (4.0f * zz - xx - yy) * get_color(start, 11) +
+					SH_C3_3 * z * (2.0f * zz - 3.0f * xx - 3.0f * yy) * get_color(start, 12) +
+					SH_C3_4 * x * (4.0f * zz - xx - yy) * get_color(start, 13) +
+					SH_C3_5 * z * (xx - yy) * get_color(start, 14) +
+					SH_C3_6 * x * (xx - 3.0f * yy) * get_color(start, 15);
+			}
+		}
+	}
+	return color + 0.5f;
+}
@@ -0,0 +1,51 @@
+// Projection of a splat's 3D covariance to the screen, shared by
+// draw_splat.vert and tile_preprocess.comp.
+
+mat3 computeCov3D(vec3 scale, vec4 q)  // should be correct
+{
+    mat3 S = mat3(0.f);
+    S[0][0] = scale.x;
+	S[1][1] = scale.y;
+	S[2][2] = scale.z;
+	float r = q.x;
+	float x = q.y;
+	float y = q.z;
+	float z = q.w;
+
+    mat3 R = mat3(
+		1.f - 2.f * (y * y + z * z), 2.f * (x * y - r * z), 2.f * (x * z + r * y),
+		2.f * (x * y + r * z), 1.f - 2.f * (x * x + z * z), 2.f * (y * z - r * x),
+		2.f * (x * z - r * y), 2.f * (y * z + r * x), 1.f - 2.f * (x * x + y * y)
+	);
+
+    mat3 M = S * R;
+    mat3 Sigma = transpose(M) * M;
+    return Sigma;
+}
+
+vec3 computeCov2D(vec4 mean_view, float focal_x, float focal_y, float tan_fovx, float tan_fovy, mat3 cov3D, mat4 viewmatrix)
+{
+    vec4 t = mean_view;
+    // why need this? Try remove this later
+    float limx = 1.3f * tan_fovx;
+    float limy = 1.3f * tan_fovy;
+    float txtz = t.x / t.z;
+    float tytz = t.y / t.z;
+    t.x = min(limx, max(-limx, txtz)) * t.z;
+    t.y = min(limy, max(-limy, tytz)) * t.z;
+
+    mat3 J = mat3(
+        focal_x / t.z, 0.0f, -(focal_x * t.x) / (t.z * t.z),
+		0.0f, focal_y / t.z, -(focal_y * t.y) / (t.z * t.z),
+		0, 0, 0
+    );
+    mat3 W = transpose(mat3(viewmatrix));
+    mat3 T = W * J;
+
+    mat3 cov = transpose(T) * transpose(cov3D) * T;
+    // Apply low-pass filter: every Gaussian should be at least
+	// one pixel wide/high. Discard 3rd row and column.
+	cov[0][0] += 0.3f;
+	cov[1][1] += 0.3f;
+    return vec3(cov[0][0], cov[0][1], cov[1][1]);
+}
@@ -0,0 +1,13 @@
+#version 430 core
+
+// Lays the tile renderer's image over the framebuffer: premultiplied color
+// and coverage, blended with glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA).
+
+uniform sampler2D image;
+
+out vec4 FragColor;
+
+void main()
+{
+	FragColor = texelFetch(image, ivec2(gl_FragCoord.xy), 0);
+}
@@ -0,0 +1,9 @@
+#version 430 core
+
+// one triangle over the whole viewport, for tile_composite.frag and upscale.frag
+
+void main()
+{
+	vec2 uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(uv * 2.f - 1.f, 0.f, 1.f);
+}
@@ -0,0 +1,23 @@
+// A splat as tile_preprocess.comp leaves it for the tile renderer's later
+// passes, with the quad measured in image pixels, y down as in CpuRasterizer.
+
+#define TILE 16
+
+struct Projected {
+	vec4	conic_opacity;	// inverse 2D covariance xx, xy, yy; opacity
+	vec2	center;
+	float	depth;			// view space, positive
+	uvec2	color;			// rgb as packHalf2x16 pairs
+	uvec2	rect;			// covered pixels x0 | y0 << 16, x1 | y1 << 16, inclusive
+};
+
+layout (std430, binding=8) buffer _projected {
+	Projected projected[];
+};
+
+// work groups are dispatched as a 2D grid when one row would exceed the
+// 65535 GL guarantees, see GpuRadixSort::dispatch()
+uint flatGroupID()
+{
+	return gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+}
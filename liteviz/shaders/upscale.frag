@@ -0,0 +1,18 @@
+#version 430 core
+
+// Stretches the scene drawn at a lower resolution into the lower-left region
+// of image over the whole target, bilinear (see resolution.h). Samples are
+// kept half a texel inside the region, off whatever lies beyond it.
+
+uniform sampler2D image;
+uniform vec2 region;	// pixels drawn
+uniform vec2 target;	// pixels of the framebuffer
+
+out vec4 FragColor;
+
+void main()
+{
+	vec2 texels = vec2(textureSize(image, 0));
+	vec2 pos = clamp(gl_FragCoord.xy / target * region, vec2(0.5), region - 0.5);
+	FragColor = texture(image, pos / texels);
+}
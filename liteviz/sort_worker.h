@@ -0,0 +1,226 @@
+#ifndef __SORT_WORKER_H__
+#define __SORT_WORKER_H__
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <Eigen/Dense>
+#include <liteviz/sorter.h>
+#include <liteviz/culling.h>
+#include <liteviz/dataloader.h>
+
+// Single-producer / single-consumer triple buffer. The writer owns the back
+// slot, the reader owns the front slot, and the middle slot is swapped in and
+// out with one atomic exchange, so neither side ever blocks the other.
+template <typename T>
+class TripleBuffer {
+
+public:
+    T& back() { return _slots[_back]; }
+
+    const T& front() const { return _slots[_front]; }
+
+    // writer: hand the back slot over as the newest value
+    void publish() {
+        _back = _middle.exchange(_back | FRESH) & INDEX_MASK;
+    }
+
+    // reader: move the newest value (if any) to the front slot
+    bool fetch() {
+        if (!(_middle.load() & FRESH)) return false;
+        _front = _middle.exchange(_front) & INDEX_MASK;
+        return true;
+    }
+
+    // neither side running: drops a value published but never fetched
+    void reset() {
+        _middle.store(_middle.load() & INDEX_MASK);
+    }
+
+private:
+    static constexpr int INDEX_MASK = 0x3;
+    static constexpr int FRESH      = 0x4;
+
+    T                   _slots[3];
+    int                 _back   = 0;
+    int                 _front  = 1;
+    std::atomic<int>    _middle { 2 };
+};
+
+// Sorts on a background thread so the render loop never waits for it. The
+// render thread submits the current view every frame and draws with the newest
+// ordering the worker has finished, which may be a few frames old.
+class SortWorker {
+
+public:
+    struct Request {
+        Eigen::Matrix4f viewmat;
+        uint64_t        frame       = 0;
+        int             key_bits    = 32;
+        bool            coherent    = true;
+        size_t          count       = 0;    // sort the first count splats
+        bool            cull        = false;
+        float           radius_scale = 1.0f;
+        FrustumCuller::Planes planes;
+    };
+
+    struct Result {
+        std::vector<uint32_t>   index;
+        uint64_t                frame   = 0;
+        uint64_t                version = 0;    // which sorter output index holds
+        size_t                  culled  = 0;
+        CoherentSorter::Stats   stats;
+    };
+
+    // how many frames old the drawn ordering was
+    struct Staleness {
+        static constexpr int BINS = 8;  // last bin counts everything >= BINS - 1
+
+        uint64_t    last    = 0;
+        uint64_t    max     = 0;
+        uint64_t    frames  = 0;
+        uint64_t    total   = 0;
+        uint64_t    histogram[BINS] = {};
+
+        double mean() const { return frames ? double(total) / frames : 0.0; }
+    };
+
+    SortWorker() = default;
+
+    ~SortWorker() {
+        stop();
+    }
+
+    SortWorker(const SortWorker&) = delete;
+    SortWorker& operator=(const SortWorker&) = delete;
+
+    // radius: per splat bounding radius for culling, must stay allocated while running
+    void start(const GaussianData::Positions& xyz, const float* radius) {
+        if (_running) return;
+        _xyz = &xyz;
+        _radius = radius;
+        _running = true;
+        // a request or ordering left from the last run may be for other data
+        _requests.reset();
+        _results.reset();
+        _has_result = false;
+        _thread = std::thread(&SortWorker::loop, this);
+    }
+
+    void stop() {
+        if (!_running) return;
+        _running = false;
+        _thread.join();
+    }
+
+    bool running() const { return _running; }
+
+    // render thread: post the latest camera, older unprocessed requests are dropped
+    void submit(const Request& request) {
+        _requests.back() = request;
+        _requests.publish();
+    }
+
+    // render thread: picks up a newer ordering if one finished, then records
+    // the staleness of whatever will be drawn this frame
+    bool acquire(uint64_t frame) {
+        bool fresh = _results.fetch();
+        _has_result |= fresh;
+        if (_has_result) {
+            uint64_t age = frame - _results.front().frame;
+            _staleness.last = age;
+            _staleness.max = std::max(_staleness.max, age);
+            _staleness.total += age;
+            _staleness.frames += 1;
+            _staleness.histogram[std::min<uint64_t>(age, Staleness::BINS - 1)] += 1;
+        }
+        return fresh;
+    }
+
+    bool hasResult() const { return _has_result; }
+
+    const Result& latest() const { return _results.front(); }
+
+    const Staleness& staleness() const { return _staleness; }
+
+private:
+
+    void loop() {
+
+        CoherentSorter sorter;
+        DepthSorter subset_sorter;
+        FrustumCuller culler;
+        std::vector<uint32_t> index;
+        int idle = 0;
+
+        while (_running) {
+            if (!_requests.fetch()) {
+                // back off from spinning to short sleeps while the camera is idle
+                if (++idle < 64) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+                continue;
+            }
+            idle = 0;
+
+            const Request& request = _requests.front();
+            sorter.setKeyBits(static_cast<DepthSorter::KeyBits>(request.key_bits));
+            if (!request.coherent) {
+                sorter.reset();
+            }
+
+            Result& result = _results.back();
+            if (request.cull) {
+                const size_t visible = culler.cull(_xyz->data(), _radius, request.count, request.radius_scale, request.planes);
+                if (request.coherent) {
+                    if (sorter.sort(_xyz->topRows(request.count), request.viewmat, index)) {
+                        ++_version;
+                    }
+                    result.index.resize(index.size());
+                    result.index.resize(culler.compact(index.data(), index.size(), result.index.data()));
+                } else {
+                    result.index.resize(visible);
+                    subset_sorter.setKeyBits(static_cast<DepthSorter::KeyBits>(request.key_bits));
+                    subset_sorter.sortSubset(*_xyz, request.viewmat, culler.visible().data(), visible, result.index.data());
+                }
+                // holds a culled order, not the sorter output
+                result.version = CULLED;
+                result.culled = request.count - result.index.size();
+            } else {
+                if (sorter.sort(_xyz->topRows(request.count), request.viewmat, index)) {
+                    ++_version;
+                }
+
+                // a slot only needs the copy if it holds an older ordering
+                if (result.version != _version) {
+                    result.index = index;
+                    result.version = _version;
+                }
+                result.culled = 0;
+            }
+            result.frame = request.frame;
+            result.stats = sorter.stats();
+            _results.publish();
+        }
+    }
+
+    static constexpr uint64_t CULLED = UINT64_MAX;
+
+    const GaussianData::Positions* _xyz = nullptr;
+    const float*            _radius = nullptr;
+    std::thread             _thread;
+    std::atomic<bool>       _running { false };
+    uint64_t                _version = 0;   // worker thread only
+
+    TripleBuffer<Request>   _requests;
+    TripleBuffer<Result>    _results;
+
+    bool                    _has_result = false;
+    Staleness               _staleness;
+};
+
+#endif // __SORT_WORKER_H__
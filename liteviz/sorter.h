@@ -0,0 +1,388 @@
+#ifndef __SORTER_H__
+#define __SORTER_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <Eigen/Dense>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/blocked_range.h>
+
+// Depth ordering engine: parallel LSD radix sort over quantized view-space depth keys.
+// Scratch buffers are kept between calls, so sorting the same scene every frame
+// does not allocate once the first frame has been sorted.
+class DepthSorter {
+
+public:
+    enum KeyBits {
+        KEY_16 = 16,
+        KEY_24 = 24,
+        KEY_32 = 32,    // exact: IEEE-754 bits flipped into an unsigned sortable key
+    };
+
+    DepthSorter(KeyBits bits = KEY_32): _bits(bits) {}
+
+    void setKeyBits(KeyBits bits) { _bits = bits; }
+
+    KeyBits keyBits() const { return _bits; }
+
+    // View-space z of every splat center; only the third row of viewmat matters.
+    template <typename Derived>
+    static void viewDepths(const Eigen::MatrixBase<Derived>& xyz, const Eigen::Matrix4f& viewmat, std::vector<float>& depths) {
+
+        const size_t N = xyz.rows();
+        const Eigen::RowVector3f proj_row = viewmat.row(2).head<3>();
+
+        depths.resize(N);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    depths[i] = proj_row(0) * xyz(i, 0) + proj_row(1) * xyz(i, 1) + proj_row(2) * xyz(i, 2);
+                }
+            });
+    }
+
+    // Sorts the N x 3 splat centers by ascending view-space z (back-to-front for
+    // the viewer's camera convention) and writes N indices into out (readable,
+    // see sortDepths).
+    template <typename Derived>
+    void sort(const Eigen::MatrixBase<Derived>& xyz, const Eigen::Matrix4f& viewmat, uint32_t* out) {
+
+        const size_t N = xyz.rows();
+        if (N == 0) return;
+
+        viewDepths(xyz, viewmat, _depths);
+        sortDepths(_depths.data(), N, out);
+    }
+
+    template <typename Derived>
+    void sort(const Eigen::MatrixBase<Derived>& xyz, const Eigen::Matrix4f& viewmat, std::vector<uint32_t>& out) {
+        out.resize(xyz.rows());
+        sort(xyz, viewmat, out.data());
+    }
+
+    // Sorts only the M splats listed in subset (e.g. the survivors of culling);
+    // out receives those same indices in back-to-front order. out is sorted into
+    // and then remapped in place, so like sortDepths it has to be readable.
+    template <typename Derived>
+    void sortSubset(const Eigen::MatrixBase<Derived>& xyz, const Eigen::Matrix4f& viewmat,
+                    const uint32_t* subset, size_t M, uint32_t* out) {
+
+        if (M == 0) return;
+        const Eigen::RowVector3f proj_row = viewmat.row(2).head<3>();
+
+        _depths.resize(M);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, M, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t k = r.begin(); k < r.end(); ++k) {
+                    const size_t i = subset[k];
+                    _depths[k] = proj_row(0) * xyz(i, 0) + proj_row(1) * xyz(i, 1) + proj_row(2) * xyz(i, 2);
+                }
+            });
+
+        sortDepths(_depths.data(), M, out);
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, M, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t k = r.begin(); k < r.end(); ++k) {
+                    out[k] = subset[out[k]];
+                }
+            });
+    }
+
+    // Sorts precomputed depths ascending; out receives the permutation. out is
+    // also one of the ping-pong buffers and is read back, so it has to be host
+    // memory, not a write-only GL mapping.
+    void sortDepths(const float* depths, size_t N, uint32_t* out) {
+
+        _keys.resize(N);
+        _keys_tmp.resize(N);
+        _values_tmp.resize(N);
+
+        makeKeys(depths, N);
+
+        const int passes = static_cast<int>(_bits) / RADIX_BITS;
+
+        // ping-pong the values so the last pass scatters straight into out
+        uint32_t* values_src = (passes % 2 == 0) ? out : _values_tmp.data();
+        uint32_t* values_dst = (passes % 2 == 0) ? _values_tmp.data() : out;
+        uint32_t* keys_src = _keys.data();
+        uint32_t* keys_dst = _keys_tmp.data();
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    values_src[i] = static_cast<uint32_t>(i);
+                }
+            });
+
+        const size_t block_size = std::max<size_t>(GRAIN, (N + MAX_BLOCKS - 1) / MAX_BLOCKS);
+        const size_t num_blocks = (N + block_size - 1) / block_size;
+        _hist.resize(num_blocks * RADIX);
+
+        for (int pass = 0; pass < passes; ++pass) {
+            const int shift = pass * RADIX_BITS;
+
+            std::fill(_hist.begin(), _hist.end(), 0);
+            tbb::parallel_for(size_t(0), num_blocks, [&](size_t b) {
+                uint32_t* hist = &_hist[b * RADIX];
+                const size_t end = std::min(N, (b + 1) * block_size);
+                for (size_t i = b * block_size; i < end; ++i) {
+                    ++hist[(keys_src[i] >> shift) & RADIX_MASK];
+                }
+            });
+
+            // exclusive scan in (digit, block) order keeps the scatter stable
+            uint32_t offset = 0;
+            bool trivial = false;
+            for (int d = 0; d < RADIX; ++d) {
+                uint32_t digit_total = 0;
+                for (size_t b = 0; b < num_blocks; ++b) {
+                    uint32_t count = _hist[b * RADIX + d];
+                    _hist[b * RADIX + d] = offset + digit_total;
+                    digit_total += count;
+                }
+                trivial |= (digit_total == N);
+                offset += digit_total;
+            }
+
+            // every key shares this digit, the pass would be an identity permutation
+            if (trivial) {
+                continue;
+            }
+
+            tbb::parallel_for(size_t(0), num_blocks, [&](size_t b) {
+                uint32_t* hist = &_hist[b * RADIX];
+                const size_t end = std::min(N, (b + 1) * block_size);
+                for (size_t i = b * block_size; i < end; ++i) {
+                    uint32_t key = keys_src[i];
+                    uint32_t pos = hist[(key >> shift) & RADIX_MASK]++;
+                    keys_dst[pos] = key;
+                    values_dst[pos] = values_src[i];
+                }
+            });
+
+            std::swap(keys_src, keys_dst);
+            std::swap(values_src, values_dst);
+        }
+
+        // skipped passes break the ping-pong parity
+        if (values_src != out) {
+            std::memcpy(out, values_src, N * sizeof(uint32_t));
+        }
+    }
+
+    static constexpr size_t GRAIN       = 1 << 14;
+
+private:
+
+    static constexpr int    RADIX_BITS  = 8;
+    static constexpr int    RADIX       = 1 << RADIX_BITS;
+    static constexpr int    RADIX_MASK  = RADIX - 1;
+    static constexpr size_t MAX_BLOCKS  = 256;
+
+    void makeKeys(const float* depths, size_t N) {
+
+        if (_bits == KEY_32) {
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, N, GRAIN),
+                [&](const tbb::blocked_range<size_t>& r) {
+                    for (size_t i = r.begin(); i < r.end(); ++i) {
+                        uint32_t u;
+                        std::memcpy(&u, &depths[i], sizeof(float));
+                        _keys[i] = u ^ ((u >> 31) ? 0xFFFFFFFFu : 0x80000000u);
+                    }
+                });
+            return;
+        }
+
+        using MinMax = std::pair<float, float>;
+        MinMax range = tbb::parallel_reduce(
+            tbb::blocked_range<size_t>(0, N, GRAIN),
+            MinMax(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()),
+            [&](const tbb::blocked_range<size_t>& r, MinMax mm) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    mm.first = std::min(mm.first, depths[i]);
+                    mm.second = std::max(mm.second, depths[i]);
+                }
+                return mm;
+            },
+            [](const MinMax& a, const MinMax& b) {
+                return MinMax(std::min(a.first, b.first), std::max(a.second, b.second));
+            });
+
+        const float max_key = static_cast<float>((1u << _bits) - 1u);
+        const float extent = range.second - range.first;
+        const float scale = extent > 0.0f ? max_key / extent : 0.0f;
+        const float lo = range.first;
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, GRAIN),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    float q = (depths[i] - lo) * scale;
+                    _keys[i] = static_cast<uint32_t>(std::min(q, max_key));
+                }
+            });
+    }
+
+    KeyBits                 _bits;
+    std::vector<float>      _depths;
+    std::vector<uint32_t>   _keys;
+    std::vector<uint32_t>   _keys_tmp;
+    std::vector<uint32_t>   _values_tmp;
+    std::vector<uint32_t>   _hist;
+};
+
+// Temporally coherent wrapper around DepthSorter. The ordering is by planar
+// view depth, which only depends on the viewing direction (a camera
+// translation adds the same offset to every depth), so each frame takes one of
+// three paths depending on how far the direction turned since the last sort:
+//  - skip:   keep the previous order untouched,
+//  - refine: repair the previous order with a bounded insertion pass,
+//  - full:   radix sort from scratch.
+// Turning by an angle a shifts a splat by roughly a * N / 2 ranks in a dense
+// scene, which is what decides whether the insertion pass can beat a full sort;
+// rather than guess from the angle, frames that are not skipped try the pass,
+// which gives up as soon as it goes over refine_budget, and after a failure
+// only smaller turns are tried until the limit has crept back.
+class CoherentSorter {
+
+public:
+    struct Stats {
+        size_t skipped  = 0;
+        size_t refined  = 0;
+        size_t full     = 0;
+    };
+
+    float skip_angle    = 1.0e-3f;  // radians the view direction may turn before re-sorting
+    float refine_budget = 4.0f;     // insertion moves per splat before a full sort is cheaper
+
+    void setKeyBits(DepthSorter::KeyBits bits) { _sorter.setKeyBits(bits); }
+
+    const Stats& stats() const { return _stats; }
+
+    void resetStats() { _stats = Stats(); }
+
+    // Invalidates the previous ordering, e.g. after the scene changed.
+    void reset() {
+        _valid = false;
+        _refine_angle = std::numeric_limits<float>::max();
+    }
+
+    // Updates index for viewmat; returns false when the previous order was kept.
+    template <typename Derived>
+    bool sort(const Eigen::MatrixBase<Derived>& xyz, const Eigen::Matrix4f& viewmat, std::vector<uint32_t>& index) {
+
+        const size_t N = xyz.rows();
+        const Eigen::Vector3f dir = viewmat.row(2).head<3>().transpose();
+        const bool coherent = _valid && index.size() == N;
+        const float angle = (dir - _sorted_dir).norm();
+
+        if (coherent && angle < skip_angle) {
+            ++_stats.skipped;
+            return false;
+        }
+
+        DepthSorter::viewDepths(xyz, viewmat, _depths);
+
+        // turns the pass failed on lately are not tried again at once, but
+        // the limit creeps back up so it is probed now and then
+        bool refined = false;
+        if (coherent && angle < _refine_angle) {
+            refined = refine(index);
+            if (!refined) _refine_angle = 0.5f * angle;
+        } else if (coherent) {
+            _refine_angle *= 1.1f;
+        }
+
+        if (refined) {
+            ++_stats.refined;
+        } else {
+            index.resize(N);
+            _sorter.sortDepths(_depths.data(), N, index.data());
+            ++_stats.full;
+        }
+
+        _sorted_dir = dir;
+        _valid = true;
+        return true;
+    }
+
+private:
+
+    bool refine(std::vector<uint32_t>& index) {
+
+        const size_t N = index.size();
+        _ordered.resize(N);
+        _candidate.resize(N);
+
+        // gather and sort independent blocks in parallel first, then let one
+        // sequential pass fix the few splats that drifted across block
+        // boundaries; the first block over its budget stops the others, so a
+        // failed attempt costs little next to the full sort it falls back to
+        const size_t block_size = DepthSorter::GRAIN;
+        const size_t num_blocks = (N + block_size - 1) / block_size;
+        const size_t block_budget = static_cast<size_t>(refine_budget * block_size) + 1;
+        std::atomic<bool> within_budget(true);
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, num_blocks, 1),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t b = r.begin(); b < r.end(); ++b) {
+                    if (!within_budget.load(std::memory_order_relaxed)) return;
+                    const size_t begin = b * block_size, end = std::min(N, (b + 1) * block_size);
+                    for (size_t i = begin; i < end; ++i) {
+                        _candidate[i] = index[i];
+                        _ordered[i] = _depths[index[i]];
+                    }
+                    if (!insertionSort(begin, end, block_budget)) within_budget.store(false, std::memory_order_relaxed);
+                }
+            });
+
+        const size_t total_budget = static_cast<size_t>(refine_budget * N) + 1;
+        if (!within_budget.load() || !insertionSort(0, N, total_budget)) {
+            return false;
+        }
+
+        index.swap(_candidate);
+        return true;
+    }
+
+    // Insertion sort of _ordered/_candidate over [begin, end), aborting once more
+    // than budget elements have been shifted.
+    bool insertionSort(size_t begin, size_t end, size_t budget) {
+
+        size_t moves = 0;
+        for (size_t i = begin + 1; i < end; ++i) {
+            const float d = _ordered[i];
+            if (!(d < _ordered[i - 1])) continue;
+
+            const uint32_t v = _candidate[i];
+            size_t j = i;
+            while (j > begin && d < _ordered[j - 1]) {
+                _ordered[j] = _ordered[j - 1];
+                _candidate[j] = _candidate[j - 1];
+                --j;
+            }
+            _ordered[j] = d;
+            _candidate[j] = v;
+
+            moves += i - j;
+            if (moves > budget) return false;
+        }
+        return true;
+    }
+
+    DepthSorter             _sorter;
+    Stats                   _stats;
+    bool                    _valid = false;
+    Eigen::Vector3f         _sorted_dir = Eigen::Vector3f::Zero();
+    float                   _refine_angle = std::numeric_limits<float>::max();  // turns to try refine() on
+    std::vector<float>      _depths;
+    std::vector<float>      _ordered;
+    std::vector<uint32_t>   _candidate;
+};
+
+#endif // __SORTER_H__
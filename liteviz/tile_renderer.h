@@ -0,0 +1,188 @@
+#ifndef __TILE_RENDERER_H__
+#define __TILE_RENDERER_H__
+
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <Eigen/Dense>
+#include <glad/glad.h>
+#include <liteviz/shader.h>
+#include <liteviz/render_config.h>
+#include <liteviz/gpu_sorter.h>
+
+// Splat renderer in compute shaders, tile-based like the 3DGS reference
+// rasterizer and CpuRasterizer: each pixel is written once, instead of
+// blended once per quad that overlaps it. Renderer draws with it when
+// RenderConfig::tile_render is set. A frame runs:
+//  - tile_preprocess.comp: project the listed splats as draw_splat.vert
+//    does, evaluate their colors, count the 16x16 tiles each one covers,
+//  - a prefix sum of the counts, then tile_keys.comp writes one
+//    (tile, depth) key per covered tile at each splat's offset,
+//  - GpuRadixSort orders the keys by the 32 depth bits and as many tile
+//    bits as the image has tiles,
+//  - tile_keys.comp finds each tile's run of keys, and tile_blend.comp
+//    composites every tile front to back until all its pixels are opaque,
+//  - tile_composite.frag lays the image over the bound framebuffer.
+// The key count is read back after the prefix sum to size the sort, the
+// one point where the CPU waits for the GPU, as the reference does.
+class TileRenderer {
+
+public:
+    static constexpr int    TILE        = 16;
+    static constexpr int    GROUP       = GpuRadixSort::GROUP;
+
+    // defines: Renderer::shaderDefines() of the data to draw
+    explicit TileRenderer(const std::string& defines): _radix(true) {
+        const std::string path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+        auto compute = [&](const char* name, const std::string& extra) {
+            return std::make_unique<Shader>((path + "/" + name).c_str(), extra);
+        };
+        _preprocess = compute("tile_preprocess.comp", defines);
+        _emit_keys = compute("tile_keys.comp", "#define EMIT_KEYS\n");
+        _find_ranges = compute("tile_keys.comp", "#define FIND_RANGES\n");
+        _blend = compute("tile_blend.comp", "");
+        _composite = std::make_unique<Shader>((path + "/tile_composite.vert").c_str(),
+                                              (path + "/tile_composite.frag").c_str(), false);
+        glGenVertexArrays(1, &_vao);
+    }
+
+    ~TileRenderer() {
+        for (GpuBuffer* buffer : { &_projected, &_tiles, &_keys[0], &_keys[1], &_values[0], &_values[1], &_ranges }) {
+            buffer->release();
+        }
+        if (_image) glDeleteTextures(1, &_image);
+        glDeleteVertexArrays(1, &_vao);
+    }
+
+    TileRenderer(const TileRenderer&) = delete;
+    TileRenderer& operator=(const TileRenderer&) = delete;
+
+    // Draws the count splats listed at shader storage binding 1 over the
+    // bound framebuffer, size pixels, reading the splats from the bindings
+    // draw_splat.vert reads. Uses config's render mode, scale modifier and
+    // SH dimension; splat_words is the stride of compact storage.
+    void render(size_t count, const Eigen::Matrix4f& projmat, const Eigen::Matrix4f& viewmat,
+                const Eigen::Vector3f& cam_pos, const Eigen::Vector2f& tanxy, float focal,
+                const Eigen::Vector2i& size, const RenderConfig& config, int splat_words) {
+
+        _entries = 0;
+        if (count == 0 || size.x() <= 0 || size.y() <= 0) return;
+        const int tiles_x = (size.x() + TILE - 1) / TILE;
+        const int tiles_y = (size.y() + TILE - 1) / TILE;
+        const size_t tiles = size_t(tiles_x) * tiles_y;
+
+        _projected.reserve(count * PROJECTED_BYTES);
+        _tiles.reserve(count * sizeof(uint32_t));
+        _projected.bind(8);
+        _tiles.bind(9);
+        _preprocess->bind(false);
+        _preprocess->set_uniform("projmat", projmat);
+        _preprocess->set_uniform("viewmat", viewmat);
+        _preprocess->set_uniform("cam_pos", cam_pos);
+        _preprocess->set_uniform("tanxy", tanxy);
+        _preprocess->set_uniform("focal", focal);
+        _preprocess->set_uniform("scale_modifier", config.scale_modifier);
+        _preprocess->set_uniform("render_mod", config.render_mode);
+        _preprocess->set_uniform("max_sh_dim", config.max_sh_dim);
+        _preprocess->set_uniform("count", static_cast<int>(count));
+        _preprocess->set_uniform("width", size.x());
+        _preprocess->set_uniform("height", size.y());
+        if (splat_words > 0) {
+            _preprocess->set_uniform("splat_words", splat_words);
+        }
+        GpuRadixSort::dispatch(GpuRadixSort::groups(count, GROUP));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        // tile counts to offsets, and the number of keys
+        _entries = _radix.scan(_tiles, count, true);
+
+        _ranges.reserve(tiles * 2 * sizeof(uint32_t));
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _ranges.id);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_RG32UI, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        int sorted = 0;
+        if (_entries > 0) {
+            for (int i = 0; i < 2; ++i) {
+                _keys[i].reserve(_entries * 2 * sizeof(uint32_t));
+                _values[i].reserve(_entries * sizeof(uint32_t));
+            }
+            _projected.bind(8);
+            _tiles.bind(9);
+            _keys[0].bind(10);
+            _values[0].bind(11);
+            _emit_keys->bind(false);
+            _emit_keys->set_uniform("count", static_cast<int>(count));
+            _emit_keys->set_uniform("total", static_cast<int>(_entries));
+            _emit_keys->set_uniform("tiles_x", tiles_x);
+            GpuRadixSort::dispatch(GpuRadixSort::groups(count, GROUP));
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            int tile_bits = 0;
+            while ((size_t(1) << tile_bits) < tiles) ++tile_bits;
+            sorted = _radix.sort(_keys, _values, _entries, 32 + tile_bits);
+
+            _keys[sorted].bind(10);
+            _ranges.bind(12);
+            _find_ranges->bind(false);
+            _find_ranges->set_uniform("count", static_cast<int>(_entries));
+            GpuRadixSort::dispatch(GpuRadixSort::groups(_entries, GROUP));
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        if (_image_size != size) {
+            if (_image) glDeleteTextures(1, &_image);
+            glGenTextures(1, &_image);
+            glBindTexture(GL_TEXTURE_2D, _image);
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, size.x(), size.y());
+            glBindTexture(GL_TEXTURE_2D, 0);
+            _image_size = size;
+        }
+        _projected.bind(8);
+        _values[sorted].bind(9);
+        _ranges.bind(12);
+        glBindImageTexture(0, _image, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        _blend->bind(false);
+        _blend->set_uniform("width", size.x());
+        _blend->set_uniform("height", size.y());
+        _blend->set_uniform("render_mod", config.render_mode);
+        glDispatchCompute(tiles_x, tiles_y, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        // C + T * framebuffer
+        _composite->bind(false);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, _image);
+        _composite->set_uniform("image");
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        glBindVertexArray(_vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // (tile, splat) pairs of the last frame
+    size_t entries() const { return _entries; }
+
+private:
+    static constexpr size_t PROJECTED_BYTES = 48;   // struct Projected in tile_data.glsl
+
+    std::unique_ptr<Shader> _preprocess;
+    std::unique_ptr<Shader> _emit_keys;
+    std::unique_ptr<Shader> _find_ranges;
+    std::unique_ptr<Shader> _blend;
+    std::unique_ptr<Shader> _composite;
+    GpuRadixSort            _radix;
+    GLuint                  _vao        = 0;
+    GLuint                  _image      = 0;    // RGBA16F, premultiplied color and coverage
+    Eigen::Vector2i         _image_size = Eigen::Vector2i::Zero();
+    GpuBuffer               _projected;
+    GpuBuffer               _tiles;             // covered tiles per splat, then their key offsets
+    GpuBuffer               _keys[2];           // (depth bits, tile), ping-ponged by the sort
+    GpuBuffer               _values[2];         // splat per key
+    GpuBuffer               _ranges;            // [begin, end) of each tile's keys
+    size_t                  _entries    = 0;
+};
+
+#endif // __TILE_RENDERER_H__
@@ -9,10 +9,16 @@
 #include <backends/imgui_impl_opengl3.h>
 #include <iostream>
 #include <chrono>
+#include <iomanip>
 #include <liteviz/shader.h>
 #include <liteviz/dataloader.h>
 #include <liteviz/viewport.h>
 #include <liteviz/renderer.h>
+#include <liteviz/progressive.h>
+#include <liteviz/capture.h>
+#include <liteviz/picker.h>
+#include <liteviz/profiler.h>
+#include <liteviz/resolution.h>
     
 class LiteViewer{
 
@@ -29,6 +35,20 @@ private:
     
     bool any_window_active = false;
 
+    // screenshots (P) and recording (R) of the scene, without the UI
+    FrameCapture capture;
+    bool screenshot_requested = false;
+    bool recording = false;
+    std::string recording_dir;
+    size_t recorded_frames = 0;
+
+    SplatPicker* picker = nullptr;  // orbit and pan pivots, none out-of-core
+
+    Profiler profiler;
+    bool show_profiler = false;
+
+    DynamicResolution resolution;   // moving frames below full resolution, see RenderConfig::dynamic_resolution
+
 public:
     LiteViewer(std::string title, int width, int height):
         title(title), viewport(width, height){
@@ -73,6 +93,7 @@ public:
             glfwTerminate();
             return -1;
         }
+        StreamBuffer::setProcLoader((GLADloadproc)glfwGetProcAddress);
 
         glfwSwapInterval(1); // Enable vsync
 
@@ -169,7 +190,45 @@ public:
 
         auto &viewport = viewer->viewport;
 
-        // TODO: not implemented yet (pxk)
+        if (action != GLFW_PRESS) return;
+        if (key == GLFW_KEY_P) {
+            viewer->screenshot_requested = true;
+        } else if (key == GLFW_KEY_R) {
+            viewer->toggleRecording();
+        }
+    }
+
+    void toggleRecording() {
+        recording = !recording;
+        if (recording) {
+            recording_dir = "recording-" + getTimestamp();
+            recorded_frames = 0;
+            std::filesystem::create_directories(recording_dir);
+            std::cout << "Recording to " << recording_dir << std::endl;
+        } else {
+            capture.flush();
+            const FrameCapture::Stats& stats = capture.stats();
+            std::cout << "Recorded " << recorded_frames << " frames to " << recording_dir << " ("
+                      << stats.dropped << " dropped in total)" << std::endl;
+        }
+    }
+
+    // Queues the readback of the frame just drawn, before the UI goes on top.
+    void captureFrame() {
+        const Eigen::Vector2i size = viewport.getFrameBufferSize();
+        if (screenshot_requested || recording) glReadBuffer(GL_BACK);
+        if (screenshot_requested) {
+            const std::string path = "screenshot-" + getTimestamp() + ".png";
+            capture.capture(size.x(), size.y(), path);
+            std::cout << "Screenshot saved to " << path << std::endl;
+            screenshot_requested = false;
+        }
+        if (recording) {
+            std::ostringstream path;
+            path << recording_dir << "/" << std::setw(6) << std::setfill('0') << recorded_frames++ << ".png";
+            capture.capture(size.x(), size.y(), path.str(), true);
+        }
+        capture.poll();
     }
 
     static void dropCallback(GLFWwindow* window, int count, const char** paths) {
@@ -202,7 +261,9 @@ public:
         return std::string(buffer);
     }
 
-    void configuration(RenderConfig& config) {
+    void configuration(Renderer& renderer, const ProgressiveLoader* loader = nullptr) {
+
+        RenderConfig& config = renderer.config();
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -248,13 +309,137 @@ public:
         ImGui::Checkbox("Vertical Synch.", &config.vsync);
         ImGui::Checkbox("Depth Sort", &config.depth_sort);
 
+        static const char* key_items[] = { "16-bit", "24-bit", "32-bit" };
+        int key_item = config.sort_key_bits / 8 - 2;
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(-1);
+        if (ImGui::Combo("##sort_key_bits", &key_item, key_items, 3)) {
+            config.sort_key_bits = (key_item + 2) * 8;
+        }
+        ImGui::Checkbox("Coherent Sort", &config.coherent_sort);
+        ImGui::SameLine();
+        ImGui::Checkbox("Async Sort", &config.async_sort);
+        ImGui::SameLine();
+        ImGui::Checkbox("GPU Sort", &config.gpu_sort);
+        ImGui::Checkbox("Frustum Culling", &config.frustum_culling);
+        ImGui::Checkbox("Tile Renderer", &config.tile_render);
+        if (renderer.hasCov3D()) {
+            ImGui::Checkbox("Precomputed Cov3D", &config.precomputed_cov3d);
+        }
+        ImGui::Checkbox("Dynamic Resolution", &config.dynamic_resolution);
+        if (config.dynamic_resolution) {
+            ImGui::SetNextItemWidth(145.0f);
+            ImGui::SliderFloat("##frame_budget", &config.frame_budget, 2.0f, 50.0f, "Budget=%.1f ms");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(-1);
+            ImGui::SliderFloat("##min_render_scale", &config.min_render_scale, 0.1f, 1.0f, "Min=%.2f");
+        }
+        ImGui::Checkbox("Color Cache", &config.color_cache);
+        if (config.color_cache) {
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(-1);
+            ImGui::SliderFloat("##cache_angle", &config.cache_angle, 0.0f, 5.0f, "Angle=%.1f deg");
+        }
+        if (renderer.hasLOD()) {
+            ImGui::Checkbox("Level of Detail", &config.level_of_detail);
+            int budget = static_cast<int>(config.splat_budget / 100000);
+            ImGui::SetNextItemWidth(-1);
+            if (ImGui::SliderInt("##splat_budget", &budget, 0, 200, budget ? "Budget=%d00k" : "Budget=unlimited")) {
+                config.splat_budget = static_cast<size_t>(budget) * 100000;
+            }
+            ImGui::SetNextItemWidth(-1);
+            ImGui::SliderFloat("##lod_threshold", &config.lod_threshold, 0.5f, 16.0f, "LOD Threshold=%.1f px");
+        }
+
         ImGui::Separator();
         ImGui::Text("Primitive Count: %zu", config.num_primitives);
+        ImGui::Text("Splat Memory: %.1f MB (%zu B/splat)",
+            double(config.num_primitives * config.bytes_per_splat) / (1 << 20), config.bytes_per_splat);
+        if (config.frustum_culling) {
+            ImGui::Text("Culled: %zu (%.0f%%)", config.num_culled,
+                config.num_primitives ? 100.0 * config.num_culled / config.num_primitives : 0.0);
+        }
+        if ((renderer.hasLOD() && config.level_of_detail) || renderer.pager()) {
+            ImGui::Text("Drawn: %zu (%.0f%%)", renderer.drawn(),
+                config.num_primitives ? 100.0 * renderer.drawn() / config.num_primitives : 0.0);
+        }
+        if (config.tile_render) {
+            ImGui::Text("Tile Entries: %zu (%.1f per splat)", renderer.tileEntries(),
+                renderer.drawn() ? double(renderer.tileEntries()) / renderer.drawn() : 0.0);
+        }
+        if (config.dynamic_resolution) {
+            const Eigen::Vector2i& size = resolution.size();
+            ImGui::Text("Render Scale: %.2f (%dx%d)%s", config.render_scale, size.x(), size.y(),
+                config.render_scale < 1.0f ? "" : ", full");
+            const std::vector<float>& scales = resolution.scaleHistory();
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "scale %.2f", resolution.scale());
+            ImGui::PlotLines("##scale_graph", scales.data(), static_cast<int>(scales.size()), 0, overlay, 0.0f, 1.0f,
+                ImVec2(-1, 40.0f));
+            const std::vector<float>& times = resolution.timeHistory();
+            snprintf(overlay, sizeof(overlay), "splats %.2f ms, budget %.1f ms", resolution.lastTime(), config.frame_budget);
+            ImGui::PlotLines("##scene_graph", times.data(), static_cast<int>(times.size()), 0, overlay, 0.0f,
+                2.0f * config.frame_budget, ImVec2(-1, 40.0f));
+        }
+        if (config.color_cache) {
+            ImGui::Text("Re-baked: %zu, SH Reads Saved: %.1f MB/frame", config.num_baked,
+                double(config.sh_bytes_saved) / (1 << 20));
+        }
         ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+        ImGui::SameLine();
+        ImGui::Checkbox("Profiler", &show_profiler);
+        if (picker && picker->latency().picks > 0) {
+            const SplatPicker::Latency& latency = picker->latency();
+            ImGui::Text("Pick: %.2f ms (mean %.2f, max %.2f), %zu / %zu hit", latency.last * 1e3,
+                latency.mean() * 1e3, latency.max * 1e3, latency.hits, latency.picks);
+        }
+        if (ImGui::Button("Screenshot", ImVec2(140.0f, 0.0f))) {
+            screenshot_requested = true;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button(recording ? "Stop Recording" : "Record", ImVec2(-1, 0.0f))) {
+            toggleRecording();
+        }
+        if (recording) {
+            const FrameCapture::Stats& stats = capture.stats();
+            ImGui::Text("Recording: %zu frames, %zu dropped, %d in flight", recorded_frames, stats.dropped, capture.pending());
+        }
+        if (loader) {
+            const ProgressiveLoader::Timing& timing = loader->timing();
+            if (timing.complete < 0.0) {
+                ImGui::Text("Loading: %zu / %zu", renderer.available(), loader->data().size());
+            } else {
+                ImGui::Text("First Pixel: %.0f ms, Complete: %.0f ms (decoded at %.0f ms)", timing.first_pixel * 1e3,
+                            timing.complete * 1e3, timing.loaded * 1e3);
+            }
+        }
+        if (const ChunkPager* pager = renderer.pager()) {
+            const ChunkPager::Stats& paging = pager->stats();
+            ImGui::Separator();
+            ImGui::Text("Resident: %zu / %zu chunks (%zu slots)", paging.resident, paging.chunks, paging.slots);
+            ImGui::Text("Visible: %zu (%zu resident), Prefetch: %zu", paging.visible, paging.visible_resident, paging.prefetching);
+            ImGui::Text("Loads: %llu (%zu in flight), Evictions: %llu",
+                (unsigned long long)paging.loads, paging.loading, (unsigned long long)paging.evictions);
+            ImGui::Text("Disk: %.1f MB/s, Upload: %.1f MB/s", paging.read_rate, paging.upload_rate);
+            ImGui::Text("Total: %.0f MB read, %.0f MB uploaded",
+                double(paging.bytes_read) / (1 << 20), double(paging.bytes_uploaded) / (1 << 20));
+        }
+
+        const CoherentSorter::Stats& sort_stats = renderer.sortStats();
+        ImGui::Text("Sort: skip %zu / refine %zu / full %zu", sort_stats.skipped, sort_stats.refined, sort_stats.full);
+        if (config.async_sort) {
+            const SortWorker::Staleness& staleness = renderer.sortStaleness();
+            ImGui::Text("Sort Lag: %llu frames (avg %.2f, max %llu)",
+                (unsigned long long)staleness.last, staleness.mean(), (unsigned long long)staleness.max);
+        }
 
         ImGui::End();
         ImGui::PopStyleColor();
 
+        if (show_profiler) {
+            profilerWindow();
+        }
+
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
@@ -266,36 +451,196 @@ public:
         }
     }
 
-    void draw(const GaussianData& data) {
+    // loader: progressive load in flight on data, splats are appended as they arrive
+    // lod: levels of detail built over data, drawn instead of the full scene
+    void draw(const GaussianData& data, ProgressiveLoader* loader = nullptr, const SplatLOD* lod = nullptr) {
 
         if(!init()){
             std::cerr << "Failed to init LiteViz" << std::endl;
             return;
         }
 
-        std::string shader_path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+        std::shared_ptr<Shader> splatShader = createSplatShader(data);
+        // the loader may be re-packing the rows it published
+        std::unique_lock<std::mutex> hold;
+        if (loader) hold = loader->lock();
+        Renderer renderer(data, splatShader.get(), loader ? loader->loaded() : data.size(), lod);
+        if (hold.owns_lock()) hold.unlock();
+
+        // a scene still loading gets its octree once it is loaded, see loop()
+        SplatPicker splatPicker;
+        if (lod) {
+            splatPicker.use(lod->octree());
+        } else if (!loader) {
+            splatPicker.build(data);
+        }
+        picker = &splatPicker;
+        viewport.depthPicker = [this, &renderer](const Eigen::Vector2f& pos, float& zNDC) {
+            return picker->pick(viewport, pos, renderer.config().scale_modifier, zNDC);
+        };
+
+        loop(renderer, loader);
+
+        viewport.depthPicker = nullptr;
+        picker = nullptr;
+    }
+
+    // out-of-core: the scene streams through the pager's fixed pool
+    void draw(ChunkPager& pager) {
+
+        if(!init()){
+            std::cerr << "Failed to init LiteViz" << std::endl;
+            return;
+        }
 
-        std::shared_ptr<Shader> splatShader = std::make_shared<Shader>(
+        std::shared_ptr<Shader> splatShader = createSplatShader(pager.pool());
+        Renderer renderer(pager, splatShader.get());
+        loop(renderer, nullptr);
+    }
+
+private:
+
+    static std::shared_ptr<Shader> createSplatShader(const GaussianData& data) {
+        std::string shader_path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+        return std::make_shared<Shader>(
             (shader_path + "/draw_splat.vert").c_str(),
             (shader_path + "/draw_splat.frag").c_str(),
-            false
+            false,
+            Renderer::shaderDefines(data)
         );
+    }
 
-        Renderer renderer(data, splatShader.get());
+    // Stage times over the last Profiler::WINDOW frames, and Chrome traces.
+    void profilerWindow() {
+
+        ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.5f, 0.5f, 0.5f, 0.8f));
+        ImGui::Begin("Profiler", &show_profiler, window_flags);
+        ImGui::SetWindowSize(ImVec2(380, 0));
+
+        const Profiler::Summary frame = profiler.frameSummary();
+        const std::vector<float>& graph = profiler.frameGraph();
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "frame %.2f ms, p99 %.2f ms", frame.last * 1e3, frame.p99 * 1e3);
+        ImGui::PlotLines("##frame_graph", graph.data(), static_cast<int>(graph.size()), 0, overlay, 0.0f,
+            std::max(33.3f, float(frame.p99 * 1e3) * 1.2f), ImVec2(-1, 80.0f));
+
+        if (ImGui::BeginTable("##stages", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)) {
+            ImGui::TableSetupColumn("stage (ms)");
+            ImGui::TableSetupColumn("last");
+            ImGui::TableSetupColumn("p50");
+            ImGui::TableSetupColumn("p95");
+            ImGui::TableSetupColumn("p99");
+            ImGui::TableHeadersRow();
+            auto row = [](const char* name, const char* unit, const Profiler::Summary& summary) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s%s", name, unit);
+                for (double value : { summary.last, summary.p50, summary.p95, summary.p99 }) {
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", value * 1e3);
+                }
+            };
+            row("frame", "", frame);
+            for (size_t i = 0; i < profiler.stages(); ++i) {
+                row(profiler.name(i).c_str(), profiler.gpu(i) ? " (GPU)" : "", profiler.summary(i));
+            }
+            ImGui::EndTable();
+        }
+
+        if (!profiler.tracing()) {
+            if (ImGui::Button("Start Trace", ImVec2(-1, 0.0f))) {
+                profiler.startTrace();
+            }
+        } else {
+            char label[64];
+            snprintf(label, sizeof(label), "Save Trace (%zu events)", profiler.traceEvents());
+            if (ImGui::Button(label, ImVec2(-1, 0.0f))) {
+                const std::string path = "trace-" + getTimestamp() + ".json";
+                if (profiler.writeTrace(path)) {
+                    std::cout << "Trace saved to " << path << std::endl;
+                } else {
+                    std::cerr << "Failed to write " << path << std::endl;
+                }
+            }
+        }
+
+        ImGui::End();
+        ImGui::PopStyleColor();
+    }
+
+    void loop(Renderer& renderer, ProgressiveLoader* loader) {
+
+        size_t range_version = 0;
+        bool profiling = false;
+        renderer.setResolution(&resolution);
 
         while (!glfwWindowShouldClose(window)){
 
+            // no queries or windows while the profiler is hidden, switched at a frame's start
+            if (show_profiler != profiling) {
+                profiling = show_profiler;
+                renderer.setProfiler(profiling ? &profiler : nullptr);
+                if (!profiling) {
+                    profiler.newFrame();
+                    profiler.pause();
+                }
+            }
+            Profiler* frame_profiler = profiling ? &profiler : nullptr;
+            if (profiling) profiler.newFrame();
+
             glClearBufferfv(GL_COLOR, 0, clearColor.data());
 
             updateWindowSize();
 
-            renderer.render(viewer->viewport);
+            if (loader) {
+                // skipped while the loader re-packs, the uploaded splats are drawn meanwhile
+                std::unique_lock<std::mutex> lock = loader->tryLock();
+                if (lock.owns_lock()) {
+                    if (loader->rangeVersion() != range_version) {
+                        range_version = loader->rangeVersion();
+                        renderer.requantize();
+                    }
+                    renderer.append(loader->loaded());
+                }
+                if (picker && !picker->started() && loader->loaded() == loader->data().size()) {
+                    picker->build(loader->data());
+                }
+            }
+
+            {
+                const Viewport scene = resolution.begin(viewer->viewport, renderer.config(), clearColor);
+                renderer.render(scene);
+                Profiler::Zone zone(frame_profiler, "upscale");
+                resolution.end();
+            }
+
+            {
+                Profiler::Zone zone(frame_profiler, "capture");
+                captureFrame();
+            }
 
-            configuration(renderer.config());
+            {
+                Profiler::Zone zone(frame_profiler, "ui");
+                Profiler::GpuZone gpu_zone(frame_profiler, "ui");
+                configuration(renderer, loader);
+            }
+
+            {
+                // waits for vsync when it is on
+                Profiler::Zone zone(frame_profiler, "swap");
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
 
-            glfwSwapBuffers(window);
-            glfwPollEvents();
+            if (loader) {
+                loader->frameDrawn(renderer.drawn(), renderer.available());
+            }
         }
+
+        if (recording) toggleRecording();
+        capture.flush();
+        renderer.setProfiler(nullptr);
+        renderer.setResolution(nullptr);
     }
 
 };
@@ -4,6 +4,7 @@
 #include <Eigen/Eigen>
 #include <Eigen/Dense>
 #include <iostream>
+#include <functional>
 #include <GL/gl.h>
 #include <GL/glu.h>
 
@@ -170,11 +171,12 @@ public:
         return frameBufferSize;
     }
 
-    void getPixelPosition(const Eigen::Vector2f& pos, float& zNDC, Eigen::Vector3f& Pw, Eigen::Vector3f& Pc, float default_z){
-        Eigen::Vector2i pick_pos = {int(pos.x()), int(windowSize.y() - pos.y())};
-        glReadPixels(pick_pos.x(), pick_pos.y(), 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &zNDC);
+    // Window depth of the scene under a window position, false where there
+    // is nothing; see SplatPicker. Without one every pick takes default_z.
+    std::function<bool(const Eigen::Vector2f& pos, float& zNDC)> depthPicker;
 
-        if(zNDC == 1){
+    void getPixelPosition(const Eigen::Vector2f& pos, float& zNDC, Eigen::Vector3f& Pw, Eigen::Vector3f& Pc, float default_z){
+        if(!depthPicker || !depthPicker(pos, zNDC)){
             zNDC = default_z;
         }
 
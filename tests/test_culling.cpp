@@ -0,0 +1,183 @@
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <utility>
+#include <tbb/task_arena.h>
+#include <tbb/global_control.h>
+#include <liteviz/culling.h>
+
+// FrustumCuller::cull() and compact() on many threads against a reference:
+// cull() run in a single-thread arena, and compact() against a plain serial
+// filter of the order by that reference set. Random scenes and views, many
+// blocks each, and splats culled at the end of blocks so a block writing
+// past its own output range would show.
+// Then cull() against brute-force projection: probe splats are scattered in
+// view space around the frustum's sides, near and far, and each one's center
+// and points of its 3-sigma sphere are projected through projmat * viewmat.
+// A probe the shader draws (center within CLIP_BOUND) that reaches the
+// viewport, or its low-pass margin, must survive; one whose sphere, doubled,
+// lies outside the frustum widened by twice the guard band, or whose center
+// is off the shader's depth range, must be culled. Exits non-zero on any
+// difference. usage: test-culling [runs] (default 200)
+
+static constexpr size_t N = 40 * FrustumCuller::GRAIN + 123;
+static constexpr int THREADS = 16;
+static constexpr size_t PROBES = 5000;
+static constexpr int DIRECTIONS = 48;           // sphere points projected per probe
+static constexpr float WIDTH = 1280.0f, HEIGHT = 720.0f;
+static constexpr float GUARD_PIXELS = 2.0f;     // as Renderer::GUARD_PIXELS
+static const float LOW_PASS_PIXELS = 3.0f * std::sqrt(0.3f);   // 3 sigma of the shader's 0.3 px^2 dilation
+static constexpr float EPS = 1e-3f;
+
+// Checks the last cull() of probes (view: view-space centers) by projecting
+// them; returns the probes culled though they reach the viewport and those
+// kept though far outside.
+static std::pair<int, int> brute_force(const FrustumCuller& culler, const std::vector<Eigen::Vector3f>& view,
+                                       const std::vector<float>& radius, float radius_scale,
+                                       const Eigen::Matrix4f& projmat, const Eigen::Matrix4f& viewmat,
+                                       const Eigen::Vector2f& tanxy, const Eigen::Vector2f& widen,
+                                       const std::vector<Eigen::Vector3f>& directions, std::vector<uint8_t>& kept) {
+
+    const Eigen::Matrix4f M = projmat * viewmat;
+    const Eigen::Matrix4f to_world = viewmat.inverse();
+    const Eigen::Vector2f band(1.0f + 2.0f * LOW_PASS_PIXELS / WIDTH, 1.0f + 2.0f * LOW_PASS_PIXELS / HEIGHT);
+    std::fill(kept.begin(), kept.end(), 0);
+    for (uint32_t i : culler.visible()) kept[i] = 1;
+
+    int missing = 0, leaked = 0;
+    for (size_t i = 0; i < view.size(); ++i) {
+        const Eigen::Vector3f world = (to_world * view[i].homogeneous()).head<3>();
+        const float r = radius_scale * radius[i];
+        const Eigen::Vector4f clip = M * world.homogeneous();
+        const Eigen::Vector3f ndc = clip.head<3>() / clip.w();
+
+        // drawn by the shader and reaching the viewport at the center or a sphere point
+        bool reaches = false;
+        if (clip.w() > EPS && (ndc.array().abs() < FrustumCuller::CLIP_BOUND - EPS).all()) {
+            for (int k = -1; k < DIRECTIONS && !reaches; ++k) {
+                const Eigen::Vector3f point = k < 0 ? world : Eigen::Vector3f(world + r * directions[k]);
+                const Eigen::Vector4f q = M * point.homogeneous();
+                if (q.w() <= EPS) continue;
+                reaches = std::abs(q.x() / q.w()) <= band.x() && std::abs(q.y() / q.w()) <= band.y();
+            }
+        }
+
+        // off the depth range, or twice the sphere beyond a side widened by twice the guard
+        const float depth = -view[i].z();
+        bool outside = clip.w() < -EPS || (clip.w() > EPS && std::abs(ndc.z()) > FrustumCuller::CLIP_BOUND + EPS);
+        for (int axis = 0; axis < 2 && !outside; ++axis) {
+            const float t = tanxy[axis] * (1.0f + 2.0f * widen[axis]);
+            const float side = std::abs(view[i][axis]);
+            outside = (side - t * depth) / std::sqrt(1.0f + t * t) > 2.0f * r + EPS;
+        }
+
+        missing += reaches && !kept[i];
+        leaked += outside && kept[i];
+    }
+    return { missing, leaked };
+}
+
+int main(int argc, char** argv) {
+
+    const int runs = argc > 1 ? std::stoi(argv[1]) : 200;
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> coord(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<float> xyz(3 * N), radius(N);
+    for (size_t i = 0; i < N; ++i) {
+        for (int k = 0; k < 3; ++k) xyz[3 * i + k] = coord(rng);
+        radius[i] = 0.05f * unit(rng);
+    }
+
+    // as many threads as THREADS even on machines with fewer cores
+    tbb::global_control threads(tbb::global_control::max_allowed_parallelism, THREADS);
+    FrustumCuller reference, culler;
+    tbb::task_arena serial(1), parallel(THREADS);
+    std::vector<uint32_t> order(N), expected, compacted(N);
+    std::vector<uint8_t> kept(N);
+    int failures = 0;
+
+    // directions spread evenly over the sphere
+    std::vector<Eigen::Vector3f> directions(DIRECTIONS);
+    for (int k = 0; k < DIRECTIONS; ++k) {
+        const float z = 1.0f - (2.0f * k + 1.0f) / DIRECTIONS, ring = std::sqrt(1.0f - z * z);
+        const float phi = k * float(M_PI) * (3.0f - std::sqrt(5.0f));
+        directions[k] = Eigen::Vector3f(ring * std::cos(phi), ring * std::sin(phi), z);
+    }
+    std::vector<Eigen::Vector3f> probe_view(PROBES);
+    std::vector<float> probe_xyz(3 * PROBES), probe_radius(PROBES);
+    std::vector<uint8_t> probe_kept(PROBES);
+
+    for (int run = 0; run < runs; ++run) {
+        // a camera on a sphere around the scene, looking near its center
+        const float azimuth = 2.0f * float(M_PI) * unit(rng), height = 20.0f * unit(rng) - 10.0f;
+        const Eigen::Vector3f eye(25.0f * std::cos(azimuth), 25.0f * std::sin(azimuth), height);
+        const Eigen::Vector3f target(coord(rng) * 0.3f, coord(rng) * 0.3f, coord(rng) * 0.3f);
+        const Eigen::Vector3f forward = (target - eye).normalized();
+        const Eigen::Vector3f right = forward.cross(Eigen::Vector3f::UnitZ()).normalized();
+        const Eigen::Vector3f up = right.cross(forward);
+        Eigen::Matrix4f viewmat = Eigen::Matrix4f::Identity();
+        viewmat.block<1, 3>(0, 0) = right.transpose();
+        viewmat.block<1, 3>(1, 0) = up.transpose();
+        viewmat.block<1, 3>(2, 0) = -forward.transpose();
+        viewmat.block<3, 1>(0, 3) = -viewmat.block<3, 3>(0, 0) * eye;
+
+        const float fov = 20.0f + 60.0f * unit(rng);
+        const float tan_half = std::tan(fov / 360.0f * float(M_PI)), znear = 0.1f, zfar = 100.0f;
+        const Eigen::Vector2f tanxy(tan_half * WIDTH / HEIGHT, tan_half);
+        Eigen::Matrix4f projmat = Eigen::Matrix4f::Zero();
+        projmat(0, 0) = 1.0f / tanxy.x();
+        projmat(1, 1) = 1.0f / tanxy.y();
+        projmat(2, 2) = -(zfar + znear) / (zfar - znear);
+        projmat(2, 3) = -2.0f * zfar * znear / (zfar - znear);
+        projmat(3, 2) = -1.0f;
+        const FrustumCuller::Planes planes = FrustumCuller::planes(projmat, viewmat);
+
+        const size_t count = serial.execute([&]() { return reference.cull(xyz.data(), radius.data(), N, 3.0f, planes); });
+        const size_t visible = parallel.execute([&]() { return culler.cull(xyz.data(), radius.data(), N, 3.0f, planes); });
+        bool ok = visible == count && culler.visible() == reference.visible();
+
+        std::iota(order.begin(), order.end(), 0u);
+        std::shuffle(order.begin(), order.end(), rng);
+        std::fill(kept.begin(), kept.end(), 0);
+        for (uint32_t i : reference.visible()) kept[i] = 1;
+        expected.clear();
+        for (uint32_t i : order) {
+            if (kept[i]) expected.push_back(i);
+        }
+        const size_t survivors = parallel.execute([&]() { return culler.compact(order.data(), N, compacted.data()); });
+        ok &= survivors == expected.size() && std::equal(expected.begin(), expected.end(), compacted.begin());
+
+        // probes around the sides, near and far, a quarter of them points; guard
+        // band as the renderer sets it, with focal the pixels per unit tangent
+        const float focal = HEIGHT / (2.0f * tanxy.y());
+        const Eigen::Vector2f widen = GUARD_PIXELS / (focal * tanxy.array());
+        const FrustumCuller::Planes guarded = FrustumCuller::planes(projmat, viewmat, widen);
+        const Eigen::Matrix4f to_world = viewmat.inverse();
+        for (size_t i = 0; i < PROBES; ++i) {
+            const float depth = -2.0f + 1.1f * zfar * unit(rng);
+            const float x = (2.0f * unit(rng) - 1.0f) * 1.6f, y = (2.0f * unit(rng) - 1.0f) * 1.6f;
+            probe_view[i] = Eigen::Vector3f(x * tanxy.x() * depth, y * tanxy.y() * depth, -depth);
+            probe_radius[i] = i % 4 == 0 ? 0.0f : 1e-3f * std::pow(1e3f, unit(rng));
+            const Eigen::Vector3f world = (to_world * probe_view[i].homogeneous()).head<3>();
+            for (int k = 0; k < 3; ++k) probe_xyz[3 * i + k] = world[k];
+        }
+        parallel.execute([&]() { return culler.cull(probe_xyz.data(), probe_radius.data(), PROBES, 3.0f, guarded); });
+        const std::pair<int, int> wrong = brute_force(culler, probe_view, probe_radius, 3.0f, projmat, viewmat, tanxy,
+                                                      widen, directions, probe_kept);
+        ok &= wrong.first == 0 && wrong.second == 0;
+
+        if (!ok) {
+            ++failures;
+            printf("run %d: cull %zu / %zu visible, compact %zu / %zu, probes %d reaching culled, %d outside kept: FAILED\n",
+                   run, visible, count, survivors, expected.size(), wrong.first, wrong.second);
+        }
+    }
+    printf("%d of %d runs differ from the serial reference or the projected probes\n", failures, runs);
+    return failures ? 1 : 0;
+}
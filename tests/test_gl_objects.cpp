@@ -0,0 +1,141 @@
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <liteviz/headless.h>
+#include <liteviz/renderer.h>
+#include <liteviz/dataloader.h>
+
+// The renderer must not create GL objects per frame: renders FRAMES frames
+// of a turning camera in each sorting and drawing mode and checks that the
+// number of live buffers, textures, vertex arrays, framebuffers,
+// renderbuffers, queries, programs and fence syncs (liveSyncs(), they have
+// no names to probe) is the same after them as after the first WARMUP
+// frames, that no GL error was raised, and that the renderer leaves none
+// behind once destroyed.
+// Also checks that the index ring is persistently mapped on a GL 4.4+ context.
+// Exits non-zero on a leak.
+// usage: test-gl-objects [frames] (default 10000)
+
+static constexpr int SIZE = 64;
+static constexpr GLuint MAX_NAME = 1 << 14;     // names probed per object type
+static constexpr int WARMUP = 8;                // frames to fill every fence ring
+
+struct Mode {
+    const char* name;
+    bool        coherent;
+    bool        async;
+    bool        gpu;
+    bool        tiles;
+};
+
+// programs flagged for deletion are not counted, the driver may hold on to
+// them for a while after the last use
+static int live_objects() {
+    int count = 0;
+    for (GLuint name = 1; name < MAX_NAME; ++name) {
+        count += glIsBuffer(name) + glIsTexture(name) + glIsVertexArray(name) + glIsFramebuffer(name) +
+                 glIsRenderbuffer(name) + glIsQuery(name);
+        if (glIsProgram(name)) {
+            GLint deleted = GL_FALSE;
+            glGetProgramiv(name, GL_DELETE_STATUS, &deleted);
+            count += deleted == GL_FALSE;
+        }
+    }
+    return count + liveSyncs();
+}
+
+static bool run(const Mode& mode, const GaussianData& data, OffscreenTarget& target, int frames) {
+
+    std::string shader_path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+    Shader shader((shader_path + "/draw_splat.vert").c_str(), (shader_path + "/draw_splat.frag").c_str(), false,
+                  Renderer::shaderDefines(data));
+    Renderer renderer(data, &shader);
+    RenderConfig& config = renderer.config();
+    config.coherent_sort = mode.coherent;
+    config.async_sort = mode.async;
+    config.gpu_sort = mode.gpu;
+    config.tile_render = mode.tiles;
+
+    Viewport viewport(SIZE, SIZE);
+    viewport.frameBufferSize = Eigen::Vector2i(SIZE, SIZE);
+    auto frame = [&](int f) {
+        // swing back and forth around the scene, 5 units away
+        const Eigen::Matrix3f turn =
+            Eigen::AngleAxisf(0.2f * std::sin(f * 0.01f), Eigen::Vector3f::UnitY()).toRotationMatrix();
+        Eigen::Matrix4f pose = Eigen::Matrix4f::Identity();
+        pose.block<3, 3>(0, 0) = turn;
+        pose.block<3, 1>(0, 3) = turn * Eigen::Vector3f(0.0f, 0.0f, 5.0f);
+        viewport.setViewMatrix(pose);
+        target.bind();
+        glClear(GL_COLOR_BUFFER_BIT);
+        renderer.render(viewport);
+    };
+
+    // counted after a frame that starts with the GPU idle, so every fence
+    // of an earlier frame has passed and the readback rings hold the same
+    auto settled = [&](int f) {
+        glFinish();
+        frame(f);
+        glFinish();
+        return live_objects();
+    };
+
+    // the first frames create what the mode needs and fill the rings
+    for (int f = 0; f < WARMUP; ++f) frame(f);
+    const int before = settled(WARMUP);
+    for (int f = WARMUP + 1; f <= WARMUP + frames; ++f) frame(f);
+    const int after = settled(WARMUP + frames + 1);
+    const GLenum error = glGetError();
+
+    const bool ok = after == before && error == GL_NO_ERROR;
+    printf("%-10s objects after the first frame %d, after %d frames %d, GL error 0x%x: %s\n", mode.name, before,
+           frames, after, error, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char** argv) {
+
+    const int frames = argc > 1 ? std::stoi(argv[1]) : 10000;
+
+    HeadlessContext context;
+    if (!context.init()) {
+        fprintf(stderr, "Failed to init the offscreen context\n");
+        return 1;
+    }
+    printf("GL renderer: %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+    const Mode modes[] = {
+        { "coherent", true, false, false, false },
+        { "direct", false, false, false, false },
+        { "async", true, true, false, false },
+        { "gpu-sort", false, false, true, false },
+        { "tiles", true, false, false, true },
+    };
+
+    // the sort order streams through persistently mapped storage wherever GL 4.4 is there
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool passed = true;
+    {
+        StreamBuffer stream;
+        stream.map(1);
+        const bool ok = stream.persistent() == (major * 10 + minor >= 44);
+        printf("GL %d.%d, index ring %s: %s\n", major, minor, stream.persistent() ? "persistent" : "orphaned",
+               ok ? "ok" : "FAILED");
+        passed &= ok;
+    }
+
+    const GaussianData data = GaussianData::naive_data();
+    OffscreenTarget target(SIZE, SIZE);
+    const int initial = live_objects();
+    for (const Mode& mode : modes) {
+        passed &= run(mode, data, target, frames);
+        const int left = live_objects() - initial;
+        if (left != 0) {
+            printf("%-10s %d objects left after the renderer was destroyed: FAILED\n", mode.name, left);
+            passed = false;
+        }
+    }
+    return passed ? 0 : 1;
+}
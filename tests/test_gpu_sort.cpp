@@ -0,0 +1,135 @@
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <liteviz/headless.h>
+#include <liteviz/viewport.h>
+#include <liteviz/dataloader.h>
+#include <liteviz/culling.h>
+#include <liteviz/gpu_sorter.h>
+
+// GpuSorter's order and count against the CPU path it replaces, on a small
+// generated scene from views that keep every splat, some and none. For each
+// view the GPU order is read back and checked: a permutation of the splats,
+// the ones FrustumCuller keeps first, back to front by DepthSorter's KEY_32
+// keys, and visible() equal to the culler's count. The scene size is no
+// multiple of the radix and scan blocks, so partial blocks are covered.
+// Exits non-zero on any mismatch. Timings are in bench-gpu-sort.
+
+static constexpr int WIDTH = 320, HEIGHT = 180;
+static constexpr size_t N = 50000 + 37;
+
+// DepthSorter's KEY_32 key of a view-space z
+static uint32_t depth_key(float z) {
+    uint32_t u;
+    std::memcpy(&u, &z, sizeof(float));
+    return u ^ ((u >> 31) ? 0xFFFFFFFFu : 0x80000000u);
+}
+
+int main() {
+
+    HeadlessContext context;
+    if (!context.init()) {
+        fprintf(stderr, "Failed to init the offscreen context\n");
+        return 1;
+    }
+    printf("GL renderer: %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+    // splats scattered through [-10, 10]^3
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> coord(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    GaussianData data;
+    data.resize(N, 3);
+    data.attributes.setZero();
+    for (size_t i = 0; i < N; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            data.xyz(i, k) = coord(rng);
+            data.attributes(i, GaussianData::SCALE + k) = 0.01f + 0.1f * unit(rng);
+        }
+        data.attributes(i, GaussianData::ROT) = 1.0f;
+        data.attributes(i, GaussianData::OPACITY) = 1.0f;
+    }
+    std::vector<float> radius(N);
+    FrustumCuller::boundingRadii(data, 0, N, radius.data());
+    const float radius_scale = 3.0f;
+
+    GLuint ssbo_xyz;
+    glGenBuffers(1, &ssbo_xyz);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo_xyz);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, N * 3 * sizeof(float), data.xyz.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo_xyz);
+
+    Viewport viewport(WIDTH, HEIGHT);
+    viewport.frameBufferSize = Eigen::Vector2i(WIDTH, HEIGHT);
+    viewport.setFoV(60.0f);
+    const Eigen::Matrix4f projmat = viewport.getProjectionMatrix();
+    const Eigen::Vector2f widen = 2.0f * 2.0f / (2.0f * viewport.getFocal() * viewport.getTanXY().array());
+
+    // camera turned about the y axis, then placed at eye
+    struct View { const char* name; float turn; Eigen::Vector3f eye; };
+    const View views[] = {
+        { "outside", 0.0f, Eigen::Vector3f(0.0f, 0.0f, 40.0f) },
+        { "inside", 0.0f, Eigen::Vector3f(0.0f, 0.0f, 2.0f) },
+        { "turned", 1.2f, Eigen::Vector3f(3.0f, 1.0f, -4.0f) },
+        { "away", float(M_PI), Eigen::Vector3f(0.0f, 0.0f, 40.0f) },
+    };
+
+    GpuSorter gpu_sorter(N);
+    gpu_sorter.uploadRadii(radius.data(), 0, N);
+    FrustumCuller culler;
+    std::vector<uint32_t> gpu_order(N);
+    std::vector<uint8_t> seen(N), kept(N);
+    bool passed = true;
+    for (const View& view : views) {
+        Eigen::Matrix4f pose = Eigen::Matrix4f::Identity();
+        pose.block<3, 3>(0, 0) = Eigen::AngleAxisf(view.turn, Eigen::Vector3f::UnitY()).toRotationMatrix();
+        pose.block<3, 1>(0, 3) = view.eye;
+        viewport.setViewMatrix(pose);
+        const Eigen::Matrix4f viewmat = viewport.getViewMatrix();
+        const FrustumCuller::Planes planes = FrustumCuller::planes(projmat, viewmat, widen);
+        const size_t visible = culler.cull(data.xyz.data(), radius.data(), N, radius_scale, planes);
+
+        // visible() reads the count of an earlier sort once it is done: sort twice
+        gpu_sorter.sort(N, viewmat, &planes, radius_scale, 1);
+        glFinish();
+        gpu_sorter.sort(N, viewmat, &planes, radius_scale, 1);
+        glFinish();
+        const bool counted = gpu_sorter.visible() == visible;
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpu_sorter.order());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, N * sizeof(uint32_t), gpu_order.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // a permutation of the splats
+        std::fill(seen.begin(), seen.end(), 0);
+        bool permuted = true;
+        for (uint32_t i : gpu_order) {
+            permuted &= i < N && !seen[i];
+            if (i < N) seen[i] = 1;
+        }
+        // the culler's survivors first, back to front by the CPU's keys
+        std::fill(kept.begin(), kept.end(), 0);
+        for (uint32_t i : culler.visible()) kept[i] = 1;
+        const Eigen::RowVector3f depth_row = viewmat.row(2).head<3>();
+        bool ordered = permuted;
+        for (size_t k = 0; ordered && k < visible; ++k) {
+            ordered &= kept[gpu_order[k]] != 0;
+            if (k > 0) {
+                ordered &= depth_key(depth_row.dot(data.xyz.row(gpu_order[k - 1]))) <=
+                           depth_key(depth_row.dot(data.xyz.row(gpu_order[k])));
+            }
+        }
+
+        const bool ok = permuted && ordered && counted && glGetError() == GL_NO_ERROR;
+        printf("%-8s visible %6zu of %zu, gpu count %6zu, permutation %s, order %s: %s\n", view.name, visible, N,
+               gpu_sorter.visible(), permuted ? "yes" : "NO", ordered ? "yes" : "NO", ok ? "ok" : "FAILED");
+        passed &= ok;
+    }
+
+    glDeleteBuffers(1, &ssbo_xyz);
+    return passed ? 0 : 1;
+}
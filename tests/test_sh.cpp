@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <liteviz/dataloader.h>
+#include <liteviz/sh.h>
+
+// eval_sh_colors() and SHPlanes::eval() against the scalar reference
+// eval_sh(): scenes of SH degree 0 to 3, each colored at every degree up to
+// its own, with sizes around multiples of SH_RUN so partial blocks show, and
+// eval_sh_colors() also from a first splat inside a block. A color may be off
+// by TOLERANCE, relative to the reference where that exceeds 1, a few float
+// roundings at the 16 terms of degree 3. Exits non-zero on a larger error.
+
+static constexpr float TOLERANCE = 1e-5f;
+
+static const size_t SIZES[] = { 1, SH_RUN - 1, SH_RUN, SH_RUN + 1, 7 * SH_RUN + 13, 1000 * SH_RUN + 37 };
+
+static GaussianData random_data(size_t N, int degree, std::mt19937& rng) {
+    std::uniform_real_distribution<float> coord(-10.0f, 10.0f);
+    std::normal_distribution<float> coefficient(0.0f, 0.5f);
+    GaussianData data;
+    data.resize(N, 3 * (degree + 1) * (degree + 1));
+    for (size_t i = 0; i < N; ++i) {
+        for (int k = 0; k < 3; ++k) data.xyz(i, k) = coord(rng);
+    }
+    data.attributes.setZero();
+    auto sh = data.sh();
+    for (Eigen::Index i = 0; i < sh.rows(); ++i) {
+        for (Eigen::Index k = 0; k < sh.cols(); ++k) sh(i, k) = coefficient(rng);
+    }
+    return data;
+}
+
+// largest difference of rgb to the reference colors of splats [begin, begin + n)
+static float max_error(const std::vector<float>& rgb, const std::vector<float>& reference, size_t begin, size_t n) {
+    float error = 0.0f;
+    for (size_t k = 0; k < 3 * n; ++k) {
+        const float ref = reference[3 * begin + k];
+        error = std::max(error, std::abs(rgb[k] - ref) / std::max(1.0f, std::abs(ref)));
+    }
+    return error;
+}
+
+int main() {
+
+    std::mt19937 rng(5);
+    const Eigen::Vector3f eye(3.0f, -25.0f, 6.0f);
+    bool passed = true;
+
+    for (int data_degree = 0; data_degree <= 3; ++data_degree) {
+        for (size_t N : SIZES) {
+            const GaussianData data = random_data(N, data_degree, rng);
+            const int dim = data.sh_dim();
+            const SHPlanes planes(data);
+            std::vector<float> reference(3 * N), rgb(3 * N);
+
+            for (int degree = 0; degree <= data_degree; ++degree) {
+                for (size_t i = 0; i < N; ++i) {
+                    const Eigen::Vector3f color = eval_sh(&data.attributes(i, GaussianData::SH), dim, degree,
+                                                          (data.xyz.row(i).transpose() - eye).normalized());
+                    std::copy_n(color.data(), 3, &reference[3 * i]);
+                }
+
+                // a color left unwritten keeps this and shows as a huge error
+                std::fill(rgb.begin(), rgb.end(), 1e30f);
+                eval_sh_colors(data, 0, N, eye, degree, rgb.data());
+                const float rows = max_error(rgb, reference, 0, N);
+
+                const size_t begin = std::min<size_t>(N - 1, SH_RUN / 2 + 3);
+                std::fill(rgb.begin(), rgb.end(), 1e30f);
+                eval_sh_colors(data, begin, N, eye, degree, rgb.data());
+                const float offset = max_error(rgb, reference, begin, N - begin);
+
+                std::fill(rgb.begin(), rgb.end(), 1e30f);
+                planes.eval(eye, degree, rgb.data());
+                const float soa = max_error(rgb, reference, 0, N);
+
+                const bool ok = rows <= TOLERANCE && offset <= TOLERANCE && soa <= TOLERANCE;
+                if (!ok) {
+                    printf("data degree %d, %zu splats, degree %d: rows %.2e, from splat %zu %.2e, SoA %.2e: FAILED\n",
+                           data_degree, N, degree, rows, begin, offset, soa);
+                }
+                passed &= ok;
+            }
+        }
+    }
+
+    printf("batch SH colors %s eval_sh() within %.0e\n", passed ? "match" : "do NOT match", TOLERANCE);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <liteviz/sort_worker.h>
+
+// SortWorker across restarts: each run starts the worker on a scene, leaves a
+// finished ordering unacquired and a request pending, stops it, starts it on
+// a larger scene and acquires. Every ordering acquired after the restart must
+// come from a request of the new run, a permutation of its splats; one left
+// from the last run shows by its frame and size. Exits non-zero on any.
+// usage: test-sort-worker [runs] (default 50)
+
+static constexpr size_t N = 20000;
+static constexpr uint64_t RUN_FRAMES = 1000;   // frame numbers of each run start here
+
+static GaussianData::Positions random_positions(size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<float> coord(-10.0f, 10.0f);
+    GaussianData::Positions xyz(count, 3);
+    for (size_t i = 0; i < count; ++i) {
+        for (int k = 0; k < 3; ++k) xyz(i, k) = coord(rng);
+    }
+    return xyz;
+}
+
+static SortWorker::Request request(size_t count, uint64_t frame) {
+    SortWorker::Request request;
+    request.viewmat = Eigen::Matrix4f::Identity();
+    request.viewmat(2, 3) = -30.0f;
+    request.frame = frame;
+    request.coherent = false;
+    request.count = count;
+    return request;
+}
+
+int main(int argc, char** argv) {
+
+    const int runs = argc > 1 ? std::stoi(argv[1]) : 50;
+
+    std::mt19937 rng(5);
+    SortWorker worker;
+    std::vector<GaussianData::Positions> scenes(2);
+    std::vector<float> radius(2 * N, 0.0f);
+    std::vector<uint8_t> seen;
+    int failures = 0;
+
+    for (int run = 0; run < runs; ++run) {
+        // the old scene, with an ordering finished but not acquired
+        scenes[0] = random_positions(N, rng);
+        worker.start(scenes[0], radius.data());
+        worker.submit(request(N, run * RUN_FRAMES));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        worker.submit(request(N, run * RUN_FRAMES + 1));
+        worker.stop();
+
+        // a larger scene, so an old request is still in bounds
+        const size_t count = N + 1 + run;
+        scenes[1] = random_positions(count, rng);
+        const uint64_t first = (run + runs) * RUN_FRAMES;
+        worker.start(scenes[1], radius.data());
+
+        bool ok = true, acquired = false;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        for (uint64_t frame = first; !acquired && std::chrono::steady_clock::now() < deadline; ++frame) {
+            worker.submit(request(count, frame));
+            acquired = worker.acquire(frame);
+            if (!acquired) {
+                ok &= !worker.hasResult();
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        const SortWorker::Result& result = worker.latest();
+        ok &= acquired && result.frame >= first && result.index.size() == count;
+        if (ok) {
+            seen.assign(count, 0);
+            for (uint32_t i : result.index) {
+                ok &= i < count && !seen[i];
+                if (i < count) seen[i] = 1;
+            }
+        }
+        worker.stop();
+
+        if (!ok) {
+            ++failures;
+            printf("run %d: acquired %d, frame %llu (run starts at %llu), %zu of %zu splats: FAILED\n", run,
+                   int(acquired), (unsigned long long)result.frame, (unsigned long long)first,
+                   result.index.size(), count);
+        }
+    }
+    printf("%d of %d restarts acquired an ordering of the last run\n", failures, runs);
+    return failures ? 1 : 0;
+}
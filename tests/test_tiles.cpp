@@ -0,0 +1,121 @@
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <liteviz/headless.h>
+#include <liteviz/renderer.h>
+#include <liteviz/dataloader.h>
+
+// The compute tile renderer (RenderConfig::tile_render) against the quad
+// rasterizer, on a small generated scene from a few views, in each render
+// mode. The two blend in different order and precision (see bench-tiles), so
+// the images are compared loosely: the mean difference per channel has to
+// stay under MAX_MEAN levels and the share of pixels with a channel more than
+// 8 levels apart under MAX_LARGE. Exits non-zero when a mode goes over.
+
+static constexpr int SIZE = 256;
+static constexpr size_t N = 20000;
+static constexpr double MAX_MEAN = 0.5;         // levels of 255
+static constexpr double MAX_LARGE = 0.005;      // share of pixels
+
+// clusters of splats within a few units of the origin, at SH degree 3
+static GaussianData random_scene(std::mt19937& rng) {
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const int sh_dim = 48;
+    GaussianData data;
+    data.resize(N, sh_dim);
+    std::vector<Eigen::Vector3f> centers(32);
+    for (Eigen::Vector3f& center : centers) center = 1.5f * Eigen::Vector3f(normal(rng), normal(rng), normal(rng));
+    for (size_t i = 0; i < N; ++i) {
+        const Eigen::Vector3f pos = centers[i % centers.size()] + 0.3f * Eigen::Vector3f(normal(rng), normal(rng), normal(rng));
+        data.xyz.row(i) = pos.transpose();
+        float* attr = &data.attributes(i, 0);
+        Eigen::Map<Eigen::Vector4f>(attr + GaussianData::ROT) =
+            Eigen::Vector4f(normal(rng), normal(rng), normal(rng), normal(rng)).normalized();
+        for (int k = 0; k < 3; ++k) attr[GaussianData::SCALE + k] = 0.01f + 0.04f * unit(rng);
+        attr[GaussianData::OPACITY] = 0.2f + 0.8f * unit(rng);
+        for (int k = 0; k < sh_dim; ++k) attr[GaussianData::SH + k] = (k < 3 ? 1.0f : 0.2f) * normal(rng);
+    }
+    return data;
+}
+
+int main() {
+
+    HeadlessContext context;
+    if (!context.init()) {
+        fprintf(stderr, "Failed to init the offscreen context\n");
+        return 1;
+    }
+    printf("GL renderer: %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+    std::mt19937 rng(7);
+    const GaussianData data = random_scene(rng);
+    std::string shader_path = std::string(RESOURCE_DIR) + "/liteviz/shaders";
+    Shader shader((shader_path + "/draw_splat.vert").c_str(), (shader_path + "/draw_splat.frag").c_str(), false,
+                  Renderer::shaderDefines(data));
+    Renderer renderer(data, &shader);
+    RenderConfig& config = renderer.config();
+    config.async_sort = false;
+    config.color_cache = false;
+
+    OffscreenTarget target(SIZE, SIZE);
+    Viewport viewport(SIZE, SIZE);
+    viewport.frameBufferSize = Eigen::Vector2i(SIZE, SIZE);
+
+    auto frame = [&](float angle, bool tiles, std::vector<uint8_t>& rgba) {
+        // around the scene, 8 units away
+        const Eigen::Matrix3f turn = Eigen::AngleAxisf(angle, Eigen::Vector3f::UnitY()).toRotationMatrix();
+        Eigen::Matrix4f pose = Eigen::Matrix4f::Identity();
+        pose.block<3, 3>(0, 0) = turn;
+        pose.block<3, 1>(0, 3) = turn * Eigen::Vector3f(0.0f, 0.0f, 8.0f);
+        viewport.setViewMatrix(pose);
+        config.tile_render = tiles;
+        target.bind();
+        const Eigen::Vector4f clear_color(0.0f, 0.0f, 0.0f, 1.0f);
+        glClearBufferfv(GL_COLOR, 0, clear_color.data());
+        renderer.render(viewport);
+        rgba.resize(size_t(4) * SIZE * SIZE);
+        glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    };
+
+    struct Mode { const char* name; RenderConfig::RenderMode mode; };
+    const Mode modes[] = {
+        { "sh3", RenderConfig::COLOR_SH_3 }, { "sh0", RenderConfig::COLOR_SH_0 },
+        { "depth", RenderConfig::DEPTH }, { "ball", RenderConfig::GAUSS_BALL },
+    };
+    const float angles[] = { 0.0f, 1.0f, 2.5f };
+
+    bool passed = glGetError() == GL_NO_ERROR;
+    std::vector<uint8_t> quads, tiles;
+    for (const Mode& mode : modes) {
+        config.render_mode = mode.mode;
+        double sum_diff = 0.0;
+        size_t large = 0, covered = 0;
+        for (float angle : angles) {
+            frame(angle, false, quads);
+            frame(angle, true, tiles);
+            for (size_t p = 0; p < size_t(SIZE) * SIZE; ++p) {
+                int pixel_diff = 0;
+                for (int c = 0; c < 3; ++c) {
+                    const int d = std::abs(int(quads[4 * p + c]) - int(tiles[4 * p + c]));
+                    pixel_diff = std::max(pixel_diff, d);
+                    sum_diff += d;
+                }
+                large += pixel_diff > 8;
+                covered += quads[4 * p] + quads[4 * p + 1] + quads[4 * p + 2] > 0;
+            }
+        }
+        const double pixels = double(SIZE) * SIZE * (sizeof(angles) / sizeof(angles[0]));
+        const double mean = sum_diff / (3.0 * pixels);
+        const double share = large / pixels;
+        // an empty image would compare equal to anything
+        const bool ok = mean <= MAX_MEAN && share <= MAX_LARGE && covered > pixels / 10 && glGetError() == GL_NO_ERROR;
+        printf("%-6s covered %5.1f%%, mean diff %.3f (max %.1f), > 8 levels %.2f%% (max %.1f%%): %s\n", mode.name,
+               100.0 * covered / pixels, mean, MAX_MEAN, 100.0 * share, 100.0 * MAX_LARGE, ok ? "ok" : "FAILED");
+        passed &= ok;
+    }
+    return passed ? 0 : 1;
+}